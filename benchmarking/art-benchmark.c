@@ -0,0 +1,51 @@
+/**
+ * @file art-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "adaptive-radix-tree.h"
+#include "benchmark.h"
+
+ARTree tree;
+
+// the uint32_t values are encoded as big-endian keys, the value itself is stored as data
+void art_add_wrapper(const void* data) {
+  unsigned char key[4];
+  art_key_from_u32(*(const uint32_t*)data, key);
+  art_add(tree, key, sizeof(key), data);
+}
+
+bool art_search_wrapper(const void* data) {
+  unsigned char key[4];
+  art_key_from_u32(*(const uint32_t*)data, key);
+  return art_find_data(tree, key, sizeof(key)) != NULL;
+}
+
+void art_remove_wrapper(const void* data) {
+  unsigned char key[4];
+  art_key_from_u32(*(const uint32_t*)data, key);
+  art_remove(tree, key, sizeof(key));
+}
+
+bool art_verify_wrapper() { return art_is_valid(tree); }
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  tree = art_new(BENCHMARK_DATA_SIZE, benchmark_delete);
+
+  benchmark(argv[3], atoi(argv[1]), atoi(argv[2]), &art_add_wrapper, &art_remove_wrapper, &art_search_wrapper,
+            &art_verify_wrapper);
+
+  art_delete(tree);
+  return EXIT_SUCCESS;
+}
@@ -8,31 +8,70 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "avl-tree.h"
 #include "benchmark.h"
 
 AVLTree tree;
+AVLTree edge_tree;
 
 void avl_add_wrapper(const void* data) { avl_add(tree, data); }
 
+void avl_add_edge_wrapper(const void* data) { avl_add_edge(edge_tree, false, data); }
+
 bool avl_search_wrapper(const void* data) { return avl_find_data(tree, data) != NULL; }
 
 void avl_remove_wrapper(const void* data) { avl_remove(tree, data); }
 
 bool avl_verify_wrapper() { return avl_is_valid(tree); }
 
+size_t avl_rotations_wrapper(void) { return avl_get_rotations(tree); }
+
+size_t avl_search_batch_wrapper(const void* data, size_t count, void** results) {
+  return avl_find_batch(tree, data, count, results);
+}
+
 int main(int argc, char* argv[]) {
-  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
-      atoi(argv[2]) > atoi(argv[1])) {
-    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix>\n", argv[0]);
+  bool batch = argc == 5 && strcmp(argv[4], "--batch") == 0;
+  bool sequential = argc == 5 && strcmp(argv[4], "--sequential") == 0;
+  bool rotations = argc == 5 && strcmp(argv[4], "--rotations") == 0;
+  BenchmarkWorkload workload;
+  bool mixed =
+      argc >= 5 && strcmp(argv[4], "--workload") == 0 && benchmark_parse_workload(argc - 5, argv + 5, &workload);
+  if ((argc != 4 && !batch && !sequential && !rotations && !mixed) || atoi(argv[1]) <= 0 ||
+      (atoi(argv[1]) >= BENCHMARK_MAX_NODES && !mixed) || atoi(argv[2]) <= 0 || atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr,
+            "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix> [--batch | --sequential | --rotations | "
+            "--workload <distribution> <record_size> <read_percent> <insert_percent> [seed]]\n",
+            argv[0]);
     return EXIT_FAILURE;
   }
 
-  tree = avl_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+  AVLAllocator allocator = {benchmark_alloc, benchmark_free, NULL};
+  if (mixed) {
+    tree = avl_new_with_allocator(workload.record_size, benchmark_workload_compare, benchmark_delete, NULL, &allocator);
+  } else {
+    tree = avl_new_with_allocator(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete, NULL, &allocator);
+  }
 
-  benchmark(argv[3], atoi(argv[1]), atoi(argv[2]), &avl_add_wrapper, &avl_remove_wrapper, &avl_search_wrapper,
-            &avl_verify_wrapper);
+  if (sequential) {
+    edge_tree = avl_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+    benchmark_sequential(argv[3], atoi(argv[1]), atoi(argv[2]), &avl_add_wrapper, &avl_add_edge_wrapper);
+    avl_delete(edge_tree);
+  } else if (rotations) {
+    benchmark_rotations(argv[3], atoi(argv[1]), atoi(argv[2]), &avl_add_wrapper, &avl_remove_wrapper,
+                        &avl_rotations_wrapper);
+  } else if (mixed) {
+    benchmark_workload(argv[3], atoi(argv[1]), atoi(argv[2]), &workload, &avl_add_wrapper, &avl_remove_wrapper,
+                       &avl_search_wrapper);
+  } else if (batch) {
+    benchmark_batch(argv[3], atoi(argv[1]), atoi(argv[2]), &avl_add_wrapper, &avl_search_wrapper,
+                    &avl_search_batch_wrapper);
+  } else {
+    benchmark(argv[3], atoi(argv[1]), atoi(argv[2]), &avl_add_wrapper, &avl_remove_wrapper, &avl_search_wrapper,
+              &avl_verify_wrapper);
+  }
 
   avl_delete(tree);
   return EXIT_SUCCESS;
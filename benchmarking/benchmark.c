@@ -8,15 +8,23 @@
 #include "benchmark.h"
 
 #include <assert.h>
+#include <malloc.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 void benchmark_delete(void* data) { return; }
 
+static _Thread_local uint64_t comparisons;  // calls to benchmark_compare, read by benchmark_sequential
+
 int benchmark_compare(const void* a, const void* b) {
+  comparisons++;
   uint32_t int_a = *(uint32_t*)a;
   uint32_t int_b = *(uint32_t*)b;
   if (int_a < int_b) return -1;
@@ -24,6 +32,107 @@ int benchmark_compare(const void* a, const void* b) {
   return 0;
 }
 
+// Allocations made through benchmark_alloc, the counts and the peak start over with every phase of benchmark()
+static struct {
+  size_t allocations;
+  size_t frees;
+  size_t bytes;  // usable sizes of the blocks still allocated, malloc rounding included
+  size_t peak_bytes;
+} memory;
+
+// Sizes are read back from malloc rather than stored in front of each block, which would add to the RSS measured
+void* benchmark_alloc(void* ctx, size_t size) {
+  void* block = malloc(size);
+  if (!block) return NULL;
+  memory.allocations++;
+  memory.bytes += malloc_usable_size(block);
+  if (memory.bytes > memory.peak_bytes) memory.peak_bytes = memory.bytes;
+  return block;
+}
+
+void benchmark_free(void* ctx, void* ptr) {
+  if (!ptr) return;
+  memory.frees++;
+  memory.bytes -= malloc_usable_size(ptr);
+  free(ptr);
+}
+
+// Resident set size in bytes, 0 where /proc is not available
+static size_t benchmark_rss(void) {
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+  unsigned long size, resident = 0;
+  if (fscanf(statm, "%lu %lu", &size, &resident) != 2) resident = 0;
+  fclose(statm);
+  return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+// Highest resident set size in bytes since the last benchmark_reset_memory, or since the process started on kernels
+// that cannot reset it
+static size_t benchmark_peak_rss(void) {
+  FILE* status = fopen("/proc/self/status", "r");
+  if (!status) return 0;
+  char line[128];
+  unsigned long peak = 0;
+  while (fgets(line, sizeof(line), status)) {
+    if (sscanf(line, "VmHWM: %lu kB", &peak) == 1) break;
+  }
+  fclose(status);
+  return peak * 1024;
+}
+
+static void benchmark_reset_memory(void) {
+  memory.allocations = 0;
+  memory.frees = 0;
+  memory.peak_bytes = memory.bytes;
+  FILE* clear_refs = fopen("/proc/self/clear_refs", "w");
+  if (clear_refs) {
+    fputs("5", clear_refs);  // resets VmHWM to the current RSS
+    fclose(clear_refs);
+  }
+}
+
+static void benchmark_write_memory(FILE* file, const char* phase, uint32_t elements) {
+  double per_element = elements ? (double)memory.bytes / elements : 0;
+  fprintf(file, "%s,%u,%zu,%zu,%zu,%f,%zu,%zu,%zu\n", phase, elements, memory.allocations, memory.frees, memory.bytes,
+          per_element, memory.peak_bytes, benchmark_rss(), benchmark_peak_rss());
+}
+
+#define ZIPF_THETA 0.99
+
+// YCSB's Zipfian generator, rank 0 is the most popular and theta close to 1 makes a few ranks take most draws
+// see: Gray et al., "Quickly Generating Billion-Record Synthetic Databases" (1994)
+struct zipf {
+  uint64_t n;
+  double theta;
+  double alpha;
+  double zeta_n;
+  double eta;
+};
+
+static void zipf_init(struct zipf* zipf, uint64_t n, double theta) {
+  double zeta_n = 0;
+  for (uint64_t i = 1; i <= n; i++) {
+    zeta_n += 1.0 / pow(i, theta);
+  }
+  double zeta_2 = 1.0 + pow(0.5, theta);
+
+  zipf->n = n;
+  zipf->theta = theta;
+  zipf->alpha = 1.0 / (1.0 - theta);
+  zipf->zeta_n = zeta_n;
+  zipf->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta_2 / zeta_n);
+}
+
+// u is uniform in [0, 1)
+static uint64_t zipf_next(struct zipf* zipf, double u) {
+  double uz = u * zipf->zeta_n;
+  if (uz < 1.0) return 0;
+  if (uz < 1.0 + pow(0.5, zipf->theta)) return 1;
+  uint64_t rank = (uint64_t)(zipf->n * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+  return rank < zipf->n ? rank : zipf->n - 1;
+}
+
 int benchmark(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
               void remove(const void*), bool search(const void*), bool verify()) {
   char add_filename[256];
@@ -50,12 +159,30 @@ int benchmark(char* output_file_prefix, int number_of_nodes, int batch_size, voi
     return EXIT_FAILURE;
   }
 
+  char zipf_filename[256];
+  snprintf(zipf_filename, sizeof(zipf_filename), "%s_zipf.csv", output_file_prefix);
+  FILE* file_zipf = fopen(zipf_filename, "ax");
+  if (!file_zipf) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", zipf_filename);
+    return EXIT_FAILURE;
+  }
+
+  char memory_filename[256];
+  snprintf(memory_filename, sizeof(memory_filename), "%s_memory.csv", output_file_prefix);
+  FILE* file_memory = fopen(memory_filename, "ax");
+  if (!file_memory) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", memory_filename);
+    return EXIT_FAILURE;
+  }
+
   srand(time(NULL));  // flawfinder: ignore
 
   uint32_t a = (rand() | 1) % BENCHMARK_MAX_NODES;  // 2 ** 20 MAX
   uint32_t b = rand() % BENCHMARK_MAX_NODES;
   uint32_t N = number_of_nodes;
 
+  size_t rss_before = benchmark_rss();
+  benchmark_reset_memory();
   for (uint32_t x = 0; x < N; x += batch_size) {
     uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
     printf("\rAdd and Search Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
@@ -79,7 +206,32 @@ int benchmark(char* output_file_prefix, int number_of_nodes, int batch_size, voi
   }
 
   printf("\n");
+  benchmark_write_memory(file_memory, "add", N);
+  printf("Bytes per element: %f allocated, %f resident\n", (double)memory.bytes / N,
+         ((double)benchmark_rss() - (double)rss_before) / N);
+
+  // skewed searches on the full structure, ranks index the insertion sequence so hot values are spread over the keys
+  struct zipf zipf;
+  zipf_init(&zipf, N, ZIPF_THETA);
+  benchmark_reset_memory();
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rZipfian Search Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    clock_t start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      uint32_t val = (a * zipf_next(&zipf, (double)rand() / ((double)RAND_MAX + 1.0)) + b) % BENCHMARK_MAX_NODES;
+      assert(search(&val));
+    }
+    double time_spent_zipf = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    fprintf(file_zipf, "%d,%f\n", batch_end, time_spent_zipf);
+  }
+  assert(verify());
+
+  printf("\n");
+  benchmark_write_memory(file_memory, "zipf", N);
 
+  benchmark_reset_memory();
   uint32_t p = rand() % N;
   for (uint32_t x = 0; x < N; x += batch_size) {
     uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
@@ -96,8 +248,554 @@ int benchmark(char* output_file_prefix, int number_of_nodes, int batch_size, voi
     fprintf(file_remove, "%d,%f\n", N - batch_end, time_spent_remove);
   };
 
+  printf("\n");
+  benchmark_write_memory(file_memory, "remove", 0);
+
   fclose(file_add);
   fclose(file_search);
   fclose(file_remove);
+  fclose(file_zipf);
+  fclose(file_memory);
+  return EXIT_SUCCESS;
+}
+
+struct thread_args {
+  uint32_t id;
+  uint32_t thread_count;
+  uint32_t number_of_nodes;
+  uint32_t a;
+  uint32_t b;
+  void (*op)(const void*);
+  bool (*search)(const void*);
+};
+
+static void* benchmark_thread(void* arg) {
+  struct thread_args* args = arg;
+  for (uint32_t i = args->id; i < args->number_of_nodes; i += args->thread_count) {
+    const uint32_t val = (args->a * i + args->b) % BENCHMARK_MAX_NODES;
+    if (args->search) {
+      bool found = args->search(&val);
+      assert(found);
+      (void)found;
+    } else {
+      args->op(&val);
+    }
+  }
+  return NULL;
+}
+
+// wall-clock time of one phase split across thread_count threads, clock() would sum the CPU time of all threads
+static double benchmark_phase(struct thread_args* args, uint32_t thread_count) {
+  pthread_t threads[BENCHMARK_MAX_THREADS];
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t t = 0; t < thread_count; t++) {
+    args[t].id = t;
+    args[t].thread_count = thread_count;
+    if (pthread_create(&threads[t], NULL, benchmark_thread, &args[t]) != 0) {
+      perror("pthread_create");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (uint32_t t = 0; t < thread_count; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int benchmark_threads(char* output_file_prefix, int number_of_nodes, int max_threads, void add(const void*),
+                      void remove(const void*), bool search(const void*)) {
+  char threads_filename[256];
+  snprintf(threads_filename, sizeof(threads_filename), "%s_threads.csv", output_file_prefix);
+  FILE* file_threads = fopen(threads_filename, "ax");
+  if (!file_threads) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", threads_filename);
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));  // flawfinder: ignore
+
+  struct thread_args args[BENCHMARK_MAX_THREADS];
+  uint32_t a = (rand() | 1) % BENCHMARK_MAX_NODES;
+  uint32_t b = rand() % BENCHMARK_MAX_NODES;
+
+  for (int thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+    printf("\rThreads: %d", thread_count);
+    fflush(stdout);
+
+    for (int t = 0; t < thread_count; t++) {
+      args[t] = (struct thread_args){.number_of_nodes = number_of_nodes, .a = a, .b = b, .op = add};
+    }
+    double time_spent_add = benchmark_phase(args, thread_count);
+
+    for (int t = 0; t < thread_count; t++) {
+      args[t].search = search;
+    }
+    double time_spent_search = benchmark_phase(args, thread_count);
+
+    for (int t = 0; t < thread_count; t++) {
+      args[t].op = remove;
+      args[t].search = NULL;
+    }
+    double time_spent_remove = benchmark_phase(args, thread_count);
+
+    fprintf(file_threads, "%d,%f,%f,%f\n", thread_count, time_spent_add, time_spent_search, time_spent_remove);
+  }
+
+  printf("\n");
+
+  fclose(file_threads);
+  return EXIT_SUCCESS;
+}
+
+int benchmark_batch(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
+                    bool search(const void*), size_t search_batch(const void*, size_t, void**)) {
+  char batch_filename[256];
+  snprintf(batch_filename, sizeof(batch_filename), "%s_batch.csv", output_file_prefix);
+  FILE* file_batch = fopen(batch_filename, "ax");
+  if (!file_batch) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", batch_filename);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t* keys = malloc(batch_size * sizeof(uint32_t));
+  void** results = malloc(batch_size * sizeof(void*));
+  if (!keys || !results) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+
+  srand(time(NULL));  // flawfinder: ignore
+
+  uint32_t a = (rand() | 1) % BENCHMARK_MAX_NODES;  // 2 ** 20 MAX
+  uint32_t b = rand() % BENCHMARK_MAX_NODES;
+  uint32_t N = number_of_nodes;
+
+  printf("Adding %u nodes\n", N);
+  for (uint32_t i = 0; i < N; i++) {
+    const uint32_t val = (a * i + b) % BENCHMARK_MAX_NODES;
+    add(&val);
+  }
+
+  double total_single = 0, total_batched = 0;
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    uint32_t count = batch_end - x;
+    printf("\rBatched Search Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    for (uint32_t i = 0; i < count; i++) {
+      keys[i] = (a * (rand() % N) + b) % BENCHMARK_MAX_NODES;
+    }
+
+    clock_t start_time = clock();
+    for (uint32_t i = 0; i < count; i++) {
+      assert(search(&keys[i]));
+    }
+    double time_spent_single = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+
+    start_time = clock();
+    size_t found = search_batch(keys, count, results);
+    double time_spent_batched = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    assert(found == count);
+    (void)found;
+
+    total_single += time_spent_single;
+    total_batched += time_spent_batched;
+    fprintf(file_batch, "%d,%f,%f\n", batch_end, time_spent_single, time_spent_batched);
+  }
+
+  printf("\nSingle: %f s, batched: %f s\n", total_single, total_batched);
+
+  free(keys);
+  free(results);
+  fclose(file_batch);
+  return EXIT_SUCCESS;
+}
+
+int benchmark_sequential(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
+                         void add_edge(const void*)) {
+  char sequential_filename[256];
+  snprintf(sequential_filename, sizeof(sequential_filename), "%s_sequential.csv", output_file_prefix);
+  FILE* file_sequential = fopen(sequential_filename, "ax");
+  if (!file_sequential) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", sequential_filename);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t N = number_of_nodes;
+  double total_add = 0, total_edge = 0;
+  uint64_t total_add_comparisons = 0, total_edge_comparisons = 0;
+
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rSequential Add Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    comparisons = 0;
+    clock_t start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      const uint32_t val = i ^ ((i / 4 * 2654435761u) >> 30);  // xor within the block of 4, still a permutation
+      add(&val);
+    }
+    double time_spent_add = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    uint64_t add_comparisons = comparisons;
+
+    comparisons = 0;
+    start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      const uint32_t val = i ^ ((i / 4 * 2654435761u) >> 30);
+      add_edge(&val);
+    }
+    double time_spent_edge = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    uint64_t edge_comparisons = comparisons;
+
+    total_add += time_spent_add;
+    total_edge += time_spent_edge;
+    total_add_comparisons += add_comparisons;
+    total_edge_comparisons += edge_comparisons;
+    fprintf(file_sequential, "%d,%f,%lu,%f,%lu\n", batch_end, time_spent_add, (unsigned long)add_comparisons,
+            time_spent_edge, (unsigned long)edge_comparisons);
+  }
+
+  printf("\nAdd: %f s, %f comparisons per value\n", total_add, (double)total_add_comparisons / N);
+  printf("Edge add: %f s, %f comparisons per value\n", total_edge, (double)total_edge_comparisons / N);
+
+  fclose(file_sequential);
+  return EXIT_SUCCESS;
+}
+
+int benchmark_rotations(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
+                        void remove(const void*), size_t rotations(void)) {
+  char add_filename[256];
+  snprintf(add_filename, sizeof(add_filename), "%s_rotations_add.csv", output_file_prefix);
+  FILE* file_add = fopen(add_filename, "ax");
+  if (!file_add) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", add_filename);
+    return EXIT_FAILURE;
+  }
+
+  char remove_filename[256];
+  snprintf(remove_filename, sizeof(remove_filename), "%s_rotations_remove.csv", output_file_prefix);
+  FILE* file_remove = fopen(remove_filename, "ax");
+  if (!file_remove) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", remove_filename);
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));  // flawfinder: ignore
+
+  uint32_t a = (rand() | 1) % BENCHMARK_MAX_NODES;  // 2 ** 20 MAX
+  uint32_t b = rand() % BENCHMARK_MAX_NODES;
+  uint32_t N = number_of_nodes;
+  double total_add = 0, total_remove = 0;
+  size_t total_add_rotations = 0, total_remove_rotations = 0;
+
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rAdd Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    size_t start_rotations = rotations();
+    clock_t start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      const uint32_t val = (a * i + b) % BENCHMARK_MAX_NODES;
+      add(&val);
+    }
+    double time_spent_add = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    size_t add_rotations = rotations() - start_rotations;
+
+    total_add += time_spent_add;
+    total_add_rotations += add_rotations;
+    fprintf(file_add, "%d,%f,%zu\n", batch_end, time_spent_add, add_rotations);
+  }
+
+  printf("\n");
+
+  uint32_t p = rand() % N;
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rRemove Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    size_t start_rotations = rotations();
+    clock_t start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      uint32_t Xk = (i + p) % N;  // offset by random p to avoid removing in same order as added
+      const uint32_t val = (a * Xk + b) % BENCHMARK_MAX_NODES;
+      remove(&val);
+    }
+    double time_spent_remove = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    size_t remove_rotations = rotations() - start_rotations;
+
+    total_remove += time_spent_remove;
+    total_remove_rotations += remove_rotations;
+    fprintf(file_remove, "%d,%f,%zu\n", N - batch_end, time_spent_remove, remove_rotations);
+  }
+
+  printf("\nAdd: %f s, %f rotations per value\n", total_add, (double)total_add_rotations / N);
+  printf("Remove: %f s, %f rotations per value\n", total_remove, (double)total_remove_rotations / N);
+
+  fclose(file_add);
+  fclose(file_remove);
+  return EXIT_SUCCESS;
+}
+
+int benchmark_queue(char* output_file_prefix, int number_of_nodes, int batch_size, void push(const void*),
+                    bool pop(void*)) {
+  char push_filename[256];
+  snprintf(push_filename, sizeof(push_filename), "%s_push.csv", output_file_prefix);
+  FILE* file_push = fopen(push_filename, "ax");
+  if (!file_push) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", push_filename);
+    return EXIT_FAILURE;
+  }
+
+  char pop_filename[256];
+  snprintf(pop_filename, sizeof(pop_filename), "%s_pop.csv", output_file_prefix);
+  FILE* file_pop = fopen(pop_filename, "ax");
+  if (!file_pop) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", pop_filename);
+    return EXIT_FAILURE;
+  }
+
+  srand(time(NULL));  // flawfinder: ignore
+
+  uint32_t a = (rand() | 1) % BENCHMARK_MAX_NODES;  // 2 ** 20 MAX
+  uint32_t b = rand() % BENCHMARK_MAX_NODES;
+  uint32_t N = number_of_nodes;
+
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rPush Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    clock_t start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      const uint32_t val = (a * i + b) % BENCHMARK_MAX_NODES;
+      push(&val);
+    }
+    double time_spent_push = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    fprintf(file_push, "%d,%f\n", batch_end, time_spent_push);
+  }
+
+  printf("\n");
+
+  uint32_t previous = 0;
+  for (uint32_t x = 0; x < N; x += batch_size) {
+    uint32_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rPop Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    clock_t start_time = clock();
+    for (uint32_t i = x; i < batch_end; i++) {
+      uint32_t val;
+      bool popped = pop(&val);
+      assert(popped && val >= previous);
+      (void)popped;
+      previous = val;
+    }
+    double time_spent_pop = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    fprintf(file_pop, "%d,%f\n", N - batch_end, time_spent_pop);
+  }
+
+  printf("\n");
+
+  fclose(file_push);
+  fclose(file_pop);
+  return EXIT_SUCCESS;
+}
+
+// --- Workloads ---
+
+#define WORKLOAD_SCATTER 0x9e3779b97f4a7c15ULL  // odd, so multiplying ranks by it is a bijection of 64-bit keys
+#define WORKLOAD_CLUSTER_SIZE 4096               // consecutive keys of a cluster
+#define WORKLOAD_CLUSTER_RUN 64                  // operations spent in a cluster before jumping to another
+
+static const char* workload_distributions[] = {"uniform", "zipf", "sequential", "clustered"};
+
+// splitmix64, rand() is too narrow for more than 2^31 records and would be shared with the other benchmarks
+static uint64_t workload_random(uint64_t* state) {
+  uint64_t z = (*state += WORKLOAD_SCATTER);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static double workload_uniform(uint64_t* state) { return (workload_random(state) >> 11) * 0x1.0p-53; }
+
+static uint64_t workload_gcd(uint64_t a, uint64_t b) {
+  while (b != 0) {
+    uint64_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+int benchmark_workload_compare(const void* a, const void* b) {
+  comparisons++;
+  uint64_t key_a, key_b;
+  memcpy(&key_a, a, sizeof(key_a));
+  memcpy(&key_b, b, sizeof(key_b));
+  if (key_a < key_b) return -1;
+  if (key_a > key_b) return 1;
+  return 0;
+}
+
+bool benchmark_parse_workload(int argc, char* argv[], BenchmarkWorkload* workload) {
+  if (argc != 4 && argc != 5) return false;
+
+  int distribution = -1;
+  for (int i = 0; i < (int)(sizeof(workload_distributions) / sizeof(workload_distributions[0])); i++) {
+    if (strcmp(argv[0], workload_distributions[i]) == 0) distribution = i;
+  }
+  int record_size = atoi(argv[1]);
+  int read_percent = atoi(argv[2]);
+  int insert_percent = atoi(argv[3]);
+  if (distribution < 0 || record_size < BENCHMARK_MIN_RECORD_SIZE || record_size > BENCHMARK_MAX_RECORD_SIZE ||
+      read_percent < 0 || insert_percent < 0 || read_percent + insert_percent > 100) {
+    return false;
+  }
+
+  workload->distribution = distribution;
+  workload->record_size = record_size;
+  workload->read_percent = read_percent;
+  workload->insert_percent = insert_percent;
+  workload->seed = argc == 5 ? strtoull(argv[4], NULL, 0) : (uint64_t)time(NULL);
+  return true;
+}
+
+// State of the key generator of one workload, ranks index the records loaded first
+struct workload_keys {
+  const BenchmarkWorkload* workload;
+  uint64_t records;
+  uint64_t random;
+  struct zipf zipf;
+  uint64_t cursor;        // next rank of the sequential distribution
+  uint64_t cluster_base;  // first rank of the current cluster
+  uint64_t cluster_left;  // operations left in it
+  uint64_t fresh;         // next rank inserted by the workload, past the loaded ones so inserts add new keys
+};
+
+static uint64_t workload_next_rank(struct workload_keys* keys) {
+  switch (keys->workload->distribution) {
+    case BENCHMARK_ZIPF:
+      return zipf_next(&keys->zipf, workload_uniform(&keys->random));
+    case BENCHMARK_SEQUENTIAL:
+      return keys->cursor++ % keys->records;
+    case BENCHMARK_CLUSTERED: {
+      uint64_t clusters = (keys->records + WORKLOAD_CLUSTER_SIZE - 1) / WORKLOAD_CLUSTER_SIZE;
+      if (keys->cluster_left-- == 0) {
+        keys->cluster_base = workload_random(&keys->random) % clusters * WORKLOAD_CLUSTER_SIZE;
+        keys->cluster_left = WORKLOAD_CLUSTER_RUN - 1;
+      }
+      uint64_t width = keys->records - keys->cluster_base;  // the last cluster may be shorter
+      if (width > WORKLOAD_CLUSTER_SIZE) width = WORKLOAD_CLUSTER_SIZE;
+      return keys->cluster_base + workload_random(&keys->random) % width;
+    }
+    default:
+      return workload_random(&keys->random) % keys->records;
+  }
+}
+
+// Sequential and clustered ranks stay adjacent keys, uniform and Zipfian ones are scattered so hot keys are spread
+static void workload_record(const struct workload_keys* keys, uint64_t rank, char* record) {
+  BenchmarkDistribution distribution = keys->workload->distribution;
+  uint64_t key =
+      distribution == BENCHMARK_SEQUENTIAL || distribution == BENCHMARK_CLUSTERED ? rank : rank * WORKLOAD_SCATTER;
+  memcpy(record, &key, sizeof(key));
+}
+
+int benchmark_workload(char* output_file_prefix, uint64_t number_of_records, int batch_size,
+                       const BenchmarkWorkload* workload, void add(const void*), void remove(const void*),
+                       bool search(const void*)) {
+  char load_filename[256];
+  snprintf(load_filename, sizeof(load_filename), "%s_load.csv", output_file_prefix);
+  FILE* file_load = fopen(load_filename, "ax");
+  if (!file_load) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", load_filename);
+    return EXIT_FAILURE;
+  }
+
+  char workload_filename[256];
+  snprintf(workload_filename, sizeof(workload_filename), "%s_workload.csv", output_file_prefix);
+  FILE* file_workload = fopen(workload_filename, "ax");
+  if (!file_workload) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", workload_filename);
+    return EXIT_FAILURE;
+  }
+
+  // the payload after the key is filled once, records only differ by their key
+  char* record = malloc(workload->record_size);
+  if (!record) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  memset(record, 0xa5, workload->record_size);
+
+  uint64_t N = number_of_records;
+  struct workload_keys keys = {.workload = workload, .records = N, .random = workload->seed, .fresh = N};
+  printf("Seed: %lu\n", (unsigned long)workload->seed);
+
+  // every rank is loaded once, in a pseudo-random order unless the distribution is sequential. a is coprime with N, so
+  // a * i % N is a permutation, and below 2^20 so the product does not overflow for less than 2^44 records.
+  uint64_t a = workload_random(&keys.random) % BENCHMARK_MAX_NODES % N;
+  while (workload_gcd(a, N) != 1) a++;
+  for (uint64_t x = 0; x < N; x += batch_size) {
+    uint64_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rLoad Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    clock_t start_time = clock();
+    for (uint64_t i = x; i < batch_end; i++) {
+      workload_record(&keys, workload->distribution == BENCHMARK_SEQUENTIAL ? i : a * i % N, record);
+      add(record);
+    }
+    double time_spent_load = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+    fprintf(file_load, "%lu,%f\n", (unsigned long)batch_end, time_spent_load);
+  }
+
+  printf("\n");
+
+  if (workload->distribution == BENCHMARK_ZIPF) zipf_init(&keys.zipf, N, ZIPF_THETA);
+  uint64_t total_reads = 0, total_hits = 0, total_inserts = 0, total_removes = 0;
+  double total_time = 0;
+  for (uint64_t x = 0; x < N; x += batch_size) {
+    uint64_t batch_end = (x + batch_size < N) ? x + batch_size : N;
+    printf("\rWorkload Progress: %f%%", ((double)(batch_end - 1) / (N - 1)) * 100);
+
+    uint64_t reads = 0, hits = 0, inserts = 0, removes = 0;
+    clock_t start_time = clock();
+    for (uint64_t i = x; i < batch_end; i++) {
+      unsigned op = workload_random(&keys.random) % 100;
+      if (op < workload->read_percent) {
+        workload_record(&keys, workload_next_rank(&keys), record);
+        hits += search(record);
+        reads++;
+      } else if (op < workload->read_percent + workload->insert_percent) {
+        workload_record(&keys, keys.fresh++, record);
+        add(record);
+        inserts++;
+      } else {
+        workload_record(&keys, workload_next_rank(&keys), record);
+        remove(record);
+        removes++;
+      }
+    }
+    double time_spent = (double)(clock() - start_time) / CLOCKS_PER_SEC;
+
+    total_reads += reads;
+    total_hits += hits;
+    total_inserts += inserts;
+    total_removes += removes;
+    total_time += time_spent;
+    fprintf(file_workload, "%lu,%f,%lu,%lu,%lu,%lu\n", (unsigned long)batch_end, time_spent, (unsigned long)reads,
+            (unsigned long)hits, (unsigned long)inserts, (unsigned long)removes);
+  }
+
+  printf("\n%f operations per second, %lu reads (%lu hits), %lu inserts, %lu removes\n", N / total_time,
+         (unsigned long)total_reads, (unsigned long)total_hits, (unsigned long)total_inserts,
+         (unsigned long)total_removes);
+
+  free(record);
+  fclose(file_load);
+  fclose(file_workload);
   return EXIT_SUCCESS;
 }
@@ -8,14 +8,45 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define BENCHMARK_MAX_NODES 1048576
 #define BENCHMARK_DATA_SIZE sizeof(uint32_t)
+#define BENCHMARK_MAX_THREADS 64
+#define BENCHMARK_MIN_RECORD_SIZE 8  // workload records start with a uint64_t key
+#define BENCHMARK_MAX_RECORD_SIZE 1024
+
+/**
+ * Distribution of the keys used by the operations of a workload, see benchmark_workload.
+ */
+typedef enum {
+  BENCHMARK_UNIFORM,     ///< Every record equally likely.
+  BENCHMARK_ZIPF,        ///< Zipfian (theta 0.99), the hot records being spread over the keys.
+  BENCHMARK_SEQUENTIAL,  ///< Records taken in key order, wrapping around.
+  BENCHMARK_CLUSTERED,   ///< Runs of 64 operations on a range of 4096 adjacent keys, ranges being picked uniformly.
+} BenchmarkDistribution;
+
+/**
+ * Workload run by benchmark_workload.
+ */
+typedef struct {
+  BenchmarkDistribution distribution;
+  size_t record_size;       ///< Size of the records, a uint64_t key followed by payload, from 8 to 1024 bytes.
+  unsigned read_percent;    ///< Percentage of searches among the operations.
+  unsigned insert_percent;  ///< Percentage of adds of new keys, the remaining operations being removes.
+  uint64_t seed;            ///< Seed of the keys and operations, the same seed runs the same workload.
+} BenchmarkWorkload;
 
 /**
  * Benchmark the provided data structure operations.
  * Uses uint16_t values for testing.
+ * Once every node is added, number_of_nodes searches following a Zipfian distribution (theta 0.99) are timed into
+ * <output_file_prefix>_zipf.csv, to show how structures that adapt to the access pattern behave under skew.
+ * The memory of each phase (add, zipf and remove) is written to <output_file_prefix>_memory.csv as
+ * "phase,elements,allocations,frees,bytes,bytes_per_element,peak_bytes,rss,peak_rss" lines. Allocation counts and bytes
+ * only cover benchmark_alloc and benchmark_free, and bytes are the usable sizes of the blocks still allocated at the
+ * end of the phase. RSS and its peak over the phase are read from /proc, and are 0 where it is not available.
  *
  * @param output_file_prefix Prefix for the output CSV files.
  * @param number_of_nodes Number of nodes to be added, searched, and removed.
@@ -29,6 +60,140 @@
 extern int benchmark(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*), void remove(const void*),
               bool search(const void*), bool verify());
 
+/**
+ * Benchmark the provided thread-safe data structure operations with 1, 2, 4... up to max_threads threads.
+ * Each phase (add, search, remove) splits the same number_of_nodes values between the threads and is timed with the
+ * wall clock. Results are written to <output_file_prefix>_threads.csv as "threads,add,search,remove" lines.
+ *
+ * @param output_file_prefix Prefix for the output CSV file.
+ * @param number_of_nodes Number of nodes to be added, searched, and removed for each thread count.
+ * @param max_threads Highest number of threads to benchmark, at most BENCHMARK_MAX_THREADS.
+ * @param add Function pointer to the add operation.
+ * @param remove Function pointer to the remove operation.
+ * @param search Function pointer to the search operation. Should return true if the data is found, false otherwise.
+ * @return 0 on success, non-zero on failure.
+ */
+extern int benchmark_threads(char* output_file_prefix, int number_of_nodes, int max_threads, void add(const void*),
+                             void remove(const void*), bool search(const void*));
+
+/**
+ * Benchmark the provided priority queue operations.
+ * Pushes number_of_nodes distinct uint32_t values in pseudo-random order, then pops them all, checking that they come
+ * out in ascending order. Results are written to <output_file_prefix>_push.csv and <output_file_prefix>_pop.csv.
+ *
+ * @param output_file_prefix Prefix for the output CSV files.
+ * @param number_of_nodes Number of values to be pushed and popped.
+ * @param batch_size Number of operations to perform in each batch.
+ * @param push Function pointer to the push operation.
+ * @param pop Function pointer to the pop operation, writing the smallest value to its argument. Should return false if
+ * the queue is empty.
+ * @return 0 on success, non-zero on failure.
+ */
+extern int benchmark_queue(char* output_file_prefix, int number_of_nodes, int batch_size, void push(const void*),
+                           bool pop(void*));
+
+/**
+ * Benchmark batched searches against the same searches done one by one.
+ * Adds number_of_nodes values, then searches batches of batch_size random values, first with search and then with a
+ * single search_batch call. Results are written to <output_file_prefix>_batch.csv as "searches,single,batched" lines.
+ *
+ * @param output_file_prefix Prefix for the output CSV file.
+ * @param number_of_nodes Number of nodes to be added, and of values searched in total.
+ * @param batch_size Number of values searched per batch.
+ * @param add Function pointer to the add operation.
+ * @param search Function pointer to the search operation. Should return true if the data is found, false otherwise.
+ * @param search_batch Function pointer to the batched search operation, taking an array of count values and an array
+ * of count result pointers. Should return the number of values found.
+ * @return 0 on success, non-zero on failure.
+ */
+extern int benchmark_batch(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
+                           bool search(const void*), size_t search_batch(const void*, size_t, void**));
+
+/**
+ * Benchmark insertion of almost sorted values with the regular add and with an add from the right edge, each into its
+ * own structure. Values increase, shuffled inside blocks of 4. Both structures must use benchmark_compare, whose calls
+ * are counted. Results are written to <output_file_prefix>_sequential.csv as
+ * "nodes,add,add_comparisons,edge,edge_comparisons" lines.
+ *
+ * @param output_file_prefix Prefix for the output CSV file.
+ * @param number_of_nodes Number of nodes to be added to each structure.
+ * @param batch_size Number of operations to perform in each batch.
+ * @param add Function pointer to the add operation of the first structure.
+ * @param add_edge Function pointer to the add from the right edge of the second structure.
+ * @return 0 on success, non-zero on failure.
+ */
+extern int benchmark_sequential(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
+                                void add_edge(const void*));
+
+/**
+ * Benchmark the rebalancing work of a self-balancing tree.
+ * Adds number_of_nodes values in pseudo-random order, then removes them all in a different order, reading the
+ * rotation counter of the tree after each batch. Results are written to <output_file_prefix>_rotations_add.csv and
+ * <output_file_prefix>_rotations_remove.csv as "nodes,time,rotations" lines, rotations being those of the batch.
+ *
+ * @param output_file_prefix Prefix for the output CSV files.
+ * @param number_of_nodes Number of nodes to be added and removed.
+ * @param batch_size Number of operations to perform in each batch.
+ * @param add Function pointer to the add operation.
+ * @param remove Function pointer to the remove operation.
+ * @param rotations Function pointer returning the number of rotations done by the tree since its creation.
+ * @return 0 on success, non-zero on failure.
+ */
+extern int benchmark_rotations(char* output_file_prefix, int number_of_nodes, int batch_size, void add(const void*),
+                               void remove(const void*), size_t rotations(void));
+
+/**
+ * Benchmark the provided data structure operations on a mixed workload.
+ * First loads number_of_records records with distinct keys, timed into <output_file_prefix>_load.csv as
+ * "records,time" lines. Then runs number_of_records operations drawn from the workload's mix, in the same phase.
+ * Searches and removes pick keys of the loaded records following its distribution, adds insert keys never used
+ * before. Their times and counts are written to <output_file_prefix>_workload.csv as
+ * "operations,time,reads,hits,inserts,removes" lines. Counts are 64-bit, so sizes are only limited by memory, and
+ * searches may miss records removed earlier.
+ * The data structure must store workload->record_size bytes and use benchmark_workload_compare.
+ *
+ * @param output_file_prefix Prefix for the output CSV files.
+ * @param number_of_records Number of records loaded, and of operations run.
+ * @param batch_size Number of operations to perform in each batch.
+ * @param workload Workload to run, see benchmark_parse_workload.
+ * @param add Function pointer to the add operation.
+ * @param remove Function pointer to the remove operation.
+ * @param search Function pointer to the search operation. Should return true if the data is found, false otherwise.
+ * @return 0 on success, non-zero on failure.
+ */
+extern int benchmark_workload(char* output_file_prefix, uint64_t number_of_records, int batch_size,
+                              const BenchmarkWorkload* workload, void add(const void*), void remove(const void*),
+                              bool search(const void*));
+
+/**
+ * Parse the arguments describing a workload: <distribution> <record_size> <read_percent> <insert_percent> [seed],
+ * distribution being uniform, zipf, sequential or clustered. Without a seed, the current time is used.
+ *
+ * @param argc Number of arguments.
+ * @param argv The arguments.
+ * @param workload Workload receiving the parsed values.
+ * @return true if the arguments describe a valid workload, false otherwise.
+ */
+extern bool benchmark_parse_workload(int argc, char* argv[], BenchmarkWorkload* workload);
+
+/**
+ * Allocation function to give the data-structure being benchmarked, counted by benchmark.
+ * Not thread-safe.
+ *
+ * @param ctx Unused.
+ * @param size Number of bytes to allocate.
+ * @return Pointer to the allocated memory, NULL on failure.
+ */
+extern void* benchmark_alloc(void* ctx, size_t size);
+
+/**
+ * Deallocation function matching benchmark_alloc.
+ *
+ * @param ctx Unused.
+ * @param ptr Pointer returned by benchmark_alloc, or NULL.
+ */
+extern void benchmark_free(void* ctx, void* ptr);
+
 /**
  * Comparison function to use for data-structure being benchmarked.
  *
@@ -38,6 +203,16 @@ extern int benchmark(char* output_file_prefix, int number_of_nodes, int batch_si
  */
 extern int benchmark_compare(const void* a, const void* b);
 
+/**
+ * Comparison function to use for data-structure being benchmarked with benchmark_workload, ordering the uint64_t keys
+ * at the start of the records.
+ *
+ * @param a Pointer to the first record.
+ * @param b Pointer to the second record.
+ * @return Negative value if a < b, zero if a == b, positive value if a > b.
+ */
+extern int benchmark_workload_compare(const void* a, const void* b);
+
 /**
  * Deletion function to use for data-structure being benchmarked.
  *
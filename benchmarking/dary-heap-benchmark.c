@@ -0,0 +1,35 @@
+/**
+ * @file dary-heap-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "dary-heap.h"
+
+#define DARY_HEAP_ARITY 4
+
+DAryHeap heap;
+
+void dheap_push_wrapper(const void* data) { dheap_push(heap, data); }
+
+bool dheap_pop_wrapper(void* data) { return dheap_pop(heap, data); }
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  heap = dheap_new(BENCHMARK_DATA_SIZE, DARY_HEAP_ARITY, benchmark_compare, benchmark_delete);
+
+  benchmark_queue(argv[3], atoi(argv[1]), atoi(argv[2]), &dheap_push_wrapper, &dheap_pop_wrapper);
+
+  dheap_delete(heap);
+  return EXIT_SUCCESS;
+}
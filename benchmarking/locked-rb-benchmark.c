@@ -0,0 +1,51 @@
+/**
+ * @file locked-rb-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "red-black-tree.h"
+
+// Baseline for skip-list-benchmark: a red-black tree behind a single global lock
+RBTree tree;
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+void rb_add_wrapper(const void* data) {
+  pthread_mutex_lock(&lock);
+  rb_add(tree, data);
+  pthread_mutex_unlock(&lock);
+}
+
+bool rb_search_wrapper(const void* data) {
+  pthread_mutex_lock(&lock);
+  bool found = rb_find_data(tree, data) != NULL;
+  pthread_mutex_unlock(&lock);
+  return found;
+}
+
+void rb_remove_wrapper(const void* data) {
+  pthread_mutex_lock(&lock);
+  rb_remove(tree, data);
+  pthread_mutex_unlock(&lock);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > BENCHMARK_MAX_THREADS) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <max_threads> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  tree = rb_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+
+  benchmark_threads(argv[3], atoi(argv[1]), atoi(argv[2]), &rb_add_wrapper, &rb_remove_wrapper, &rb_search_wrapper);
+
+  rb_delete(tree);
+  return EXIT_SUCCESS;
+}
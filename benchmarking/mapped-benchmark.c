@@ -0,0 +1,51 @@
+/**
+ * @file mapped-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "mapped-tree.h"
+
+MappedTree tree;
+
+void mapped_add_wrapper(const void* data) { mapped_add(tree, data); }
+
+bool mapped_search_wrapper(const void* data) { return mapped_find_data(tree, data) != NULL; }
+
+void mapped_remove_wrapper(const void* data) { mapped_remove(tree, data); }
+
+bool mapped_verify_wrapper() { return mapped_is_valid(tree); }
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // the tree lives in <output_file_prefix>.tree for the duration of the benchmark
+  char tree_filename[256];
+  snprintf(tree_filename, sizeof(tree_filename), "%s.tree", argv[3]);
+  if (access(tree_filename, F_OK) == 0) {
+    fprintf(stderr, "Error opening file %s\nFile must not already exist\n", tree_filename);
+    return EXIT_FAILURE;
+  }
+  tree = mapped_open(tree_filename, BENCHMARK_DATA_SIZE, benchmark_compare);
+  if (!tree) {
+    perror(tree_filename);
+    return EXIT_FAILURE;
+  }
+
+  benchmark(argv[3], atoi(argv[1]), atoi(argv[2]), &mapped_add_wrapper, &mapped_remove_wrapper, &mapped_search_wrapper,
+            &mapped_verify_wrapper);
+
+  mapped_close(tree);
+  unlink(tree_filename);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file pairing-heap-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "pairing-heap.h"
+
+PairingHeap heap;
+
+void pheap_push_wrapper(const void* data) { pheap_push(heap, data); }
+
+bool pheap_pop_wrapper(void* data) { return pheap_pop(heap, data); }
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  heap = pheap_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+
+  benchmark_queue(argv[3], atoi(argv[1]), atoi(argv[2]), &pheap_push_wrapper, &pheap_pop_wrapper);
+
+  pheap_delete(heap);
+  return EXIT_SUCCESS;
+}
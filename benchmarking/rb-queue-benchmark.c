@@ -0,0 +1,34 @@
+/**
+ * @file rb-queue-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "red-black-tree.h"
+
+// Baseline for the heap benchmarks: a red-black tree used as a priority queue
+RBTree tree;
+
+void rb_push_wrapper(const void* data) { rb_add(tree, data); }
+
+bool rb_pop_wrapper(void* data) { return rb_pop_min(tree, data); }
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  tree = rb_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+
+  benchmark_queue(argv[3], atoi(argv[1]), atoi(argv[2]), &rb_push_wrapper, &rb_pop_wrapper);
+
+  rb_delete(tree);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file sharded-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "sharded-tree.h"
+
+#define DEFAULT_SHARDS 16
+
+// Compared against locked-rb-benchmark, the same red-black tree behind a single lock
+ShardedTree tree;
+
+void sharded_add_wrapper(const void* data) { sharded_add(tree, data); }
+
+bool sharded_search_wrapper(const void* data) { return sharded_find_data(tree, data, NULL); }
+
+void sharded_remove_wrapper(const void* data) { sharded_remove(tree, data); }
+
+int main(int argc, char* argv[]) {
+  if ((argc != 4 && argc != 5) || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > BENCHMARK_MAX_THREADS || (argc == 5 && atoi(argv[4]) <= 0)) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <max_threads> <output_file_prefix> [shard_count]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  tree = sharded_new(BENCHMARK_DATA_SIZE, argc == 5 ? atoi(argv[4]) : DEFAULT_SHARDS, benchmark_compare,
+                     benchmark_delete);
+
+  benchmark_threads(argv[3], atoi(argv[1]), atoi(argv[2]), &sharded_add_wrapper, &sharded_remove_wrapper,
+                    &sharded_search_wrapper);
+  printf("Rebalancings: %zu\n", sharded_get_rebalances(tree));
+
+  sharded_delete(tree);
+  return EXIT_SUCCESS;
+}
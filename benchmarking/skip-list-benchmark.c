@@ -0,0 +1,36 @@
+/**
+ * @file skip-list-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "skip-list.h"
+
+SkipList list;
+
+void skiplist_add_wrapper(const void* data) { skiplist_add(list, data); }
+
+bool skiplist_search_wrapper(const void* data) { return skiplist_find_data(list, data, NULL); }
+
+void skiplist_remove_wrapper(const void* data) { skiplist_remove(list, data); }
+
+int main(int argc, char* argv[]) {
+  if (argc != 4 || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > BENCHMARK_MAX_THREADS) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <max_threads> <output_file_prefix>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  list = skiplist_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+
+  benchmark_threads(argv[3], atoi(argv[1]), atoi(argv[2]), &skiplist_add_wrapper, &skiplist_remove_wrapper,
+                    &skiplist_search_wrapper);
+
+  skiplist_delete(list);
+  return EXIT_SUCCESS;
+}
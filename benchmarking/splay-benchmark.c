@@ -0,0 +1,42 @@
+/**
+ * @file splay-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "splay-tree.h"
+
+SplayTree tree;
+
+void splay_add_wrapper(const void* data) { splay_add(tree, data); }
+
+bool splay_search_wrapper(const void* data) { return splay_find_data(tree, data) != NULL; }
+
+void splay_remove_wrapper(const void* data) { splay_remove(tree, data); }
+
+bool splay_verify_wrapper() { return splay_is_valid(tree); }
+
+int main(int argc, char* argv[]) {
+  bool semi_splay = argc == 5 && strcmp(argv[4], "--semi-splay") == 0;
+  if ((argc != 4 && !semi_splay) || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES ||
+      atoi(argv[2]) <= 0 || atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix> [--semi-splay]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  tree = splay_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+  splay_set_semi_splay(tree, semi_splay);
+
+  benchmark(argv[3], atoi(argv[1]), atoi(argv[2]), &splay_add_wrapper, &splay_remove_wrapper, &splay_search_wrapper,
+            &splay_verify_wrapper);
+
+  splay_delete(tree);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file wavl-benchmark.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "wavl-tree.h"
+
+WAVLTree tree;
+
+void wavl_add_wrapper(const void* data) { wavl_add(tree, data); }
+
+bool wavl_search_wrapper(const void* data) { return wavl_find_data(tree, data) != NULL; }
+
+void wavl_remove_wrapper(const void* data) { wavl_remove(tree, data); }
+
+bool wavl_verify_wrapper() { return wavl_is_valid(tree); }
+
+size_t wavl_rotations_wrapper(void) { return wavl_get_rotations(tree); }
+
+int main(int argc, char* argv[]) {
+  bool rotations = argc == 5 && strcmp(argv[4], "--rotations") == 0;
+  if ((argc != 4 && !rotations) || atoi(argv[1]) <= 0 || atoi(argv[1]) >= BENCHMARK_MAX_NODES || atoi(argv[2]) <= 0 ||
+      atoi(argv[2]) > atoi(argv[1])) {
+    fprintf(stderr, "Usage: %s <number_of_nodes> <batch_size> <output_file_prefix> [--rotations]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  tree = wavl_new(BENCHMARK_DATA_SIZE, benchmark_compare, benchmark_delete);
+
+  if (rotations) {
+    benchmark_rotations(argv[3], atoi(argv[1]), atoi(argv[2]), &wavl_add_wrapper, &wavl_remove_wrapper,
+                        &wavl_rotations_wrapper);
+  } else {
+    benchmark(argv[3], atoi(argv[1]), atoi(argv[2]), &wavl_add_wrapper, &wavl_remove_wrapper, &wavl_search_wrapper,
+              &wavl_verify_wrapper);
+  }
+
+  wavl_delete(tree);
+  return EXIT_SUCCESS;
+}
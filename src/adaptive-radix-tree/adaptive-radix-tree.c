@@ -0,0 +1,695 @@
+/**
+ * @file adaptive-radix-tree.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "adaptive-radix-tree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../min-max.h"
+#include "adaptive-radix-tree.inc.h"
+
+// Leis, Kemper & Neumann, "The Adaptive Radix Tree: ARTful Indexing for Main-Memory Databases" (ICDE 2013)
+// see: https://db.in.tum.de/~leis/papers/ART.pdf
+// also: https://github.com/armon/libart (hybrid pessimistic/optimistic path compression)
+
+typedef struct _ARTNode* ARTNode;
+typedef struct _ARTNode4* ARTNode4;
+typedef struct _ARTNode16* ARTNode16;
+typedef struct _ARTNode48* ARTNode48;
+typedef struct _ARTNode256* ARTNode256;
+
+static inline bool is_leaf(ARTChild child) { return ((uintptr_t)child & 1) != 0; }
+
+static inline ARTLeaf as_leaf(ARTChild child) { return (ARTLeaf)((uintptr_t)child & ~(uintptr_t)1); }
+
+static inline ARTChild tag_leaf(ARTLeaf leaf) { return (ARTChild)((uintptr_t)leaf | 1); }
+
+static inline const unsigned char* leaf_key(ARTree tree, ARTLeaf leaf) {
+  return (const unsigned char*)leaf->data + tree->data_size;
+}
+
+static bool leaf_matches(ARTree tree, ARTLeaf leaf, const unsigned char* key, size_t key_len) {
+  return leaf->key_len == key_len && memcmp(leaf_key(tree, leaf), key, key_len) == 0;
+}
+
+// --- Constructor and Destructor ---
+
+static ARTLeaf art_leaf_new(ARTree tree, const unsigned char* key, size_t key_len, const void* data) {
+  ARTLeaf leaf = malloc(offsetof(struct _ARTLeaf, data) + tree->data_size + key_len);
+  if (!leaf) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  leaf->key_len = key_len;
+  memcpy(leaf->data, data, tree->data_size);
+  memcpy(leaf->data + tree->data_size, key, key_len);
+  return leaf;
+}
+
+static ARTNode art_node_new(uint8_t type) {
+  size_t size;
+  switch (type) {
+    case ART_NODE4:
+      size = sizeof(struct _ARTNode4);
+      break;
+    case ART_NODE16:
+      size = sizeof(struct _ARTNode16);
+      break;
+    case ART_NODE48:
+      size = sizeof(struct _ARTNode48);
+      break;
+    default:
+      size = sizeof(struct _ARTNode256);
+      break;
+  }
+
+  ARTNode node = calloc(1, size);
+  if (!node) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  node->type = type;
+  return node;
+}
+
+ARTree art_new(size_t size, void (*del)(void*)) {
+  ARTree tree = malloc(sizeof(struct _ARTree));
+  if (!tree) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+
+  tree->root = NULL;
+  tree->data_size = size;
+  tree->size = 0;
+  tree->delete_data = del;
+
+  return tree;
+}
+
+static void delete_leaf(ARTLeaf leaf, void del(void*)) {
+  if (del) del(leaf->data);
+  free(leaf);
+}
+
+static void delete_all_nodes(ARTChild child, void del(void*)) {
+  if (child == NULL) {
+    return;
+  }
+  if (is_leaf(child)) {
+    delete_leaf(as_leaf(child), del);
+    return;
+  }
+
+  ARTNode node = child;
+  switch (node->type) {
+    case ART_NODE4:
+      for (int i = 0; i < node->num_children; i++) delete_all_nodes(((ARTNode4)node)->children[i], del);
+      break;
+    case ART_NODE16:
+      for (int i = 0; i < node->num_children; i++) delete_all_nodes(((ARTNode16)node)->children[i], del);
+      break;
+    case ART_NODE48:
+      for (int i = 0; i < 48; i++) delete_all_nodes(((ARTNode48)node)->children[i], del);
+      break;
+    case ART_NODE256:
+      for (int i = 0; i < 256; i++) delete_all_nodes(((ARTNode256)node)->children[i], del);
+      break;
+  }
+  free(node);
+}
+
+void art_delete(ARTree tree) {
+  if (!tree) {
+    return;
+  }
+
+  delete_all_nodes(tree->root, tree->delete_data);
+  free(tree);
+}
+
+// --- Keys ---
+
+void art_key_from_u32(uint32_t value, unsigned char key[4]) {
+  for (int i = 3; i >= 0; i--) {
+    key[i] = value & 0xFF;
+    value >>= 8;
+  }
+}
+
+void art_key_from_u64(uint64_t value, unsigned char key[8]) {
+  for (int i = 7; i >= 0; i--) {
+    key[i] = value & 0xFF;
+    value >>= 8;
+  }
+}
+
+// --- Children ---
+
+static ARTChild* find_child(ARTNode node, unsigned char byte) {
+  switch (node->type) {
+    case ART_NODE4: {
+      ARTNode4 n = (ARTNode4)node;
+      for (int i = 0; i < node->num_children; i++) {
+        if (n->keys[i] == byte) return &n->children[i];
+      }
+      return NULL;
+    }
+    case ART_NODE16: {
+      ARTNode16 n = (ARTNode16)node;
+#ifdef __SSE2__
+      __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), _mm_loadu_si128((const __m128i*)n->keys));
+      int mask = _mm_movemask_epi8(cmp) & ((1 << node->num_children) - 1);
+      return mask ? &n->children[__builtin_ctz(mask)] : NULL;
+#else
+      for (int i = 0; i < node->num_children; i++) {
+        if (n->keys[i] == byte) return &n->children[i];
+      }
+      return NULL;
+#endif
+    }
+    case ART_NODE48: {
+      ARTNode48 n = (ARTNode48)node;
+      int slot = n->child_index[byte];
+      return slot ? &n->children[slot - 1] : NULL;
+    }
+    default: {
+      ARTNode256 n = (ARTNode256)node;
+      return n->children[byte] ? &n->children[byte] : NULL;
+    }
+  }
+}
+
+// Index of the first key not smaller than byte in a sorted Node4/Node16 key array
+static int lower_bound(const unsigned char* keys, int count, unsigned char byte) {
+#ifdef __SSE2__
+  if (count > 4) {
+    // unsigned byte < comparison done as max(key, byte) != key
+    __m128i probe = _mm_set1_epi8((char)byte);
+    __m128i stored = _mm_loadu_si128((const __m128i*)keys);
+    __m128i not_less = _mm_cmpeq_epi8(_mm_max_epu8(stored, probe), stored);
+    int mask = _mm_movemask_epi8(not_less) & ((1 << count) - 1);
+    return mask ? __builtin_ctz(mask) : count;
+  }
+#endif
+  int i = 0;
+  while (i < count && keys[i] < byte) i++;
+  return i;
+}
+
+static void copy_header(ARTNode dest, ARTNode src) {
+  dest->num_children = src->num_children;
+  dest->prefix_len = src->prefix_len;
+  memcpy(dest->prefix, src->prefix, MIN(ART_MAX_PREFIX_LEN, src->prefix_len));
+}
+
+static void add_child(ARTNode node, ARTChild* ref, unsigned char byte, ARTChild child);
+
+static void add_child256(ARTNode256 node, unsigned char byte, ARTChild child) {
+  node->header.num_children++;
+  node->children[byte] = child;
+}
+
+static void add_child48(ARTNode48 node, ARTChild* ref, unsigned char byte, ARTChild child) {
+  if (node->header.num_children < 48) {
+    int slot = 0;
+    while (node->children[slot] != NULL) slot++;
+    node->children[slot] = child;
+    node->child_index[byte] = slot + 1;
+    node->header.num_children++;
+    return;
+  }
+
+  ARTNode256 bigger = (ARTNode256)art_node_new(ART_NODE256);
+  for (int i = 0; i < 256; i++) {
+    if (node->child_index[i]) bigger->children[i] = node->children[node->child_index[i] - 1];
+  }
+  copy_header(&bigger->header, &node->header);
+  *ref = bigger;
+  free(node);
+  add_child256(bigger, byte, child);
+}
+
+static void add_child16(ARTNode16 node, ARTChild* ref, unsigned char byte, ARTChild child) {
+  int count = node->header.num_children;
+  if (count < 16) {
+    int index = lower_bound(node->keys, count, byte);
+    memmove(node->keys + index + 1, node->keys + index, count - index);
+    memmove(node->children + index + 1, node->children + index, (count - index) * sizeof(ARTChild));
+    node->keys[index] = byte;
+    node->children[index] = child;
+    node->header.num_children++;
+    return;
+  }
+
+  ARTNode48 bigger = (ARTNode48)art_node_new(ART_NODE48);
+  memcpy(bigger->children, node->children, count * sizeof(ARTChild));
+  for (int i = 0; i < count; i++) bigger->child_index[node->keys[i]] = i + 1;
+  copy_header(&bigger->header, &node->header);
+  *ref = bigger;
+  free(node);
+  add_child48(bigger, ref, byte, child);
+}
+
+static void add_child4(ARTNode4 node, ARTChild* ref, unsigned char byte, ARTChild child) {
+  int count = node->header.num_children;
+  if (count < 4) {
+    int index = lower_bound(node->keys, count, byte);
+    memmove(node->keys + index + 1, node->keys + index, count - index);
+    memmove(node->children + index + 1, node->children + index, (count - index) * sizeof(ARTChild));
+    node->keys[index] = byte;
+    node->children[index] = child;
+    node->header.num_children++;
+    return;
+  }
+
+  ARTNode16 bigger = (ARTNode16)art_node_new(ART_NODE16);
+  memcpy(bigger->keys, node->keys, count);
+  memcpy(bigger->children, node->children, count * sizeof(ARTChild));
+  copy_header(&bigger->header, &node->header);
+  *ref = bigger;
+  free(node);
+  add_child16(bigger, ref, byte, child);
+}
+
+// ref is the link to node, updated when the node has to grow into a bigger type
+static void add_child(ARTNode node, ARTChild* ref, unsigned char byte, ARTChild child) {
+  switch (node->type) {
+    case ART_NODE4:
+      add_child4((ARTNode4)node, ref, byte, child);
+      break;
+    case ART_NODE16:
+      add_child16((ARTNode16)node, ref, byte, child);
+      break;
+    case ART_NODE48:
+      add_child48((ARTNode48)node, ref, byte, child);
+      break;
+    default:
+      add_child256((ARTNode256)node, byte, child);
+      break;
+  }
+}
+
+static void remove_child256(ARTNode256 node, ARTChild* ref, unsigned char byte) {
+  node->children[byte] = NULL;
+  // shrink later than we grow, so a node at the threshold does not flip back and forth
+  if (--node->header.num_children > 37) return;
+
+  ARTNode48 smaller = (ARTNode48)art_node_new(ART_NODE48);
+  int slot = 0;
+  for (int i = 0; i < 256; i++) {
+    if (node->children[i]) {
+      smaller->children[slot] = node->children[i];
+      smaller->child_index[i] = ++slot;
+    }
+  }
+  copy_header(&smaller->header, &node->header);
+  *ref = smaller;
+  free(node);
+}
+
+static void remove_child48(ARTNode48 node, ARTChild* ref, unsigned char byte) {
+  node->children[node->child_index[byte] - 1] = NULL;
+  node->child_index[byte] = 0;
+  if (--node->header.num_children > 12) return;
+
+  ARTNode16 smaller = (ARTNode16)art_node_new(ART_NODE16);
+  int count = 0;
+  for (int i = 0; i < 256; i++) {
+    if (node->child_index[i]) {
+      smaller->keys[count] = i;
+      smaller->children[count++] = node->children[node->child_index[i] - 1];
+    }
+  }
+  copy_header(&smaller->header, &node->header);
+  *ref = smaller;
+  free(node);
+}
+
+static void remove_child16(ARTNode16 node, ARTChild* ref, ARTChild* child) {
+  int index = child - node->children;
+  int count = --node->header.num_children;
+  memmove(node->keys + index, node->keys + index + 1, count - index);
+  memmove(node->children + index, node->children + index + 1, (count - index) * sizeof(ARTChild));
+  if (count > 3) return;
+
+  ARTNode4 smaller = (ARTNode4)art_node_new(ART_NODE4);
+  memcpy(smaller->keys, node->keys, count);
+  memcpy(smaller->children, node->children, count * sizeof(ARTChild));
+  copy_header(&smaller->header, &node->header);
+  *ref = smaller;
+  free(node);
+}
+
+static void remove_child4(ARTNode4 node, ARTChild* ref, ARTChild* child) {
+  int index = child - node->children;
+  int count = --node->header.num_children;
+  memmove(node->keys + index, node->keys + index + 1, count - index);
+  memmove(node->children + index, node->children + index + 1, (count - index) * sizeof(ARTChild));
+  if (count > 1) return;
+
+  // a single remaining child absorbs this node's prefix and key byte
+  ARTChild only = node->children[0];
+  if (!is_leaf(only)) {
+    ARTNode next = only;
+    unsigned char prefix[ART_MAX_PREFIX_LEN];
+    uint32_t len = MIN(ART_MAX_PREFIX_LEN, node->header.prefix_len);
+    memcpy(prefix, node->header.prefix, len);
+    if (len < ART_MAX_PREFIX_LEN) prefix[len++] = node->keys[0];
+    if (len < ART_MAX_PREFIX_LEN) {
+      uint32_t rest = MIN(ART_MAX_PREFIX_LEN - len, next->prefix_len);
+      memcpy(prefix + len, next->prefix, rest);
+      len += rest;
+    }
+    memcpy(next->prefix, prefix, len);
+    next->prefix_len += node->header.prefix_len + 1;
+  }
+  *ref = only;
+  free(node);
+}
+
+static void remove_child(ARTNode node, ARTChild* ref, unsigned char byte, ARTChild* child) {
+  switch (node->type) {
+    case ART_NODE4:
+      remove_child4((ARTNode4)node, ref, child);
+      break;
+    case ART_NODE16:
+      remove_child16((ARTNode16)node, ref, child);
+      break;
+    case ART_NODE48:
+      remove_child48((ARTNode48)node, ref, byte);
+      break;
+    default:
+      remove_child256((ARTNode256)node, ref, byte);
+      break;
+  }
+}
+
+// --- Prefixes ---
+
+static ARTLeaf minimum_leaf(ARTChild child) {
+  while (!is_leaf(child)) {
+    ARTNode node = child;
+    switch (node->type) {
+      case ART_NODE4:
+        child = ((ARTNode4)node)->children[0];
+        break;
+      case ART_NODE16:
+        child = ((ARTNode16)node)->children[0];
+        break;
+      case ART_NODE48: {
+        int i = 0;
+        while (!((ARTNode48)node)->child_index[i]) i++;
+        child = ((ARTNode48)node)->children[((ARTNode48)node)->child_index[i] - 1];
+        break;
+      }
+      default: {
+        int i = 0;
+        while (!((ARTNode256)node)->children[i]) i++;
+        child = ((ARTNode256)node)->children[i];
+        break;
+      }
+    }
+  }
+  return as_leaf(child);
+}
+
+// Number of stored prefix bytes matching the key, optimistic: bytes past ART_MAX_PREFIX_LEN are not checked
+static uint32_t check_prefix(ARTNode node, const unsigned char* key, size_t key_len, size_t depth) {
+  uint32_t max_cmp = MIN(MIN(node->prefix_len, ART_MAX_PREFIX_LEN), key_len - depth);
+  uint32_t index = 0;
+  while (index < max_cmp && node->prefix[index] == key[depth + index]) index++;
+  return index;
+}
+
+// Exact length of the common prefix, reading the bytes past ART_MAX_PREFIX_LEN from the subtree's minimum leaf
+static uint32_t prefix_mismatch(ARTree tree, ARTNode node, const unsigned char* key, size_t key_len, size_t depth) {
+  uint32_t index = check_prefix(node, key, key_len, depth);
+  if (index < ART_MAX_PREFIX_LEN || node->prefix_len <= ART_MAX_PREFIX_LEN) return index;
+
+  ARTLeaf leaf = minimum_leaf(node);
+  const unsigned char* min_key = leaf_key(tree, leaf);
+  size_t max_cmp = MIN(leaf->key_len, key_len) - depth;
+  while (index < max_cmp && index < node->prefix_len && min_key[depth + index] == key[depth + index]) index++;
+  return index;
+}
+
+// --- Getters ---
+
+int art_get_size(ARTree tree) { return tree->size; }
+
+struct validation {
+  ARTree tree;
+  ARTLeaf previous;
+  bool valid;
+};
+
+static void art_node_is_valid(ARTChild child, struct validation* state) {
+  if (!state->valid || child == NULL) return;
+
+  if (is_leaf(child)) {
+    ARTLeaf leaf = as_leaf(child);
+    if (state->previous != NULL) {
+      ARTLeaf prev = state->previous;
+      int cmp = memcmp(leaf_key(state->tree, prev), leaf_key(state->tree, leaf), MIN(prev->key_len, leaf->key_len));
+      if (cmp >= 0) state->valid = false;  // keys must strictly increase and never be a prefix of each other
+    }
+    state->previous = leaf;
+    return;
+  }
+
+  ARTNode node = child;
+  int count = 0;
+  switch (node->type) {
+    case ART_NODE4:
+    case ART_NODE16: {
+      unsigned char* keys = node->type == ART_NODE4 ? ((ARTNode4)node)->keys : ((ARTNode16)node)->keys;
+      ARTChild* children = node->type == ART_NODE4 ? ((ARTNode4)node)->children : ((ARTNode16)node)->children;
+      if (node->num_children < 2) state->valid = false;
+      for (int i = 0; i < node->num_children; i++) {
+        if ((i > 0 && keys[i - 1] >= keys[i]) || children[i] == NULL) state->valid = false;
+        art_node_is_valid(children[i], state);
+      }
+      return;
+    }
+    case ART_NODE48:
+      for (int i = 0; i < 256; i++) {
+        int slot = ((ARTNode48)node)->child_index[i];
+        if (!slot) continue;
+        count++;
+        art_node_is_valid(((ARTNode48)node)->children[slot - 1], state);
+      }
+      break;
+    case ART_NODE256:
+      for (int i = 0; i < 256; i++) {
+        if (!((ARTNode256)node)->children[i]) continue;
+        count++;
+        art_node_is_valid(((ARTNode256)node)->children[i], state);
+      }
+      break;
+    default:
+      state->valid = false;
+      return;
+  }
+  if (count != node->num_children) state->valid = false;
+}
+
+bool art_is_valid(ARTree tree) {
+  struct validation state = {tree, NULL, true};
+  art_node_is_valid(tree->root, &state);
+  return state.valid;
+}
+
+// --- Insertion ---
+
+static bool art_node_add(ARTree tree, ARTChild* ref, const unsigned char* key, size_t key_len, size_t depth,
+                         const void* data) {
+  if (*ref == NULL) {
+    *ref = tag_leaf(art_leaf_new(tree, key, key_len, data));
+    return true;
+  }
+
+  if (is_leaf(*ref)) {
+    ARTLeaf leaf = as_leaf(*ref);
+    const unsigned char* other = leaf_key(tree, leaf);
+    size_t max_cmp = MIN(leaf->key_len, key_len);
+    size_t common = depth;
+    while (common < max_cmp && other[common] == key[common]) common++;
+    if (common == max_cmp) return false;  // duplicate, or one key is a prefix of the other
+
+    // split the leaf into a Node4 holding the common part of both keys as its prefix
+    ARTNode split = art_node_new(ART_NODE4);
+    split->prefix_len = common - depth;
+    memcpy(split->prefix, key + depth, MIN(ART_MAX_PREFIX_LEN, split->prefix_len));
+    ARTChild split_ref = split;
+    add_child(split, &split_ref, other[common], *ref);
+    add_child(split, &split_ref, key[common], tag_leaf(art_leaf_new(tree, key, key_len, data)));
+    *ref = split;
+    return true;
+  }
+
+  ARTNode node = *ref;
+  if (node->prefix_len) {
+    uint32_t mismatch = prefix_mismatch(tree, node, key, key_len, depth);
+    if (mismatch < node->prefix_len) {
+      if (depth + mismatch >= key_len) return false;  // key ends inside the compressed path
+
+      // split the compressed path where the key leaves it
+      ARTNode split = art_node_new(ART_NODE4);
+      split->prefix_len = mismatch;
+      memcpy(split->prefix, node->prefix, MIN(ART_MAX_PREFIX_LEN, mismatch));
+
+      unsigned char node_byte;
+      if (node->prefix_len <= ART_MAX_PREFIX_LEN) {
+        node_byte = node->prefix[mismatch];
+        node->prefix_len -= mismatch + 1;
+        memmove(node->prefix, node->prefix + mismatch + 1, MIN(ART_MAX_PREFIX_LEN, node->prefix_len));
+      } else {
+        const unsigned char* min_key = leaf_key(tree, minimum_leaf(node));
+        node_byte = min_key[depth + mismatch];
+        node->prefix_len -= mismatch + 1;
+        memcpy(node->prefix, min_key + depth + mismatch + 1, MIN(ART_MAX_PREFIX_LEN, node->prefix_len));
+      }
+
+      ARTChild split_ref = split;
+      add_child(split, &split_ref, node_byte, node);
+      add_child(split, &split_ref, key[depth + mismatch], tag_leaf(art_leaf_new(tree, key, key_len, data)));
+      *ref = split;
+      return true;
+    }
+    depth += node->prefix_len;
+  }
+
+  if (depth >= key_len) return false;  // key is a prefix of the keys below
+
+  ARTChild* child = find_child(node, key[depth]);
+  if (child != NULL) return art_node_add(tree, child, key, key_len, depth + 1, data);
+
+  add_child(node, ref, key[depth], tag_leaf(art_leaf_new(tree, key, key_len, data)));
+  return true;
+}
+
+bool art_add(ARTree tree, const void* key, size_t key_len, const void* data) {
+  if (!art_node_add(tree, &tree->root, key, key_len, 0, data)) return false;
+  tree->size++;
+  return true;
+}
+
+// --- Search ---
+
+static ARTLeaf art_find_leaf(ARTree tree, const unsigned char* key, size_t key_len) {
+  ARTChild child = tree->root;
+  size_t depth = 0;
+
+  while (child != NULL) {
+    if (is_leaf(child)) {
+      ARTLeaf leaf = as_leaf(child);
+      return leaf_matches(tree, leaf, key, key_len) ? leaf : NULL;
+    }
+
+    ARTNode node = child;
+    if (node->prefix_len) {
+      if (check_prefix(node, key, key_len, depth) != MIN(node->prefix_len, ART_MAX_PREFIX_LEN)) return NULL;
+      depth += node->prefix_len;
+    }
+    if (depth >= key_len) return NULL;
+
+    ARTChild* next = find_child(node, key[depth]);
+    child = next ? *next : NULL;
+    depth++;
+  }
+
+  return NULL;
+}
+
+void* art_find_data(ARTree tree, const void* key, size_t key_len) {
+  ARTLeaf leaf = art_find_leaf(tree, key, key_len);
+  return leaf ? leaf->data : NULL;
+}
+
+// --- Deletion ---
+
+static ARTLeaf art_node_remove(ARTree tree, ARTChild* ref, const unsigned char* key, size_t key_len, size_t depth) {
+  if (*ref == NULL) return NULL;
+
+  if (is_leaf(*ref)) {
+    ARTLeaf leaf = as_leaf(*ref);
+    if (!leaf_matches(tree, leaf, key, key_len)) return NULL;
+    *ref = NULL;  // only happens for a tree holding a single key
+    return leaf;
+  }
+
+  ARTNode node = *ref;
+  if (node->prefix_len) {
+    if (check_prefix(node, key, key_len, depth) != MIN(node->prefix_len, ART_MAX_PREFIX_LEN)) return NULL;
+    depth += node->prefix_len;
+  }
+  if (depth >= key_len) return NULL;
+
+  ARTChild* child = find_child(node, key[depth]);
+  if (child == NULL) return NULL;
+
+  if (is_leaf(*child)) {
+    ARTLeaf leaf = as_leaf(*child);
+    if (!leaf_matches(tree, leaf, key, key_len)) return NULL;
+    remove_child(node, ref, key[depth], child);
+    return leaf;
+  }
+
+  return art_node_remove(tree, child, key, key_len, depth + 1);
+}
+
+void art_remove(ARTree tree, const void* key, size_t key_len) {
+  ARTLeaf leaf = art_node_remove(tree, &tree->root, key, key_len, 0);
+  if (leaf == NULL) return;
+
+  delete_leaf(leaf, tree->delete_data);
+  tree->size--;
+}
+
+// --- Iteration ---
+
+static void art_node_foreach(ARTree tree, ARTChild child,
+                             void (*func)(const void* key, size_t key_len, void* data, void* arg), void* arg) {
+  if (is_leaf(child)) {
+    ARTLeaf leaf = as_leaf(child);
+    func(leaf_key(tree, leaf), leaf->key_len, leaf->data, arg);
+    return;
+  }
+
+  ARTNode node = child;
+  switch (node->type) {
+    case ART_NODE4:
+      for (int i = 0; i < node->num_children; i++) art_node_foreach(tree, ((ARTNode4)node)->children[i], func, arg);
+      break;
+    case ART_NODE16:
+      for (int i = 0; i < node->num_children; i++) art_node_foreach(tree, ((ARTNode16)node)->children[i], func, arg);
+      break;
+    case ART_NODE48:
+      for (int i = 0; i < 256; i++) {
+        int slot = ((ARTNode48)node)->child_index[i];
+        if (slot) art_node_foreach(tree, ((ARTNode48)node)->children[slot - 1], func, arg);
+      }
+      break;
+    default:
+      for (int i = 0; i < 256; i++) {
+        if (((ARTNode256)node)->children[i]) art_node_foreach(tree, ((ARTNode256)node)->children[i], func, arg);
+      }
+      break;
+  }
+}
+
+void art_foreach(ARTree tree, void (*func)(const void* key, size_t key_len, void* data, void* arg), void* arg) {
+  if (tree->root == NULL) return;
+  art_node_foreach(tree, tree->root, func, arg);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file adaptive-radix-tree.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief Adaptive radix tree type, mapping byte-string keys to data ordered by memcmp of the keys.
+ *
+ * Keys of a tree must be prefix-free: no key may be a prefix of another one. Fixed-size keys like the encoded integers
+ * below, or strings including their terminating NUL, always are.
+ */
+typedef struct _ARTree* ARTree;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new adaptive radix tree.
+ *
+ * @param size Size of the data stored with each key in bytes.
+ * @param del Deletion function for the data.
+ * @return The newly created adaptive radix tree.
+ */
+extern ARTree art_new(size_t size, void (*del)(void*));
+
+/**
+ * @brief Delete an adaptive radix tree, freeing all associated memory.
+ *
+ * @param tree The adaptive radix tree to be deleted.
+ */
+extern void art_delete(ARTree tree);
+
+// --- Keys ---
+
+/**
+ * @brief Encode a 32-bit integer as a big-endian key, so that byte order matches numeric order.
+ *
+ * @param value The integer to encode.
+ * @param key Buffer of 4 bytes receiving the key.
+ */
+extern void art_key_from_u32(uint32_t value, unsigned char key[4]);
+
+/**
+ * @brief Encode a 64-bit integer as a big-endian key, so that byte order matches numeric order.
+ *
+ * @param value The integer to encode.
+ * @param key Buffer of 8 bytes receiving the key.
+ */
+extern void art_key_from_u64(uint64_t value, unsigned char key[8]);
+
+// --- Getters ---
+
+/**
+ * @brief Get the number of keys in the adaptive radix tree.
+ *
+ * @param tree The adaptive radix tree.
+ * @return The number of keys.
+ */
+extern int art_get_size(ARTree tree);
+
+/**
+ * @brief Check if the adaptive radix tree is valid (consistent inner nodes and keys in ascending order).
+ *
+ * @param tree The adaptive radix tree to be checked.
+ * @return true if the tree is valid, false otherwise.
+ */
+extern bool art_is_valid(ARTree tree);
+
+// --- Insertion ---
+
+/**
+ * @brief Add a key and its data to the adaptive radix tree.
+ *
+ * @param tree The adaptive radix tree where data will be inserted.
+ * @param key Pointer to the key bytes.
+ * @param key_len Length of the key in bytes.
+ * @param data Pointer to the data to be inserted.
+ * @return true if the key was inserted, false if it was already present or would break the prefix-free rule.
+ */
+extern bool art_add(ARTree tree, const void* key, size_t key_len, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove a key and its data from the adaptive radix tree.
+ *
+ * @param tree The adaptive radix tree from which data will be removed.
+ * @param key Pointer to the key bytes.
+ * @param key_len Length of the key in bytes.
+ */
+extern void art_remove(ARTree tree, const void* key, size_t key_len);
+
+// --- Search ---
+
+/**
+ * @brief Find the data stored with a key, without any comparison function call.
+ *
+ * @param tree The adaptive radix tree to search.
+ * @param key Pointer to the key bytes.
+ * @param key_len Length of the key in bytes.
+ * @return Pointer to the found data, or NULL if not found.
+ */
+extern void* art_find_data(ARTree tree, const void* key, size_t key_len);
+
+// --- Iteration ---
+
+/**
+ * @brief Call a function on every key and its data, in ascending key order.
+ *
+ * @param tree The adaptive radix tree to traverse.
+ * @param func Function called with each key, its length, its data and the user argument.
+ * @param arg User argument passed to func.
+ */
+extern void art_foreach(ARTree tree, void (*func)(const void* key, size_t key_len, void* data, void* arg), void* arg);
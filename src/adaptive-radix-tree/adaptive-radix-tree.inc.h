@@ -0,0 +1,62 @@
+/**
+ * @file adaptive-radix-tree.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ART_MAX_PREFIX_LEN 8
+
+// Child pointers are tagged, a set lowest bit means the child is an ARTLeaf
+typedef void* ARTChild;
+typedef struct _ARTLeaf* ARTLeaf;
+
+enum { ART_NODE4 = 1, ART_NODE16, ART_NODE48, ART_NODE256 };
+
+// Only the first ART_MAX_PREFIX_LEN bytes of a compressed path are stored, longer ones are checked against a leaf
+struct _ARTNode {
+  uint8_t type;
+  uint16_t num_children;
+  uint32_t prefix_len;
+  unsigned char prefix[ART_MAX_PREFIX_LEN];
+};
+
+struct _ARTNode4 {
+  struct _ARTNode header;
+  unsigned char keys[4];  // sorted
+  ARTChild children[4];
+};
+
+struct _ARTNode16 {
+  struct _ARTNode header;
+  unsigned char keys[16];  // sorted, searched with SIMD
+  ARTChild children[16];
+};
+
+struct _ARTNode48 {
+  struct _ARTNode header;
+  unsigned char child_index[256];  // slot + 1 in children, 0 if absent
+  ARTChild children[48];
+};
+
+struct _ARTNode256 {
+  struct _ARTNode header;
+  ARTChild children[256];
+};
+
+struct _ARTLeaf {
+  size_t key_len;
+  char data[1];  // data_size bytes of data, followed by the key
+};
+
+struct _ARTree {
+  ARTChild root;
+  size_t data_size;
+  int size;
+  void (*delete_data)(void* data);
+};
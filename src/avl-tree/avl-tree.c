@@ -7,63 +7,559 @@
 
 #include "avl-tree.h"
 
-#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../min-max.h"
+#include "../trace.h"
 #include "avl-tree.inc.h"
 
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
+// --- Bloom Filter ---
+
+// Finalizer of splitmix64, so user hashes with poor low or high bits still spread over blocks, bits and entries
+static uint64_t avl_mix_hash(uint64_t hash) {
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+// The block is picked by the mixed hash, the bits inside it by double hashing on a second mix
+static bool avl_filter_probe(const struct avl_filter* filter, const void* key, bool set) {
+  uint64_t hash = avl_mix_hash(filter->hash(key));
+  uint64_t* block = filter->blocks + (hash >> 32) % filter->block_count * AVL_FILTER_BLOCK_WORDS;
+  uint64_t bits = avl_mix_hash(hash);
+  uint32_t position = (uint32_t)bits;
+  uint32_t step = (uint32_t)(bits >> 32) | 1;
+  bool present = true;
+  for (int i = 0; i < filter->hash_count; i++, position += step) {
+    uint32_t bit = position >> 23;  // 9 bits, one of the 512 of the block
+    uint64_t mask = 1ULL << (bit % 64);
+    if (set) {
+      block[bit / 64] |= mask;
+    } else if (!(block[bit / 64] & mask)) {
+      present = false;
+      break;
+    }
+  }
+  return present;
+}
+
+static void avl_filter_add_subtree(struct avl_filter* filter, AVLNode node) {
+  if (node == NULL) return;
+  avl_filter_probe(filter, node->data, true);
+  filter->count++;
+  avl_filter_add_subtree(filter, node->left);
+  avl_filter_add_subtree(filter, node->right);
+}
+
+// Replaces the filter by one sized for capacity elements holding every element of the tree, the filter is kept as is
+// if the new one cannot be allocated
+static int avl_filter_build(AVLTree tree, size_t capacity, size_t (*hash)(const void*), size_t bits_per_element) {
+  const size_t block_bits = AVL_FILTER_BLOCK_WORDS * 64;
+  const size_t block_bytes = AVL_FILTER_BLOCK_WORDS * sizeof(uint64_t);
+  struct avl_filter filter = tree->filter;
+  filter.capacity = MAX(capacity, (size_t)AVL_FILTER_MIN_CAPACITY);
+  filter.block_count = (filter.capacity * bits_per_element + block_bits - 1) / block_bits;
+  filter.allocation = tree->allocator.alloc(tree->allocator.ctx, filter.block_count * block_bytes + AVL_CACHE_LINE);
+  if (!filter.allocation) return ENOMEM;
+  filter.blocks = (uint64_t*)(((uintptr_t)filter.allocation + AVL_CACHE_LINE - 1) & ~(uintptr_t)(AVL_CACHE_LINE - 1));
+  memset(filter.blocks, 0, filter.block_count * block_bytes);
+  filter.bits_per_element = bits_per_element;
+  filter.hash_count = (int)MIN(MAX((bits_per_element * 69 + 50) / 100, 1), AVL_FILTER_MAX_HASHES);  // ln(2) per bit
+  filter.hash = hash;
+  filter.count = 0;
+  avl_filter_add_subtree(&filter, tree->root);
+
+  if (tree->filter.allocation) {
+    tree->allocator.free(tree->allocator.ctx, tree->filter.allocation);
+    filter.rebuilds++;
+  }
+  tree->filter = filter;
+  return 0;
+}
+
+// Called on every new node, before it is linked: a full filter is first rebuilt twice as large from the tree. If that
+// fails, the node is added to the full filter anyway, which only raises its false-positive rate.
+static void avl_filter_add(AVLTree tree, AVLNode node) {
+  struct avl_filter* filter = &tree->filter;
+  if (filter->blocks == NULL) return;
+  if (filter->count >= filter->capacity) {
+    avl_filter_build(tree, 2 * filter->capacity, filter->hash, filter->bits_per_element);
+  }
+  avl_filter_probe(filter, node->data, true);
+  filter->count++;
+}
+
+// Called after removals: bits cannot be cleared, so once removed elements outnumber the remaining ones the filter is
+// rebuilt from the tree, for twice its size like a fresh one
+static void avl_filter_shrink(AVLTree tree) {
+  struct avl_filter* filter = &tree->filter;
+  if (filter->blocks == NULL) return;
+  size_t removed = filter->count - tree->node_count;
+  if (removed <= MAX(tree->node_count, (size_t)AVL_FILTER_MIN_CAPACITY)) return;
+  avl_filter_build(tree, 2 * tree->node_count, filter->hash, filter->bits_per_element);
+}
+
+// false when key is certainly absent, the lookup is then counted as rejected
+static bool avl_filter_admits(AVLTree tree, const void* key) {
+  struct avl_filter* filter = &tree->filter;
+  if (filter->blocks == NULL) return true;
+  filter->lookups++;
+  if (avl_filter_probe(filter, key, false)) return true;
+  filter->rejected++;
+  return false;
+}
+
+int avl_set_filter(AVLTree tree, size_t (*hash)(const void* key), size_t bits_per_element) {
+  if (hash == NULL) {
+    if (tree->filter.allocation) tree->allocator.free(tree->allocator.ctx, tree->filter.allocation);
+    tree->filter = (struct avl_filter){0};
+    return 0;
+  }
+  if (bits_per_element == 0 || tree->small) return EINVAL;
+  return avl_filter_build(tree, 2 * tree->node_count, hash, bits_per_element);
+}
+
+void avl_get_filter_stats(AVLTree tree, AVLFilterStats* out) {
+  const struct avl_filter* filter = &tree->filter;
+  *out = (AVLFilterStats){0};
+  if (filter->blocks == NULL) return;
+
+  size_t words = filter->block_count * AVL_FILTER_BLOCK_WORDS;
+  size_t set_bits = 0;
+  for (size_t i = 0; i < words; i++) {
+    for (uint64_t word = filter->blocks[i]; word != 0; word &= word - 1) set_bits++;
+  }
+  out->bytes = words * sizeof(uint64_t) + AVL_CACHE_LINE;
+  out->elements = filter->count;
+  out->lookups = filter->lookups;
+  out->rejected = filter->rejected;
+  out->false_positives = filter->false_positives;
+  out->rebuilds = filter->rebuilds;
+  out->expected_fpr = 1;  // a lookup passes when all its bits are set
+  for (int i = 0; i < filter->hash_count; i++) {
+    out->expected_fpr *= (double)set_bits / (double)(words * 64);
+  }
+  if (filter->rejected + filter->false_positives > 0) {
+    out->measured_fpr = (double)filter->false_positives / (double)(filter->rejected + filter->false_positives);
+  }
+}
+
+// --- Lookup Cache ---
+
+static struct avl_lookup_entry* avl_cache_entry(AVLTree tree, uint64_t tag) {
+  return &tree->cache.entries[tag & tree->cache.mask];
+}
+
+// Cached node holding key, counted as a hit, or NULL
+static AVLNode avl_cache_find(AVLTree tree, const void* key, uint64_t tag) {
+  tree->cache.lookups++;
+  struct avl_lookup_entry* entry = avl_cache_entry(tree, tag);
+  if (entry->node == NULL || entry->tag != tag || tree->compare(key, entry->node->data) != 0) return NULL;
+  tree->cache.hits++;
+  return entry->node;
+}
+
+// Called before a node is freed, while its data can still be hashed
+static void avl_cache_forget(AVLTree tree, AVLNode node) {
+  if (tree->cache.entries == NULL) return;
+  struct avl_lookup_entry* entry = avl_cache_entry(tree, avl_mix_hash(tree->cache.hash(node->data)));
+  if (entry->node != node) return;
+  entry->node = NULL;
+  tree->cache.invalidations++;
+}
+
+// Called when compaction copied node to moved
+static void avl_cache_move(AVLTree tree, AVLNode node, AVLNode moved) {
+  if (tree->cache.entries == NULL) return;
+  struct avl_lookup_entry* entry = avl_cache_entry(tree, avl_mix_hash(tree->cache.hash(moved->data)));
+  if (entry->node == node) entry->node = moved;
+}
+
+int avl_set_cache(AVLTree tree, size_t (*hash)(const void* key), size_t entries) {
+  if (hash != NULL && (entries == 0 || tree->small)) return EINVAL;
+
+  struct avl_lookup_cache cache = {0};
+  if (hash != NULL) {
+    size_t count = AVL_LOOKUP_CACHE_LINE_ENTRIES;
+    while (count < entries) count *= 2;
+    size_t bytes = count * sizeof(struct avl_lookup_entry);
+    cache.allocation = tree->allocator.alloc(tree->allocator.ctx, bytes + AVL_CACHE_LINE);
+    if (!cache.allocation) return ENOMEM;
+    uintptr_t aligned = ((uintptr_t)cache.allocation + AVL_CACHE_LINE - 1) & ~(uintptr_t)(AVL_CACHE_LINE - 1);
+    cache.entries = (struct avl_lookup_entry*)aligned;
+    memset(cache.entries, 0, bytes);
+    cache.mask = count - 1;
+    cache.hash = hash;
+  }
+
+  if (tree->cache.allocation) tree->allocator.free(tree->allocator.ctx, tree->cache.allocation);
+  tree->cache = cache;
+  return 0;
+}
+
+void avl_get_cache_stats(AVLTree tree, AVLCacheStats* out) {
+  const struct avl_lookup_cache* cache = &tree->cache;
+  *out = (AVLCacheStats){0};
+  if (cache->entries == NULL) return;
+
+  out->entries = cache->mask + 1;
+  out->bytes = out->entries * sizeof(struct avl_lookup_entry) + AVL_CACHE_LINE;
+  out->lookups = cache->lookups;
+  out->hits = cache->hits;
+  out->invalidations = cache->invalidations;
+  if (cache->lookups > 0) out->hit_rate = (double)cache->hits / (double)cache->lookups;
+}
+
+// --- Merkle Hashes ---
+
+// A subtree hash is the sum of the mixed hashes of its records, so it does not depend on the shape of the subtree
+static uint64_t* avl_node_merkle(AVLTree tree, AVLNode node) {
+  return (uint64_t*)((char*)node + tree->merkle_offset);
+}
+
+static uint64_t avl_subtree_merkle(AVLTree tree, AVLNode node) { return node ? *avl_node_merkle(tree, node) : 0; }
+
+// The golden ratio increment of splitmix64 keeps records hashing to 0 from vanishing from the sums
+static uint64_t avl_record_merkle(AVLTree tree, const void* data) {
+  return avl_mix_hash(tree->merkle_hash(data) + 0x9e3779b97f4a7c15ULL);
+}
+
+int avl_set_merkle(AVLTree tree, size_t (*hash)(const void* data)) {
+  if (tree->root != NULL || tree->record_size != NULL || tree->small != NULL) return EINVAL;
+
+  if (hash != NULL && tree->merkle_offset == 0) {
+    const size_t align = _Alignof(uint64_t);
+    tree->merkle_offset = (tree->node_size + align - 1) / align * align;
+    tree->node_size = tree->merkle_offset + sizeof(uint64_t);
+  } else if (hash == NULL && tree->merkle_offset != 0) {
+    tree->node_size = tree->merkle_offset;
+    tree->merkle_offset = 0;
+  }
+  tree->merkle_hash = hash;
+  return 0;
+}
+
+size_t avl_get_merkle_hash(AVLTree tree) { return tree->merkle_hash ? avl_subtree_merkle(tree, tree->root) : 0; }
+
+// Sum of the hashes of the records below bound, or up to it when inclusive
+static uint64_t avl_merkle_below(AVLTree tree, const void* bound, bool inclusive) {
+  uint64_t sum = 0;
+  AVLNode node = tree->root;
+  while (node != NULL) {
+    int cmp = tree->compare(node->data, bound);
+    if (cmp < 0 || (inclusive && cmp == 0)) {
+      sum += avl_subtree_merkle(tree, node) - avl_subtree_merkle(tree, node->right);  // left subtree and node
+      node = node->right;
+    } else {
+      node = node->left;
+    }
+  }
+  return sum;
+}
+
+// Sum of the hashes of the records between lo and hi (both excluded, NULL for no bound), in O(log n)
+static uint64_t avl_merkle_range(AVLTree tree, const void* lo, const void* hi) {
+  uint64_t sum = hi ? avl_merkle_below(tree, hi, false) : avl_subtree_merkle(tree, tree->root);
+  return lo ? sum - avl_merkle_below(tree, lo, true) : sum;
+}
+
+struct avl_diff {
+  AVLTree a;
+  AVLTree b;
+  void (*func)(const void* a_data, const void* b_data, void* arg);
+  void* arg;
+};
+
+// Reports the records of b's subtree between lo and hi (both excluded), which are known to be missing from a
+static void avl_diff_only_b(struct avl_diff* diff, AVLNode node, const void* lo, const void* hi) {
+  if (node == NULL) return;
+
+  bool above_lo = lo == NULL || diff->b->compare(node->data, lo) > 0;
+  bool below_hi = hi == NULL || diff->b->compare(node->data, hi) < 0;
+  if (above_lo) avl_diff_only_b(diff, node->left, lo, hi);
+  if (above_lo && below_hi) diff->func(NULL, node->data, diff->arg);
+  if (below_hi) avl_diff_only_b(diff, node->right, lo, hi);
+}
+
+// Diffs the subtree of a against the records of b between its bounds in a, lo and hi (both excluded). Subtrees holding
+// the same records as their range in b are skipped after a single range hash, whatever the shape of b.
+static void avl_diff_node(struct avl_diff* diff, AVLNode node, const void* lo, const void* hi) {
+  if (avl_subtree_merkle(diff->a, node) == avl_merkle_range(diff->b, lo, hi)) return;
+  if (node == NULL) {
+    avl_diff_only_b(diff, diff->b->root, lo, hi);
+    return;
+  }
+
+  avl_diff_node(diff, node->left, lo, node->data);
+  AVLNode match = avl_find_node(diff->b, node->data);
+  if (match == NULL) {
+    diff->func(node->data, NULL, diff->arg);
+  } else {
+    uint64_t match_hash = avl_subtree_merkle(diff->b, match) - avl_subtree_merkle(diff->b, match->left) -
+                          avl_subtree_merkle(diff->b, match->right);
+    if (avl_record_merkle(diff->a, node->data) != match_hash) diff->func(node->data, match->data, diff->arg);
+  }
+  avl_diff_node(diff, node->right, node->data, hi);
+}
+
+int avl_diff(AVLTree a, AVLTree b, void (*func)(const void* a_data, const void* b_data, void* arg), void* arg) {
+  if (a->merkle_hash == NULL || b->merkle_hash == NULL) return EINVAL;
+
+  struct avl_diff diff = {a, b, func, arg};
+  avl_diff_node(&diff, a->root, NULL, NULL);
+  return 0;
+}
+
 // --- Constructor and Destructor ---
 
-static AVLNode avl_node_new(const void* data, size_t size) {
-  AVLNode node = malloc(3 * sizeof(AVLNode) + sizeof(int) + size);
-  if (!node) {
-    perror("Out of memory");
-    exit(EXIT_FAILURE);
+static void* avl_node_aggregate(AVLTree tree, AVLNode node) { return (char*)node + tree->augment_offset; }
+
+// Aggregate of a possibly empty subtree
+static const void* avl_subtree_aggregate(AVLTree tree, AVLNode node) {
+  return node ? avl_node_aggregate(tree, node) : tree->augment.identity;
+}
+
+// Recomputes the height and aggregate of a node from its children, which must already be up to date
+static void avl_node_update(AVLTree tree, AVLNode node) {
+  node->height = 1 + MAX(avl_node_get_height(node->left), avl_node_get_height(node->right));
+  if (tree->augment.compute) {
+    tree->augment.compute(avl_node_aggregate(tree, node), node->data, avl_subtree_aggregate(tree, node->left),
+                          avl_subtree_aggregate(tree, node->right));
+  }
+  if (tree->merkle_hash) {
+    *avl_node_merkle(tree, node) = avl_record_merkle(tree, node->data) + avl_subtree_merkle(tree, node->left) +
+                                   avl_subtree_merkle(tree, node->right);
+  }
+}
+
+static void* default_alloc(void* ctx, size_t size) { return malloc(size); }
+
+static void default_free(void* ctx, void* ptr) { free(ptr); }
+
+// Map nodes start on a cache line, so the links and the key that follows them are read together
+static void* cache_aligned_alloc(void* ctx, size_t size) {
+  return aligned_alloc(AVL_CACHE_LINE, (size + AVL_CACHE_LINE - 1) / AVL_CACHE_LINE * AVL_CACHE_LINE);
+}
+
+// Variable-length nodes are preceded by a header holding the record prefix and, right before the node, its length
+static size_t* avl_node_length(AVLNode node) { return (size_t*)node - 1; }
+
+static unsigned char* avl_node_prefix(AVLTree tree, AVLNode node) { return (unsigned char*)node - tree->header_size; }
+
+// First prefix_size bytes of a record, zero padded when the record is shorter
+static void avl_record_prefix(AVLTree tree, const void* data, size_t length, unsigned char* prefix) {
+  size_t copied = MIN(length, tree->prefix_size);
+  memcpy(prefix, data, copied);
+  memset(prefix + copied, 0, tree->prefix_size - copied);
+}
+
+// Prefix of a searched record, computed once per operation
+static const unsigned char* avl_key_prefix(AVLTree tree, const void* data, unsigned char* prefix) {
+  if (tree->prefix_size == 0) return NULL;
+  avl_record_prefix(tree, data, tree->record_size(data), prefix);
+  return prefix;
+}
+
+// Differing prefixes settle the order without reading the record, only equal ones call the comparison function
+static int avl_compare_node(AVLTree tree, const void* data, const unsigned char* prefix, AVLNode node) {
+  if (prefix != NULL) {
+    int cmp = memcmp(prefix, avl_node_prefix(tree, node), tree->prefix_size);
+    if (cmp != 0) return cmp;
+  }
+  return tree->compare(data, node->data);
+}
+
+// Size of the allocation holding a node, its header included
+static size_t avl_node_block_size(AVLTree tree, AVLNode node) {
+  if (tree->record_size == NULL) return tree->node_size;
+  return tree->header_size + offsetof(struct _TreeNode, data) + *avl_node_length(node);
+}
+
+// Bytes a node of the given block size takes in a compacted region
+static size_t avl_node_stride(AVLTree tree, size_t block_size) {
+  return (block_size + tree->node_align - 1) / tree->node_align * tree->node_align;
+}
+
+static bool avl_in_region(const char* region, size_t region_size, const void* ptr) {
+  return region != NULL && (uintptr_t)ptr >= (uintptr_t)region && (uintptr_t)ptr < (uintptr_t)region + region_size;
+}
+
+// Nodes inside a compacted region are only freed with the whole region
+static void avl_free_block(AVLTree tree, AVLNode node) {
+  char* block = (char*)node - tree->header_size;
+  if (avl_in_region(tree->region, tree->region_size, block)) return;
+  if (avl_in_region(tree->next_region, tree->next_region_size, block)) return;
+  tree->allocator.free(tree->allocator.ctx, block);
+}
+
+// value is NULL when data already holds the whole record, otherwise data is only the key
+static AVLNode avl_node_new(AVLTree tree, const void* data, const void* value) {
+  size_t length = tree->record_size ? tree->record_size(data) : tree->data_size;
+  size_t size = tree->record_size ? tree->header_size + offsetof(struct _TreeNode, data) + length : tree->node_size;
+  char* block = tree->allocator.alloc(tree->allocator.ctx, size);
+  if (!block) {
+    return NULL;
   }
+  tree->node_count++;
+  tree->node_bytes += avl_node_stride(tree, size);
+  AVLNode node = (AVLNode)(block + tree->header_size);
   node->left = NULL;
   node->right = NULL;
-  node->height = 1;
-  memcpy(node->data, data, size);
+  if (tree->record_size) {
+    *avl_node_length(node) = length;
+    avl_record_prefix(tree, data, length, avl_node_prefix(tree, node));
+  }
+  if (value == NULL) {
+    memcpy(node->data, data, length);
+  } else {
+    memcpy(node->data, data, tree->key_size);
+    memcpy(node->data + tree->key_size, value, tree->data_size - tree->key_size);
+  }
+  avl_node_update(tree, node);
+  avl_filter_add(tree, node);
   return node;
 }
 
 AVLTree avl_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
-  AVLTree tree =
-      malloc(sizeof(void*) + sizeof(size_t) + sizeof(int (*)(const void*, const void*)) + sizeof(void (*)(void*)));
+  return avl_new_with_allocator(size, cmp, del, NULL, NULL);
+}
+
+AVLTree avl_new_augmented(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*),
+                          const AVLAugment* augment) {
+  return avl_new_with_allocator(size, cmp, del, augment, NULL);
+}
+
+AVLTree avl_new_map(size_t key_size, size_t value_size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  return avl_new_map_with_allocator(key_size, value_size, cmp, del, NULL);
+}
+
+AVLTree avl_new_map_with_allocator(size_t key_size, size_t value_size, int (*cmp)(const void*, const void*),
+                                   void (*del)(void*), const AVLAllocator* allocator) {
+  AVLAllocator aligned = {cache_aligned_alloc, default_free, NULL};
+  AVLTree tree = avl_new_with_allocator(key_size + value_size, cmp, del, NULL, allocator ? allocator : &aligned);
+  if (tree) {
+    tree->key_size = key_size;
+    tree->node_align = AVL_CACHE_LINE;
+  }
+  return tree;
+}
+
+AVLTree avl_new_variable(size_t prefix_size, size_t (*record_size)(const void*), int (*cmp)(const void*, const void*),
+                         void (*del)(void*)) {
+  if (prefix_size > AVL_MAX_PREFIX) return NULL;
+  AVLTree tree = avl_new_with_allocator(0, cmp, del, NULL, NULL);
+  if (tree) {
+    const size_t align = _Alignof(struct _TreeNode);
+    tree->record_size = record_size;
+    tree->prefix_size = prefix_size;
+    tree->header_size = (prefix_size + sizeof(size_t) + align - 1) / align * align;
+  }
+  return tree;
+}
+
+AVLTree avl_new_with_allocator(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*),
+                               const AVLAugment* augment, const AVLAllocator* allocator) {
+  AVLAllocator alloc = allocator ? *allocator : (AVLAllocator){default_alloc, default_free, NULL};
+  AVLTree tree = alloc.alloc(alloc.ctx, sizeof(struct _AVLTree));
   if (!tree) {
-    perror("Out of memory");
-    exit(EXIT_FAILURE);
+    return NULL;
   }
 
+  tree->allocator = alloc;
   tree->data_size = size;
+  tree->key_size = size;
   tree->compare = cmp;
   tree->delete_data = del;
   tree->root = NULL;
+  tree->min = NULL;
+  tree->max = NULL;
+  tree->node_size = offsetof(struct _TreeNode, data) + size;
+  tree->augment_offset = 0;
+  tree->augment = (AVLAugment){0};
+  tree->augment_scratch = NULL;
+  tree->merkle_offset = 0;
+  tree->merkle_hash = NULL;
+  tree->record_size = NULL;
+  tree->prefix_size = 0;
+  tree->header_size = 0;
+  tree->node_align = _Alignof(struct _TreeNode);
+  tree->node_count = 0;
+  tree->node_bytes = 0;
+  tree->rotations = 0;
+  tree->filter = (struct avl_filter){0};
+  tree->cache = (struct avl_lookup_cache){0};
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  tree->region = NULL;
+  tree->region_size = 0;
+  tree->next_region = NULL;
+  tree->next_region_size = 0;
+  tree->next_region_used = 0;
+  tree->cursor = NULL;
+
+  if (augment != NULL) {
+    const size_t align = _Alignof(max_align_t);
+    // the identity is followed by the scratch aggregates of range queries, so they never allocate
+    const size_t stride = (augment->size + align - 1) / align * align;
+    char* identity = alloc.alloc(alloc.ctx, 4 * stride);
+    if (!identity) {
+      alloc.free(alloc.ctx, tree);
+      return NULL;
+    }
+    memcpy(identity, augment->identity, augment->size);
+
+    tree->augment = *augment;
+    tree->augment.identity = identity;
+    tree->augment_scratch = identity + stride;
+    tree->augment_offset = (tree->node_size + align - 1) / align * align;
+    tree->node_size = tree->augment_offset + augment->size;
+    tree->node_align = align;
+  }
 
   return tree;
 }
 
-static void delete_node(AVLNode node, void del(void*), bool del_data) {
+// An adaptive tree keeps its records in its array until there are more than small_capacity of them
+static bool avl_is_small(AVLTree tree) { return tree->small != NULL && tree->root == NULL; }
+
+static char* avl_small_record(AVLTree tree, size_t i) { return tree->small + i * tree->data_size; }
+
+static void delete_node(AVLTree tree, AVLNode node, bool del_data) {
   if (!node) {
     return;
   }
 
-  if (del && del_data) {
-    del(node->data);
+  tree->node_count--;
+  tree->node_bytes -= avl_node_stride(tree, avl_node_block_size(tree, node));
+  if (node == tree->cursor) tree->cursor = NULL;  // the next compaction step starts over from the first node
+  avl_cache_forget(tree, node);
+  if (tree->delete_data && del_data) {
+    tree->delete_data(node->data);
   }
-  free(node);
+  avl_free_block(tree, node);
 }
 
-static void delete_all_nodes(AVLNode node, void del(void*)) {
+// Returns the number of nodes freed
+static size_t delete_all_nodes(AVLTree tree, AVLNode node) {
   if (node == NULL) {
-    return;
+    return 0;
   }
 
-  delete_all_nodes(node->left, del);
-  delete_all_nodes(node->right, del);
-  delete_node(node, del, true);
+  size_t count = delete_all_nodes(tree, node->left) + delete_all_nodes(tree, node->right);
+  delete_node(tree, node, true);
+  return count + 1;
 }
 
 void avl_delete(AVLTree tree) {
@@ -71,16 +567,80 @@ void avl_delete(AVLTree tree) {
     return;
   }
 
-  delete_all_nodes(tree->root, tree->delete_data);
-  free(tree);
+  for (size_t i = 0; avl_is_small(tree) && tree->delete_data && i < tree->node_count; i++) {
+    tree->delete_data(avl_small_record(tree, i));
+  }
+  delete_all_nodes(tree, tree->root);
+  if (tree->region) tree->allocator.free(tree->allocator.ctx, tree->region);
+  if (tree->next_region) tree->allocator.free(tree->allocator.ctx, tree->next_region);
+  if (tree->augment.identity) tree->allocator.free(tree->allocator.ctx, (void*)tree->augment.identity);
+  if (tree->filter.allocation) tree->allocator.free(tree->allocator.ctx, tree->filter.allocation);
+  if (tree->cache.allocation) tree->allocator.free(tree->allocator.ctx, tree->cache.allocation);
+  if (tree->small) tree->allocator.free(tree->allocator.ctx, tree->small);
+  tree->allocator.free(tree->allocator.ctx, tree);
+}
+
+static void* avl_delete_thread(void* tree) {
+  avl_delete(tree);
+  return NULL;
+}
+
+int avl_delete_async(AVLTree tree) {
+  if (!tree) return 0;
+
+  pthread_attr_t attr;
+  int error = pthread_attr_init(&attr);
+  if (!error) {
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    error = pthread_create(&thread, &attr, avl_delete_thread, tree);
+    pthread_attr_destroy(&attr);
+  }
+  if (error) avl_delete(tree);
+  return error;
+}
+
+bool avl_delete_step(AVLTree tree, size_t max_nodes) {
+  if (avl_is_small(tree)) {  // the records of a small tree are deleted at once, there are few of them
+    avl_delete(tree);
+    return true;
+  }
+  if (tree->cache.allocation) {  // nothing is looked up anymore, nodes need not be dropped from it one by one
+    tree->allocator.free(tree->allocator.ctx, tree->cache.allocation);
+    tree->cache = (struct avl_lookup_cache){0};
+  }
+
+  // root holds what remains of the tree, whose leftmost node is freed once it has no left child
+  for (size_t i = 0; i < max_nodes && tree->root != NULL; i++) {
+    AVLNode node = tree->root;
+    if (node->left != NULL) {
+      AVLNode left = node->left;
+      node->left = left->right;
+      left->right = node;
+      tree->root = left;
+    } else {
+      tree->root = node->right;
+      delete_node(tree, node, true);
+    }
+  }
+  if (tree->root != NULL) return false;
+
+  tree->min = NULL;
+  tree->max = NULL;
+  avl_delete(tree);
+  return true;
 }
 
+// Defined with the small mode, getters returning nodes first move the records of small trees into nodes
+static bool avl_small_pin(AVLTree tree);
+
 // --- Getters ---
 
 AVLNode avl_get_root(AVLTree tree) {
   if (tree == NULL) {
     return NULL;
   }
+  if (!avl_small_pin(tree)) return NULL;
   return tree->root;
 }
 
@@ -88,6 +648,13 @@ int avl_get_height(AVLTree tree) {
   if (tree == NULL) {
     return 0;
   }
+  if (avl_is_small(tree)) {  // height of a balanced tree of the records
+    int height = 0;
+    for (size_t count = tree->node_count; count > 0; count /= 2) {
+      height++;
+    }
+    return height;
+  }
   return avl_node_get_height(tree->root);
 }
 
@@ -99,16 +666,15 @@ int avl_node_get_height(AVLNode node) {
   }
 }
 
-static int avl_node_get_size(AVLNode node) {
-  if (node == NULL) {
+int avl_get_size(AVLTree tree) { return (int)tree->node_count; }
+
+size_t avl_get_rotations(AVLTree tree) {
+  if (tree == NULL) {
     return 0;
-  } else {
-    return 1 + avl_node_get_size(node->left) + avl_node_get_size(node->right);
   }
+  return tree->rotations;
 }
 
-int avl_get_size(AVLTree tree) { return avl_node_get_size(tree->root); }
-
 AVLNode avl_node_get_left(AVLNode node) {
   if (node == NULL) {
     return NULL;
@@ -123,6 +689,22 @@ AVLNode avl_node_get_right(AVLNode node) {
   return node->right;
 }
 
+AVLNode avl_first(AVLTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  if (!avl_small_pin(tree)) return NULL;
+  return tree->min;
+}
+
+AVLNode avl_last(AVLTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  if (!avl_small_pin(tree)) return NULL;
+  return tree->max;
+}
+
 void* avl_node_get_data(AVLNode node) {
   if (node == NULL) {
     return NULL;
@@ -130,6 +712,20 @@ void* avl_node_get_data(AVLNode node) {
   return node->data;
 }
 
+void* avl_node_get_value(AVLTree tree, AVLNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->data + tree->key_size;
+}
+
+size_t avl_node_get_data_size(AVLTree tree, AVLNode node) {
+  if (node == NULL) {
+    return 0;
+  }
+  return tree->record_size ? *avl_node_length(node) : tree->data_size;
+}
+
 static bool avl_node_is_valid(AVLNode node) {
   if (node == NULL) return true;
   int bal = avl_node_get_height(node->left) - avl_node_get_height(node->right);
@@ -142,15 +738,19 @@ static bool avl_subtree_is_valid(AVLNode node) {
 }
 
 bool avl_is_valid(AVLTree tree) {
+  if (avl_is_small(tree)) {
+    for (size_t i = 1; i < tree->node_count; i++) {
+      if (tree->compare(avl_small_record(tree, i - 1), avl_small_record(tree, i)) >= 0) return false;
+    }
+    return tree->node_count <= tree->small_capacity;
+  }
   if (tree->root == NULL) return true;
   return avl_subtree_is_valid(tree->root);
 }
 
 // --- Rotations and Rebalancing ---
 
-static AVLNode rotate_right(AVLNode node);
-
-static AVLNode rotate_left(AVLNode node) {
+static AVLNode rotate_left(AVLTree tree, AVLNode node) {
   if (node == NULL || node->right == NULL) {
     return node;
   }
@@ -160,13 +760,14 @@ static AVLNode rotate_left(AVLNode node) {
 
   r_node->left = node;
 
-  node->height = 1 + MAX(avl_node_get_height(node->left), avl_node_get_height(node->right));
-  r_node->height = 1 + MAX(avl_node_get_height(r_node->left), avl_node_get_height(r_node->right));
+  avl_node_update(tree, node);
+  avl_node_update(tree, r_node);
+  tree->rotations++;
 
   return r_node;
 }
 
-static AVLNode rotate_right(AVLNode node) {
+static AVLNode rotate_right(AVLTree tree, AVLNode node) {
   if (node == NULL || node->left == NULL) {
     return node;
   }
@@ -176,77 +777,427 @@ static AVLNode rotate_right(AVLNode node) {
 
   l_node->right = node;
 
-  node->height = 1 + MAX(avl_node_get_height(node->left), avl_node_get_height(node->right));
-  l_node->height = 1 + MAX(avl_node_get_height(l_node->left), avl_node_get_height(l_node->right));
+  avl_node_update(tree, node);
+  avl_node_update(tree, l_node);
+  tree->rotations++;
 
   return l_node;
 }
 
-static AVLNode rebalance(AVLNode node) {
-  node->height = 1 + MAX(avl_node_get_height(node->left), avl_node_get_height(node->right));
+static AVLNode rebalance(AVLTree tree, AVLNode node) {
+  avl_node_update(tree, node);
 
   int balance = avl_node_get_height(node->left) - avl_node_get_height(node->right);
   if (balance < -1) {
     if (avl_node_get_height(node->right->left) > avl_node_get_height(node->right->right)) {
-      node->right = rotate_right(node->right);  // double rotation RL
+      node->right = rotate_right(tree, node->right);  // double rotation RL
     }
-    return rotate_left(node);
+    return rotate_left(tree, node);
   } else if (balance > 1) {
     if (avl_node_get_height(node->left->right) > avl_node_get_height(node->left->left)) {
-      node->left = rotate_left(node->left);  // double rotation LR
+      node->left = rotate_left(tree, node->left);  // double rotation LR
     }
-    return rotate_right(node);
+    return rotate_right(tree, node);
   }
   return node;
 }
 
 // --- Insertion ---
 
-static void avl_node_add(AVLNode* node, const void* data, size_t size, int (*compare)(const void*, const void*)) {
+// leftmost/rightmost track whether the descent only went left/right, in which case the new node is the new min/max
+// With a value, data is a key alone and the value of an existing node is overwritten (avl_map_put)
+static int avl_node_add(AVLTree tree, AVLNode* node, const void* data, const void* value,
+                        const unsigned char* prefix, bool leftmost, bool rightmost) {
   if (node == NULL) {
-    return;
+    return 0;
   }
   AVLNode* next_node;
 
-  int cmp = compare(data, (*node)->data);
+  int cmp = avl_compare_node(tree, data, prefix, *node);
   if (cmp < 0) {
     next_node = &((*node)->left);
+    rightmost = false;
   } else if (cmp > 0) {
     next_node = &((*node)->right);
+    leftmost = false;
+  } else if (value != NULL) {
+    memcpy((*node)->data + tree->key_size, value, tree->data_size - tree->key_size);
+    avl_node_update(tree, *node);
+    return 0;
   } else {
-    return;  // data already in tree
+    return 0;  // data already in tree
   }
 
   if (*next_node == NULL) {
-    AVLNode new_node = avl_node_new(data, size);
+    AVLNode new_node = avl_node_new(tree, data, value);
+    if (new_node == NULL) return ENOMEM;
     *next_node = new_node;
-    (*node)->height = 1 + MAX(avl_node_get_height((*node)->left), avl_node_get_height((*node)->right));
-    return;
+    if (leftmost) tree->min = new_node;
+    if (rightmost) tree->max = new_node;
+    avl_node_update(tree, *node);
+    return 0;
   }
 
-  avl_node_add(next_node, data, size, compare);
+  // nothing was linked on failure, the path is left untouched
+  int error = avl_node_add(tree, next_node, data, value, prefix, leftmost, rightmost);
+  if (error) return error;
 
-  *node = rebalance(*node);
+  *node = rebalance(tree, *node);
+  return 0;
 }
 
-void avl_add(AVLTree tree, const void* data) {
+static int avl_root_add(AVLTree tree, const void* data, const void* value) {
   if (tree->root == NULL) {
-    AVLNode new_node = avl_node_new(data, tree->data_size);
+    AVLNode new_node = avl_node_new(tree, data, value);
+    if (new_node == NULL) return ENOMEM;
     tree->root = new_node;
-    return;
+    tree->min = new_node;
+    tree->max = new_node;
+    return 0;
   }
 
-  avl_node_add(&tree->root, data, tree->data_size, tree->compare);
+  unsigned char prefix[AVL_MAX_PREFIX];
+  return avl_node_add(tree, &tree->root, data, value, avl_key_prefix(tree, data, prefix), true, true);
+}
+
+// --- Tracing ---
+
+// USDT probes of provider avl, each operation firing <op>_entry then <op>_return:
+// - add, map_put, add_edge, remove, find (find_data) and map_get: entry(key, key size),
+//   return(result, key size, depth, rotations)
+// - pop_min and pop_max: entry(out, record size), return(popped, record size, depth, rotations)
+// - remove_range: entry(lo, hi, key size of lo), return(removed count, key size, depth of lo, rotations)
+// - find_batch: entry(keys, count), return(found count, key size, 0, rotations)
+// The depth counts the nodes from the root down to the key, or to where it belongs, and the rotations are the ones done
+// by the call. Record and key sizes are 0 for batches of variable-length records.
+TRACE_SEMAPHORE(avl, add_entry);
+TRACE_SEMAPHORE(avl, add_return);
+TRACE_SEMAPHORE(avl, map_put_entry);
+TRACE_SEMAPHORE(avl, map_put_return);
+TRACE_SEMAPHORE(avl, add_edge_entry);
+TRACE_SEMAPHORE(avl, add_edge_return);
+TRACE_SEMAPHORE(avl, remove_entry);
+TRACE_SEMAPHORE(avl, remove_return);
+TRACE_SEMAPHORE(avl, find_entry);
+TRACE_SEMAPHORE(avl, find_return);
+TRACE_SEMAPHORE(avl, map_get_entry);
+TRACE_SEMAPHORE(avl, map_get_return);
+TRACE_SEMAPHORE(avl, pop_min_entry);
+TRACE_SEMAPHORE(avl, pop_min_return);
+TRACE_SEMAPHORE(avl, pop_max_entry);
+TRACE_SEMAPHORE(avl, pop_max_return);
+TRACE_SEMAPHORE(avl, remove_range_entry);
+TRACE_SEMAPHORE(avl, remove_range_return);
+TRACE_SEMAPHORE(avl, find_batch_entry);
+TRACE_SEMAPHORE(avl, find_batch_return);
+
+// Probe arguments taken on entry, all zero unless a tracer is attached
+struct avl_trace {
+  size_t key_size;
+  int depth;  // nodes compared on the way down to the key, or to where it belongs, 0 while the tree is small
+  size_t rotations;
+};
+
+// The depth is measured by a descent of its own, so untraced calls do not pay for it. data is NULL when there is no
+// single key, as in batches.
+static struct avl_trace avl_trace_begin(AVLTree tree, const void* data, bool active) {
+  struct avl_trace trace = {0};
+  if (!active) return trace;
+
+  trace.rotations = tree->rotations;
+  if (data == NULL) {
+    trace.key_size = tree->record_size ? 0 : tree->key_size;
+    return trace;
+  }
+  trace.key_size = tree->record_size ? tree->record_size(data) : tree->key_size;
+  unsigned char buffer[AVL_MAX_PREFIX];
+  const unsigned char* prefix = avl_key_prefix(tree, data, buffer);
+  for (AVLNode node = tree->root; node != NULL;) {
+    int cmp = avl_compare_node(tree, data, prefix, node);
+    trace.depth++;
+    if (cmp == 0) break;
+    node = cmp < 0 ? node->left : node->right;
+  }
+  return trace;
+}
+
+// Pops follow the spine down to the smallest or largest record, their size is that of the popped record
+static struct avl_trace avl_trace_edge(AVLTree tree, bool largest, bool active) {
+  struct avl_trace trace = avl_trace_begin(tree, NULL, active);
+  if (!active || tree->root == NULL) return trace;
+
+  AVLNode node = tree->root;
+  for (trace.depth = 1; (largest ? node->right : node->left) != NULL; trace.depth++) {
+    node = largest ? node->right : node->left;
+  }
+  trace.key_size = avl_node_get_data_size(tree, node);
+  return trace;
+}
+
+// --- Small Mode ---
+
+// Small trees keep their records sorted in one array, searched by bisection. The comparison function is opaque, so
+// comparisons cannot be vectorized, the savings are the node allocations and the pointer chasing.
+
+// Frees the nodes of a subtree without deleting their data, which lives on elsewhere
+static void avl_free_nodes(AVLTree tree, AVLNode node) {
+  if (node == NULL) return;
+  avl_free_nodes(tree, node->left);
+  avl_free_nodes(tree, node->right);
+  delete_node(tree, node, false);
+}
+
+// Index of the first record not below data, found tells whether it compares equal
+static size_t avl_small_search(AVLTree tree, const void* data, bool* found) {
+  size_t lo = 0;
+  size_t hi = tree->node_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (tree->compare(avl_small_record(tree, mid), data) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *found = lo < tree->node_count && tree->compare(data, avl_small_record(tree, lo)) == 0;
+  return lo;
+}
+
+static void* avl_small_find(AVLTree tree, const void* data) {
+  bool found;
+  size_t i = avl_small_search(tree, data, &found);
+  return found ? avl_small_record(tree, i) : NULL;
+}
+
+// Moves the records into nodes, added in order through the regular insertion. On failure the nodes made so far are
+// freed and the records stay in the array.
+static int avl_small_promote(AVLTree tree) {
+  size_t count = tree->node_count;
+  tree->node_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    int error = avl_root_add(tree, avl_small_record(tree, i), NULL);
+    if (error) {
+      avl_free_nodes(tree, tree->root);
+      tree->root = NULL;
+      tree->min = NULL;
+      tree->max = NULL;
+      tree->node_count = count;
+      return error;
+    }
+  }
+  return 0;
+}
+
+// Nodes handed out must stay valid, so a tree handing one out keeps its nodes for good and is no longer adaptive.
+// Returns false, errno set to ENOMEM, when the records could not be moved into nodes.
+static bool avl_small_pin(AVLTree tree) {
+  if (tree->small == NULL) return true;
+  if (avl_is_small(tree)) {
+    int error = avl_small_promote(tree);
+    if (error) {
+      errno = error;
+      return false;
+    }
+  }
+  tree->allocator.free(tree->allocator.ctx, tree->small);
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  return true;
+}
+
+// Copies the records of a subtree in order into the array from index *count, freeing their nodes
+static void avl_small_gather(AVLTree tree, AVLNode node, size_t* count) {
+  if (node == NULL) return;
+  avl_small_gather(tree, node->left, count);
+  AVLNode right = node->right;
+  memcpy(avl_small_record(tree, (*count)++), node->data, tree->data_size);
+  delete_node(tree, node, false);
+  avl_small_gather(tree, right, count);
+}
+
+// Called after removals, records go back to the array once they fill half of it, so a tree hovering around the
+// threshold does not switch at every operation
+static void avl_small_shrink(AVLTree tree) {
+  if (tree->small == NULL || tree->root == NULL || tree->node_count > tree->small_capacity / 2) return;
+  size_t count = 0;
+  avl_small_gather(tree, tree->root, &count);
+  tree->root = NULL;
+  tree->min = NULL;
+  tree->max = NULL;
+  tree->node_count = count;
+}
+
+// value is NULL when data already holds the whole record, as in avl_root_add
+static int avl_small_add(AVLTree tree, const void* data, const void* value) {
+  bool found;
+  size_t i = avl_small_search(tree, data, &found);
+  if (found) {
+    if (value != NULL) memcpy(avl_small_record(tree, i) + tree->key_size, value, tree->data_size - tree->key_size);
+    return 0;
+  }
+  if (tree->node_count == tree->small_capacity) {  // full, the tree switches to nodes
+    int error = avl_small_promote(tree);
+    return error ? error : avl_root_add(tree, data, value);
+  }
+
+  char* record = avl_small_record(tree, i);
+  memmove(record + tree->data_size, record, (tree->node_count - i) * tree->data_size);
+  memcpy(record, data, value ? tree->key_size : tree->data_size);
+  if (value != NULL) memcpy(record + tree->key_size, value, tree->data_size - tree->key_size);
+  tree->node_count++;
+  return 0;
+}
+
+// Removes the records from first to last (excluded)
+static void avl_small_erase(AVLTree tree, size_t first, size_t last, bool del_data) {
+  for (size_t i = first; i < last && del_data && tree->delete_data; i++) {
+    tree->delete_data(avl_small_record(tree, i));
+  }
+  memmove(avl_small_record(tree, first), avl_small_record(tree, last), (tree->node_count - last) * tree->data_size);
+  tree->node_count -= last - first;
+}
+
+static bool avl_small_pop(AVLTree tree, bool max, void* out) {
+  if (tree->node_count == 0) return false;
+  size_t i = max ? tree->node_count - 1 : 0;
+  if (out != NULL) memcpy(out, avl_small_record(tree, i), tree->data_size);
+  avl_small_erase(tree, i, i + 1, out == NULL);
+  return true;
+}
+
+static size_t avl_small_remove_range(AVLTree tree, const void* lo, const void* hi) {
+  bool found;
+  size_t first = avl_small_search(tree, lo, &found);
+  size_t last = avl_small_search(tree, hi, &found) + found;
+  avl_small_erase(tree, first, last, true);
+  return last - first;
+}
+
+int avl_set_adaptive(AVLTree tree, size_t threshold) {
+  if (tree->root != NULL || tree->node_count > 0 || tree->record_size != NULL || tree->augment.compute != NULL ||
+      tree->filter.blocks != NULL || tree->cache.entries != NULL ||
+      tree->merkle_hash != NULL) {
+    return EINVAL;
+  }
+
+  char* small = NULL;
+  if (threshold > 0) {
+    small = tree->allocator.alloc(tree->allocator.ctx, threshold * tree->data_size);
+    if (!small) return ENOMEM;
+  }
+  if (tree->small) tree->allocator.free(tree->allocator.ctx, tree->small);
+  tree->small = small;
+  tree->small_capacity = threshold;
+  return 0;
+}
+
+int avl_add(AVLTree tree, const void* data) {
+  struct avl_trace trace = avl_trace_begin(tree, data, TRACE_ACTIVE(avl, add_entry) || TRACE_ACTIVE(avl, add_return));
+  TRACE2(avl, add_entry, data, trace.key_size);
+  int error = avl_is_small(tree) ? avl_small_add(tree, data, NULL) : avl_root_add(tree, data, NULL);
+  TRACE4(avl, add_return, error, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return error;
+}
+
+int avl_map_put(AVLTree tree, const void* key, const void* value) {
+  struct avl_trace trace =
+      avl_trace_begin(tree, key, TRACE_ACTIVE(avl, map_put_entry) || TRACE_ACTIVE(avl, map_put_return));
+  TRACE2(avl, map_put_entry, key, trace.key_size);
+  int error = avl_is_small(tree) ? avl_small_add(tree, key, value) : avl_root_add(tree, key, value);
+  TRACE4(avl, map_put_return, error, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return error;
+}
+
+// Insertion from one edge of the tree: the spine is collected without comparisons, then climbed from its end
+// until data fits below it, so data d positions away from the edge costs O(log d) comparisons instead of O(log n).
+// The spine is then rebalanced bottom-up, like the recursion of avl_node_add would on its way back up.
+static int avl_root_add_edge(AVLTree tree, bool left, const void* data) {
+  if (tree->root == NULL) return avl_is_small(tree) ? avl_small_add(tree, data, NULL) : avl_root_add(tree, data, NULL);
+
+  bool from_right = !left;
+  AVLNode spine[AVL_MAX_HEIGHT];
+  int depth = 0;
+  for (AVLNode node = tree->root; node != NULL; node = from_right ? node->right : node->left) {
+    spine[depth++] = node;
+  }
+
+  unsigned char buffer[AVL_MAX_PREFIX];
+  const unsigned char* prefix = avl_key_prefix(tree, data, buffer);
+  int top = depth - 1;
+  while (top >= 0) {
+    int cmp = avl_compare_node(tree, data, prefix, spine[top]);
+    if (cmp == 0) return 0;  // data already in tree
+    if (from_right ? cmp > 0 : cmp < 0) break;
+    top--;
+  }
+
+  if (top == depth - 1) {  // beyond the edge, appended without further comparisons
+    AVLNode new_node = avl_node_new(tree, data, NULL);
+    if (new_node == NULL) return ENOMEM;
+    if (from_right) {
+      spine[top]->right = new_node;
+      tree->max = new_node;
+    } else {
+      spine[top]->left = new_node;
+      tree->min = new_node;
+    }
+  } else {  // between spine[top] and spine[top + 1], in the inner subtree of the latter
+    AVLNode* inner = from_right ? &spine[top + 1]->left : &spine[top + 1]->right;
+    bool outermost = top < 0;  // past the root, data may be the new extreme on the other side
+    if (*inner == NULL) {
+      AVLNode new_node = avl_node_new(tree, data, NULL);
+      if (new_node == NULL) return ENOMEM;
+      *inner = new_node;
+      if (outermost && from_right) tree->min = new_node;
+      if (outermost && !from_right) tree->max = new_node;
+    } else {
+      int error =
+          avl_node_add(tree, inner, data, NULL, prefix, outermost && from_right, outermost && !from_right);
+      if (error) return error;
+    }
+  }
+
+  for (int i = MIN(top + 1, depth - 1); i >= 0; i--) {
+    AVLNode balanced = rebalance(tree, spine[i]);
+    if (i == 0) {
+      tree->root = balanced;
+    } else if (from_right) {
+      spine[i - 1]->right = balanced;
+    } else {
+      spine[i - 1]->left = balanced;
+    }
+  }
+  return 0;
+}
+
+int avl_add_edge(AVLTree tree, bool left, const void* data) {
+  struct avl_trace trace =
+      avl_trace_begin(tree, data, TRACE_ACTIVE(avl, add_edge_entry) || TRACE_ACTIVE(avl, add_edge_return));
+  TRACE2(avl, add_edge_entry, data, trace.key_size);
+  int error = avl_root_add_edge(tree, left, data);
+  TRACE4(avl, add_edge_return, error, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return error;
 }
 
 // --- Search ---
 
 AVLNode avl_find_node(AVLTree tree, const void* data) {
+  if (!avl_small_pin(tree)) return NULL;
   AVLNode current = tree->root;
+  unsigned char buffer[AVL_MAX_PREFIX];
+  const unsigned char* prefix = avl_key_prefix(tree, data, buffer);
+  uint64_t tag = 0;
+  if (tree->cache.entries) {
+    tag = avl_mix_hash(tree->cache.hash(data));
+    AVLNode cached = avl_cache_find(tree, data, tag);
+    if (cached) return cached;
+  }
+  if (!avl_filter_admits(tree, data)) return NULL;
 
   while (current != NULL) {
-    int cmp = tree->compare(data, current->data);
+    int cmp = avl_compare_node(tree, data, prefix, current);
     if (cmp == 0) {
+      if (tree->cache.entries) *avl_cache_entry(tree, tag) = (struct avl_lookup_entry){tag, current};
       return current;
     } else if (cmp < 0) {
       current = current->left;
@@ -255,12 +1206,108 @@ AVLNode avl_find_node(AVLTree tree, const void* data) {
     }
   }
 
+  if (tree->filter.blocks) tree->filter.false_positives++;
   return NULL;
 }
 
 void* avl_find_data(AVLTree tree, const void* data) {
-  AVLNode node = avl_find_node(tree, data);
-  return node ? node->data : NULL;
+  struct avl_trace trace = avl_trace_begin(tree, data, TRACE_ACTIVE(avl, find_entry) || TRACE_ACTIVE(avl, find_return));
+  TRACE2(avl, find_entry, data, trace.key_size);
+  void* found;
+  if (avl_is_small(tree)) {
+    found = avl_small_find(tree, data);
+  } else {
+    AVLNode node = avl_find_node(tree, data);
+    found = node ? node->data : NULL;
+  }
+  TRACE4(avl, find_return, found, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return found;
+}
+
+void* avl_map_get(AVLTree tree, const void* key) {
+  struct avl_trace trace =
+      avl_trace_begin(tree, key, TRACE_ACTIVE(avl, map_get_entry) || TRACE_ACTIVE(avl, map_get_return));
+  TRACE2(avl, map_get_entry, key, trace.key_size);
+  char* record;
+  if (avl_is_small(tree)) {
+    record = avl_small_find(tree, key);
+  } else {
+    AVLNode node = avl_find_node(tree, key);
+    record = node ? node->data : NULL;
+  }
+  void* value = record ? record + tree->key_size : NULL;
+  TRACE4(avl, map_get_return, value, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return value;
+}
+
+// Variable-length records cannot be strided, batches of them are arrays of pointers
+static const void* avl_batch_key(AVLTree tree, const char* keys, size_t i) {
+  return tree->record_size ? ((const void* const*)keys)[i] : keys + i * tree->key_size;
+}
+
+// Group prefetching: the lookups of a group advance one level each per round, prefetching their next node, so the
+// cache misses of the whole group overlap instead of being paid one after the other
+// see: Chen et al., "Improving Hash Join Performance through Prefetching" (2004)
+static size_t avl_root_find_batch(AVLTree tree, const void* data, size_t count, void** results) {
+  const char* keys = data;
+  size_t found = 0;
+  if (avl_is_small(tree)) {
+    for (size_t i = 0; i < count; i++) {
+      results[i] = avl_small_find(tree, avl_batch_key(tree, keys, i));
+      found += results[i] != NULL;
+    }
+    return found;
+  }
+
+  for (size_t start = 0; start < count; start += AVL_BATCH_GROUP) {
+    size_t group = MIN((size_t)AVL_BATCH_GROUP, count - start);
+    AVLNode current[AVL_BATCH_GROUP];
+    bool admitted[AVL_BATCH_GROUP];  // keys the filter rejected are never searched
+    for (size_t i = 0; i < group; i++) {
+      admitted[i] = avl_filter_admits(tree, avl_batch_key(tree, keys, start + i));
+      current[i] = admitted[i] ? tree->root : NULL;
+      results[start + i] = NULL;
+    }
+
+    size_t active = tree->root ? group : 0;
+    while (active > 0) {
+      active = 0;
+      for (size_t i = 0; i < group; i++) {
+        AVLNode node = current[i];
+        if (node == NULL) continue;
+
+        int cmp = tree->compare(avl_batch_key(tree, keys, start + i), node->data);
+        if (cmp == 0) {
+          results[start + i] = node->data;
+          current[i] = NULL;
+          found++;
+          continue;
+        }
+
+        node = cmp < 0 ? node->left : node->right;
+        current[i] = node;
+        if (node != NULL) {
+          PREFETCH(node);
+          active++;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < group && tree->filter.blocks; i++) {
+      if (admitted[i] && results[start + i] == NULL) tree->filter.false_positives++;
+    }
+  }
+
+  return found;
+}
+
+size_t avl_find_batch(AVLTree tree, const void* data, size_t count, void** results) {
+  struct avl_trace trace =
+      avl_trace_begin(tree, NULL, TRACE_ACTIVE(avl, find_batch_entry) || TRACE_ACTIVE(avl, find_batch_return));
+  TRACE2(avl, find_batch_entry, data, count);
+  size_t found = avl_root_find_batch(tree, data, count, results);
+  TRACE4(avl, find_batch_return, found, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return found;
 }
 
 static AVLNode tree_get_min_node(AVLNode node) {
@@ -268,39 +1315,440 @@ static AVLNode tree_get_min_node(AVLNode node) {
   return tree_get_min_node(node->left);
 }
 
+static AVLNode tree_get_max_node(AVLNode node) {
+  if (node->right == NULL) return node;
+  return tree_get_max_node(node->right);
+}
+
 // --- Deletion ---
 
-static AVLNode avl_node_remove(AVLNode* node, const void* data, size_t size, int (*compare)(const void*, const void*),
-                               void (*del)(void*), bool del_data) {
+// Frees a node unlinked from the tree, the cached min/max are reset if they pointed to it
+static void avl_free_node(AVLTree tree, AVLNode node, bool del_data) {
+  if (node == tree->min) tree->min = NULL;
+  if (node == tree->max) tree->max = NULL;
+  delete_node(tree, node, del_data);
+}
+
+// Restores the cached min/max after a removal, only walks down the spines when they were freed, and shrinks the
+// Bloom filter
+static void avl_update_bounds(AVLTree tree) {
+  avl_filter_shrink(tree);
+  if (tree->root == NULL) {
+    tree->min = NULL;
+    tree->max = NULL;
+    return;
+  }
+  if (tree->min == NULL) tree->min = tree_get_min_node(tree->root);
+  if (tree->max == NULL) tree->max = tree_get_max_node(tree->root);
+}
+
+// No comparisons needed, the leftmost node of a subtree is found by following left links and unlinked into min
+static AVLNode avl_node_detach_min(AVLTree tree, AVLNode node, AVLNode* min) {
+  if (node->left == NULL) {
+    *min = node;
+    return node->right;
+  }
+
+  node->left = avl_node_detach_min(tree, node->left, min);
+  return rebalance(tree, node);
+}
+
+static AVLNode avl_node_remove_min(AVLTree tree, AVLNode node, bool del_data) {
+  AVLNode min;
+  node = avl_node_detach_min(tree, node, &min);
+  avl_free_node(tree, min, del_data);
+  return node;
+}
+
+static AVLNode avl_node_remove_max(AVLTree tree, AVLNode node, bool del_data) {
+  if (node->right == NULL) {
+    AVLNode left = node->left;
+    avl_free_node(tree, node, del_data);
+    return left;
+  }
+
+  node->right = avl_node_remove_max(tree, node->right, del_data);
+  return rebalance(tree, node);
+}
+
+static AVLNode avl_node_remove(AVLTree tree, AVLNode* node, const void* data, const unsigned char* prefix) {
   if (*node == NULL) {
     return NULL;
   }
 
-  int cmp = compare(data, (*node)->data);
+  int cmp = avl_compare_node(tree, data, prefix, *node);
   if (cmp < 0) {
-    (*node)->left = avl_node_remove(&(*node)->left, data, size, compare, del, del_data);
+    (*node)->left = avl_node_remove(tree, &(*node)->left, data, prefix);
   } else if (cmp > 0) {
-    (*node)->right = avl_node_remove(&(*node)->right, data, size, compare, del, del_data);
+    (*node)->right = avl_node_remove(tree, &(*node)->right, data, prefix);
   } else {
     if ((*node)->left == NULL || (*node)->right == NULL) {  // One child or no child
       AVLNode temp = (*node)->left ? (*node)->left : (*node)->right;
-      delete_node(*node, del, del_data);
+      avl_free_node(tree, *node, true);
       return temp;
     }
 
-    if (del_data && del) del((*node)->data);
-    AVLNode temp = tree_get_min_node((*node)->right);
-
-    memcpy((*node)->data, temp->data, size);
-    (*node)->right = avl_node_remove(&(*node)->right, temp->data, size, compare, del, false);
+    // The successor node takes the place of the removed one, records are never copied between nodes since their
+    // lengths may differ
+    AVLNode successor;
+    AVLNode right = avl_node_detach_min(tree, (*node)->right, &successor);
+    successor->left = (*node)->left;
+    successor->right = right;
+    avl_free_node(tree, *node, true);
+    *node = successor;
   }
 
-  *node = rebalance(*node);
+  *node = rebalance(tree, *node);
   return *node;
 }
 
-void avl_remove(AVLTree tree, const void* data) {
+static void avl_root_remove(AVLTree tree, const void* data) {
+  if (avl_is_small(tree)) {
+    bool found;
+    size_t i = avl_small_search(tree, data, &found);
+    if (found) avl_small_erase(tree, i, i + 1, true);
+    return;
+  }
   if (tree->root == NULL) return;
 
-  tree->root = avl_node_remove(&tree->root, data, tree->data_size, tree->compare, tree->delete_data, true);
+  unsigned char prefix[AVL_MAX_PREFIX];
+  tree->root = avl_node_remove(tree, &tree->root, data, avl_key_prefix(tree, data, prefix));
+  avl_update_bounds(tree);
+  avl_small_shrink(tree);
+}
+
+void avl_remove(AVLTree tree, const void* data) {
+  struct avl_trace trace =
+      avl_trace_begin(tree, data, TRACE_ACTIVE(avl, remove_entry) || TRACE_ACTIVE(avl, remove_return));
+  TRACE2(avl, remove_entry, data, trace.key_size);
+  size_t count = tree->node_count;
+  avl_root_remove(tree, data);
+  TRACE4(avl, remove_return, tree->node_count != count, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+}
+
+static bool avl_root_pop_min(AVLTree tree, void* out) {
+  if (avl_is_small(tree)) return avl_small_pop(tree, false, out);
+  if (tree->root == NULL) return false;
+
+  if (out != NULL) memcpy(out, tree->min->data, avl_node_get_data_size(tree, tree->min));
+  tree->root = avl_node_remove_min(tree, tree->root, out == NULL);
+  avl_update_bounds(tree);
+  avl_small_shrink(tree);
+  return true;
+}
+
+bool avl_pop_min(AVLTree tree, void* out) {
+  struct avl_trace trace =
+      avl_trace_edge(tree, false, TRACE_ACTIVE(avl, pop_min_entry) || TRACE_ACTIVE(avl, pop_min_return));
+  TRACE2(avl, pop_min_entry, out, trace.key_size);
+  bool popped = avl_root_pop_min(tree, out);
+  TRACE4(avl, pop_min_return, popped, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return popped;
+}
+
+static bool avl_root_pop_max(AVLTree tree, void* out) {
+  if (avl_is_small(tree)) return avl_small_pop(tree, true, out);
+  if (tree->root == NULL) return false;
+
+  if (out != NULL) memcpy(out, tree->max->data, avl_node_get_data_size(tree, tree->max));
+  tree->root = avl_node_remove_max(tree, tree->root, out == NULL);
+  avl_update_bounds(tree);
+  avl_small_shrink(tree);
+  return true;
+}
+
+bool avl_pop_max(AVLTree tree, void* out) {
+  struct avl_trace trace =
+      avl_trace_edge(tree, true, TRACE_ACTIVE(avl, pop_max_entry) || TRACE_ACTIVE(avl, pop_max_return));
+  TRACE2(avl, pop_max_entry, out, trace.key_size);
+  bool popped = avl_root_pop_max(tree, out);
+  TRACE4(avl, pop_max_return, popped, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return popped;
+}
+
+// Joins two subtrees around a middle node, all data of left < node < all data of right. The node is attached where the
+// taller side's spine reaches the height of the shorter one, then rebalanced on the way up, in O(height difference).
+// see: Blelloch et al., "Just Join for Parallel Ordered Sets" (2016)
+static AVLNode avl_join(AVLTree tree, AVLNode left, AVLNode node, AVLNode right) {
+  int left_height = avl_node_get_height(left);
+  int right_height = avl_node_get_height(right);
+  if (left_height > right_height + 1) {
+    left->right = avl_join(tree, left->right, node, right);
+    return rebalance(tree, left);
+  }
+  if (right_height > left_height + 1) {
+    right->left = avl_join(tree, left, node, right->left);
+    return rebalance(tree, right);
+  }
+  node->left = left;
+  node->right = right;
+  avl_node_update(tree, node);
+  return node;
+}
+
+// Joins two subtrees without a middle node, the minimum of right is detached to take its place
+static AVLNode avl_merge(AVLTree tree, AVLNode left, AVLNode right) {
+  if (left == NULL) return right;
+  if (right == NULL) return left;
+  AVLNode min;
+  right = avl_node_detach_min(tree, right, &min);
+  return avl_join(tree, left, min, right);
+}
+
+// A NULL bound is unbounded. Nodes outside the range are joined back with what is left of their subtree on the
+// range's side, and below the first node inside it, the range only reaches into one side of each subtree. The joins
+// along a path telescope to O(log n), and the removed subtrees are freed whole.
+static AVLNode avl_node_remove_range(AVLTree tree, AVLNode node, const void* lo, const void* hi, size_t* removed) {
+  if (node == NULL) return NULL;
+  if (lo == NULL && hi == NULL) {
+    *removed += delete_all_nodes(tree, node);
+    return NULL;
+  }
+
+  if (lo != NULL && tree->compare(node->data, lo) < 0) {
+    AVLNode right = avl_node_remove_range(tree, node->right, lo, hi, removed);
+    return avl_join(tree, node->left, node, right);
+  }
+  if (hi != NULL && tree->compare(node->data, hi) > 0) {
+    AVLNode left = avl_node_remove_range(tree, node->left, lo, hi, removed);
+    return avl_join(tree, left, node, node->right);
+  }
+
+  AVLNode left = avl_node_remove_range(tree, node->left, lo, NULL, removed);
+  AVLNode right = avl_node_remove_range(tree, node->right, NULL, hi, removed);
+  delete_node(tree, node, true);
+  (*removed)++;
+  return avl_merge(tree, left, right);
+}
+
+static size_t avl_root_remove_range(AVLTree tree, const void* lo, const void* hi) {
+  if (avl_is_small(tree)) return tree->compare(lo, hi) > 0 ? 0 : avl_small_remove_range(tree, lo, hi);
+  if (tree->root == NULL || tree->compare(lo, hi) > 0) return 0;
+
+  size_t removed = 0;
+  tree->root = avl_node_remove_range(tree, tree->root, lo, hi, &removed);
+  if (removed > 0) {
+    tree->min = NULL;  // possibly freed with the range
+    tree->max = NULL;
+    avl_update_bounds(tree);
+    avl_small_shrink(tree);
+  }
+  return removed;
+}
+
+size_t avl_remove_range(AVLTree tree, const void* lo, const void* hi) {
+  struct avl_trace trace =
+      avl_trace_begin(tree, lo, TRACE_ACTIVE(avl, remove_range_entry) || TRACE_ACTIVE(avl, remove_range_return));
+  TRACE3(avl, remove_range_entry, lo, hi, trace.key_size);
+  size_t removed = avl_root_remove_range(tree, lo, hi);
+  TRACE4(avl, remove_range_return, removed, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return removed;
+}
+
+// --- Compaction ---
+
+// Moves path[depth - 1] into the region being filled and relinks it. Once the region is full, nodes stay where they
+// are, unless they live in the previous region, which is freed when the compaction ends.
+static AVLNode avl_move_node(AVLTree tree, AVLNode* path, int depth) {
+  AVLNode node = path[depth - 1];
+  if (avl_in_region(tree->next_region, tree->next_region_size, (char*)node - tree->header_size)) {
+    return node;  // already moved, before the compaction started over
+  }
+  size_t size = avl_node_block_size(tree, node);
+  size_t stride = avl_node_stride(tree, size);
+  char* block;
+  if (tree->next_region_used + stride <= tree->next_region_size) {
+    block = tree->next_region + tree->next_region_used;
+    tree->next_region_used += stride;
+  } else if (avl_in_region(tree->region, tree->region_size, (char*)node - tree->header_size)) {
+    block = tree->allocator.alloc(tree->allocator.ctx, size);
+    if (!block) return NULL;
+  } else {
+    return node;
+  }
+
+  memcpy(block, (char*)node - tree->header_size, size);
+  AVLNode moved = (AVLNode)(block + tree->header_size);
+  avl_cache_move(tree, node, moved);
+  if (depth == 1) {
+    tree->root = moved;
+  } else if (path[depth - 2]->left == node) {
+    path[depth - 2]->left = moved;
+  } else {
+    path[depth - 2]->right = moved;
+  }
+  if (tree->min == node) tree->min = moved;
+  if (tree->max == node) tree->max = moved;
+  avl_free_block(tree, node);
+  path[depth - 1] = moved;
+  return moved;
+}
+
+int avl_compact_begin(AVLTree tree) {
+  if (tree->next_region != NULL) return 0;
+  if (tree->node_bytes == 0) {  // nothing to move, a previous region only holds removed nodes
+    if (tree->region) tree->allocator.free(tree->allocator.ctx, tree->region);
+    tree->region = NULL;
+    tree->region_size = 0;
+    return 0;
+  }
+
+  tree->next_region = tree->allocator.alloc(tree->allocator.ctx, tree->node_bytes);
+  if (tree->next_region == NULL) return ENOMEM;
+  tree->next_region_size = tree->node_bytes;
+  tree->next_region_used = 0;
+  return 0;
+}
+
+// Nodes are moved in order, so every subtree ends up contiguous. Steps resume after the data of the last moved node
+// rather than from a saved path, the tree can then change freely between them. If that node is removed, its data may
+// be gone with it, so the next step starts over from the first node instead.
+int avl_compact_step(AVLTree tree, size_t max_nodes, bool* done) {
+  *done = tree->next_region == NULL;
+  if (*done || max_nodes == 0) return 0;
+
+  AVLNode path[AVL_MAX_HEIGHT];
+  int depth = 0;
+  int found = 0;
+  for (AVLNode node = tree->root; node != NULL;) {
+    path[depth++] = node;
+    if (tree->cursor == NULL || tree->compare(tree->cursor->data, node->data) < 0) {
+      found = depth;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+  depth = found;
+
+  for (size_t visited = 0; depth > 0 && visited < max_nodes; visited++) {
+    AVLNode node = avl_move_node(tree, path, depth);
+    if (node == NULL) return ENOMEM;  // the next step retries from the same cursor
+    tree->cursor = node;
+
+    if (node->right != NULL) {
+      for (AVLNode next = node->right; next != NULL; next = next->left) {
+        path[depth++] = next;
+      }
+    } else {
+      AVLNode child;
+      do {
+        child = path[--depth];
+      } while (depth > 0 && path[depth - 1]->right == child);
+    }
+  }
+
+  if (depth == 0) {
+    tree->cursor = NULL;
+    if (tree->region) tree->allocator.free(tree->allocator.ctx, tree->region);
+    tree->region = tree->next_region;
+    tree->region_size = tree->next_region_size;
+    tree->next_region = NULL;
+    tree->next_region_size = 0;
+    *done = true;
+  }
+  return 0;
+}
+
+static void avl_node_footprint(AVLTree tree, AVLNode node, AVLFootprint* out, uintptr_t* low, uintptr_t* high) {
+  if (node == NULL) return;
+
+  char* block = (char*)node - tree->header_size;
+  size_t size = avl_node_block_size(tree, node);
+  out->nodes++;
+  if (!avl_in_region(tree->region, tree->region_size, block) &&
+      !avl_in_region(tree->next_region, tree->next_region_size, block)) {
+    out->allocations++;
+    out->bytes += size;
+  }
+  *low = MIN(*low, (uintptr_t)block);
+  *high = MAX(*high, (uintptr_t)block + size);
+  avl_node_footprint(tree, node->left, out, low, high);
+  avl_node_footprint(tree, node->right, out, low, high);
+}
+
+void avl_get_footprint(AVLTree tree, AVLFootprint* out) {
+  *out = (AVLFootprint){0};
+  uintptr_t low = UINTPTR_MAX, high = 0;
+  avl_node_footprint(tree, tree->root, out, &low, &high);
+  out->allocations += (tree->region != NULL) + (tree->next_region != NULL);
+  out->bytes += tree->region_size + tree->next_region_size;
+  if (tree->small) {  // the array of an adaptive tree, allocated whether or not it holds the records
+    out->allocations++;
+    out->bytes += tree->small_capacity * tree->data_size;
+  }
+  out->span = out->nodes > 0 ? high - low : 0;
+}
+
+int avl_compact(AVLTree tree, AVLFootprint* before, AVLFootprint* after) {
+  if (before) avl_get_footprint(tree, before);
+  int error = avl_compact_begin(tree);
+  bool done = false;
+  while (!error && !done) {
+    error = avl_compact_step(tree, SIZE_MAX, &done);
+  }
+  if (after) avl_get_footprint(tree, after);
+  return error;
+}
+
+// --- Aggregates ---
+
+// Aggregate of the data of a subtree that is >= bound (from_lo) or <= bound (!from_lo). The nodes kept on the search
+// path are combined bottom-up with the stored aggregate of their subtree on the inner side.
+static void avl_node_aggregate_bound(AVLTree tree, AVLNode node, const void* bound, bool from_lo, void* out,
+                                     void* tmp) {
+  AVLNode path[AVL_MAX_HEIGHT];
+  int depth = 0;
+
+  while (node != NULL) {
+    int cmp = tree->compare(node->data, bound);
+    if (from_lo ? cmp >= 0 : cmp <= 0) {
+      path[depth++] = node;
+      node = from_lo ? node->left : node->right;
+    } else {
+      node = from_lo ? node->right : node->left;
+    }
+  }
+
+  memcpy(out, tree->augment.identity, tree->augment.size);
+  while (depth-- > 0) {
+    AVLNode current = path[depth];
+    if (from_lo) {
+      tree->augment.compute(tmp, current->data, out, avl_subtree_aggregate(tree, current->right));
+    } else {
+      tree->augment.compute(tmp, current->data, avl_subtree_aggregate(tree, current->left), out);
+    }
+    memcpy(out, tmp, tree->augment.size);
+  }
+}
+
+int avl_range_aggregate(AVLTree tree, const void* lo, const void* hi, void* out) {
+  if (tree->augment.compute == NULL) return EINVAL;
+
+  // highest node inside the range, both bounds are then searched for in its subtrees
+  AVLNode split = tree->root;
+  while (split != NULL) {
+    if (tree->compare(split->data, lo) < 0) {
+      split = split->right;
+    } else if (tree->compare(split->data, hi) > 0) {
+      split = split->left;
+    } else {
+      break;
+    }
+  }
+
+  if (split == NULL) {
+    memcpy(out, tree->augment.identity, tree->augment.size);
+    return 0;
+  }
+
+  const size_t stride = tree->augment_scratch - (const char*)tree->augment.identity;
+  char* left = tree->augment_scratch;
+  char* right = left + stride;
+  char* tmp = right + stride;
+
+  avl_node_aggregate_bound(tree, split->left, lo, true, left, tmp);
+  avl_node_aggregate_bound(tree, split->right, hi, false, right, tmp);
+  tree->augment.compute(out, split->data, left, right);
+  return 0;
 }
@@ -22,6 +22,64 @@ typedef struct _AVLTree* AVLTree;
  */
 typedef struct _TreeNode* AVLNode;
 
+/**
+ * @brief Augmentation descriptor, each node then keeps an aggregate of its whole subtree.
+ *
+ * The aggregates must form a monoid: compute(out, data, left, right) stores left + f(data) + right in out, for an
+ * associative + with identity as its neutral element. out never aliases left or right.
+ * For example a sum of sizes, a maximum, or a count.
+ */
+typedef struct {
+  size_t size;             ///< Size of an aggregate in bytes.
+  const void* identity;    ///< Aggregate of an empty subtree, copied by the tree.
+  void (*compute)(void* out, const void* data, const void* left, const void* right);
+} AVLAugment;
+
+/**
+ * @brief Allocator used for the tree and its nodes, so they can live in arenas, huge pages or per-thread heaps.
+ */
+typedef struct {
+  void* (*alloc)(void* ctx, size_t size);  ///< Returns NULL on failure.
+  void (*free)(void* ctx, void* ptr);
+  void* ctx;  ///< Passed as is to alloc and free.
+} AVLAllocator;
+
+/**
+ * @brief Memory used by the nodes of a tree, see avl_get_footprint.
+ */
+typedef struct {
+  size_t nodes;        ///< Number of nodes.
+  size_t allocations;  ///< Separate allocations holding them, compacted regions count once.
+  size_t bytes;        ///< Bytes allocated for them, including compacted regions in full.
+  size_t span;         ///< Distance between the lowest and highest node addresses, the smaller the better for locality.
+} AVLFootprint;
+
+/**
+ * @brief Bloom filter statistics, see avl_get_filter_stats.
+ */
+typedef struct {
+  size_t bytes;            ///< Memory used by the filter.
+  size_t elements;         ///< Elements set in the filter, removed ones included until it is rebuilt.
+  size_t lookups;          ///< Lookups that went through the filter.
+  size_t rejected;         ///< Lookups the filter answered alone, as misses.
+  size_t false_positives;  ///< Lookups the filter let through that missed anyway.
+  size_t rebuilds;         ///< Times the filter was rebuilt, after growing or after many removals.
+  double expected_fpr;     ///< False-positive rate expected from the bits currently set.
+  double measured_fpr;     ///< false_positives / (false_positives + rejected), 0 before any miss.
+} AVLFilterStats;
+
+/**
+ * @brief Lookup cache statistics, see avl_get_cache_stats.
+ */
+typedef struct {
+  size_t entries;        ///< Number of entries of the cache.
+  size_t bytes;          ///< Memory used by the cache.
+  size_t lookups;        ///< Lookups that went through the cache.
+  size_t hits;           ///< Lookups the cache answered without a descent.
+  size_t invalidations;  ///< Cached nodes dropped because they were removed.
+  double hit_rate;       ///< hits / lookups, 0 before any lookup.
+} AVLCacheStats;
+
 // --- Constructors and Destructors ---
 
 /**
@@ -30,10 +88,83 @@ typedef struct _TreeNode* AVLNode;
  * @param size Size of the stored data in bytes.
  * @param cmp Comparison function for the data.
  * @param del Deletion function for the data.
- * @return The newly created AVL tree.
+ * @return The newly created AVL tree, or NULL if it could not be allocated.
  */
 extern AVLTree avl_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*));
 
+/**
+ * @brief Create a new AVL tree whose nodes keep an aggregate of their subtree, for avl_range_aggregate.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param cmp Comparison function for the data.
+ * @param del Deletion function for the data.
+ * @param augment Augmentation descriptor, NULL behaves like avl_new.
+ * @return The newly created AVL tree, or NULL if it could not be allocated.
+ */
+extern AVLTree avl_new_augmented(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*),
+                                 const AVLAugment* augment);
+
+/**
+ * @brief Create a new AVL tree used as a map, each node storing a fixed-size key followed by its value.
+ *
+ * Nodes start on a cache line with the key right after the links, so searches only read the key bytes. Searches and
+ * removals take a key alone, avl_add and avl_pop_min/avl_pop_max use records made of the key immediately followed by
+ * the value.
+ *
+ * @param key_size Size of the keys in bytes.
+ * @param value_size Size of the values in bytes.
+ * @param cmp Comparison function for the keys.
+ * @param del Deletion function, receiving the record of an entry.
+ * @return The newly created AVL tree, or NULL if it could not be allocated.
+ */
+extern AVLTree avl_new_map(size_t key_size, size_t value_size, int (*cmp)(const void*, const void*),
+                           void (*del)(void*));
+
+/**
+ * @brief Create a new AVL tree used as a map, like avl_new_map, whose memory comes from the given allocator.
+ *
+ * Nodes only start on a cache line if the allocator returns blocks aligned on 64 bytes, as aligned_alloc(64, size)
+ * does. Blocks with the alignment malloc guarantees keep the map correct, searches may then read two cache lines.
+ *
+ * @param key_size Size of the keys in bytes.
+ * @param value_size Size of the values in bytes.
+ * @param cmp Comparison function for the keys.
+ * @param del Deletion function, receiving the record of an entry.
+ * @param allocator Allocator, copied by the tree. NULL uses aligned_alloc and free, as avl_new_map does.
+ * @return The newly created AVL tree, or NULL if it could not be allocated.
+ */
+extern AVLTree avl_new_map_with_allocator(size_t key_size, size_t value_size, int (*cmp)(const void*, const void*),
+                                          void (*del)(void*), const AVLAllocator* allocator);
+
+/**
+ * @brief Create a new AVL tree of variable-length records, stored inline in nodes allocated to their exact length.
+ *
+ * The first prefix_size bytes of each record, zero padded, are kept in front of its node. Comparisons first order these
+ * prefixes like memcmp, and only call cmp when they are equal, so cmp must order records with the same first bytes
+ * the same way (as strcmp does for strings).
+ *
+ * @param prefix_size Size of the stored prefix in bytes, at most AVL_MAX_PREFIX (16). 0 always calls cmp.
+ * @param record_size Function returning the size in bytes of a record, like strlen + 1 for strings.
+ * @param cmp Comparison function for the records.
+ * @param del Deletion function for the records.
+ * @return The newly created AVL tree, or NULL if it could not be allocated or prefix_size is too large.
+ */
+extern AVLTree avl_new_variable(size_t prefix_size, size_t (*record_size)(const void*),
+                                int (*cmp)(const void*, const void*), void (*del)(void*));
+
+/**
+ * @brief Create a new AVL tree whose memory, including the tree itself, comes from the given allocator.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param cmp Comparison function for the data.
+ * @param del Deletion function for the data.
+ * @param augment Augmentation descriptor, or NULL.
+ * @param allocator Allocator, copied by the tree. NULL uses malloc and free.
+ * @return The newly created AVL tree, or NULL if it could not be allocated.
+ */
+extern AVLTree avl_new_with_allocator(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*),
+                                      const AVLAugment* augment, const AVLAllocator* allocator);
+
 /**
  * @brief Delete an AVL tree, freeing all associated memory.
  *
@@ -41,6 +172,28 @@ extern AVLTree avl_new(size_t size, int (*cmp)(const void*, const void*), void (
  */
 extern void avl_delete(AVLTree tree);
 
+/**
+ * @brief Delete an AVL tree from a background thread, so the caller does not wait for every node to be freed.
+ * The deletion function is then called from that thread, and the tree must not be used anymore.
+ *
+ * @param tree The AVL tree to be deleted.
+ * @return 0 if the tree is being deleted in the background, or the error of pthread_create, in which case the tree
+ * was deleted before returning.
+ */
+extern int avl_delete_async(AVLTree tree);
+
+/**
+ * @brief Delete an AVL tree a few nodes at a time, for callers that cannot wait for the whole deletion nor spawn
+ * threads. Once called, the tree must only be passed to further calls, until it returns true.
+ * Nodes are freed in O(n) over all calls, with no extra memory, by rotating left children up so the tree unrolls into
+ * a list.
+ *
+ * @param tree The AVL tree to be deleted.
+ * @param max_nodes Maximum number of nodes freed or rotated during this call.
+ * @return true once every node and the tree itself are freed, false if more calls are needed.
+ */
+extern bool avl_delete_step(AVLTree tree, size_t max_nodes);
+
 // --- Getters ---
 
 /**
@@ -68,13 +221,21 @@ extern int avl_get_height(AVLTree tree);
 extern int avl_node_get_height(AVLNode node);
 
 /**
- * @brief Get the size (number of nodes) of the AVL tree.
+ * @brief Get the size (number of nodes) of the AVL tree, in constant time.
  *
  * @param tree The AVL tree.
  * @return The size of the tree.
  */
 extern int avl_get_size(AVLTree tree);
 
+/**
+ * @brief Get the number of rotations done by the AVL tree since its creation, a double rotation counting as two.
+ *
+ * @param tree The AVL tree.
+ * @return The number of rotations.
+ */
+extern size_t avl_get_rotations(AVLTree tree);
+
 /**
  * @brief Get the left child of a given AVL tree node.
  *
@@ -91,6 +252,22 @@ extern AVLNode avl_node_get_left(AVLNode node);
  */
 extern AVLNode avl_node_get_right(AVLNode node);
 
+/**
+ * @brief Get the node holding the smallest data of the AVL tree, in constant time.
+ *
+ * @param tree The AVL tree.
+ * @return The first node in order, or NULL if the tree is empty.
+ */
+extern AVLNode avl_first(AVLTree tree);
+
+/**
+ * @brief Get the node holding the largest data of the AVL tree, in constant time.
+ *
+ * @param tree The AVL tree.
+ * @return The last node in order, or NULL if the tree is empty.
+ */
+extern AVLNode avl_last(AVLTree tree);
+
 /**
  * @brief Get the data stored in a given AVL tree node.
  *
@@ -99,6 +276,24 @@ extern AVLNode avl_node_get_right(AVLNode node);
  */
 extern void* avl_node_get_data(AVLNode node);
 
+/**
+ * @brief Get the size of the data stored in a given node, which varies between nodes of variable-length trees.
+ *
+ * @param tree The AVL tree holding the node.
+ * @param node The AVL tree node.
+ * @return The size of the data in bytes, 0 if node is NULL.
+ */
+extern size_t avl_node_get_data_size(AVLTree tree, AVLNode node);
+
+/**
+ * @brief Get the value stored in a given node of an AVL map.
+ *
+ * @param tree The AVL map holding the node.
+ * @param node The AVL tree node.
+ * @return Pointer to the value, which can be updated in place.
+ */
+extern void* avl_node_get_value(AVLTree tree, AVLNode node);
+
 /**
  * @brief Check if the AVL tree is valid (balanced and follows AVL properties).
  *
@@ -114,9 +309,39 @@ extern bool avl_is_valid(AVLTree tree);
  *
  * @param tree The AVL tree where data will be inserted.
  * @param data Pointer to the data to be inserted.
- * @return true if insertion was successful, false otherwise.
+ * @return 0 on success or if the data was already in the tree, ENOMEM if no node could be allocated, in which case
+ * the tree is left unchanged.
  */
-extern void avl_add(AVLTree tree, const void* data);
+extern int avl_add(AVLTree tree, const void* data);
+
+/**
+ * @brief Add data to the AVL tree, searching from its left or right edge instead of from the root.
+ *
+ * Suited to keys arriving almost in order: data greater than the largest data (or smaller than the smallest, from the
+ * left edge) is appended after a single comparison, and data close to that edge costs O(log d) comparisons, d being
+ * its distance in order from the edge, instead of O(log n). Without parent links there is no interior finger: data far
+ * from the chosen edge costs O(log n) comparisons as with avl_add, and the edge's spine is walked and rebalanced on
+ * every call.
+ *
+ * @param tree The AVL tree where data will be inserted.
+ * @param left true to search from the left edge (smallest data), false from the right edge (largest data).
+ * @param data Pointer to the data to be inserted.
+ * @return 0 on success or if the data was already in the tree, ENOMEM if no node could be allocated, in which case
+ * the tree is left unchanged.
+ */
+extern int avl_add_edge(AVLTree tree, bool left, const void* data);
+
+/**
+ * @brief Set the value of a key in an AVL map, adding the key if needed or overwriting its value in place.
+ *
+ * The deletion function is not called on an overwritten value.
+ *
+ * @param tree The AVL map.
+ * @param key Pointer to the key.
+ * @param value Pointer to the value.
+ * @return 0 on success, ENOMEM if no node could be allocated, in which case the map is left unchanged.
+ */
+extern int avl_map_put(AVLTree tree, const void* key, const void* value);
 
 // --- Deletion ---
 
@@ -129,6 +354,196 @@ extern void avl_add(AVLTree tree, const void* data);
  */
 extern void avl_remove(AVLTree tree, const void* data);
 
+/**
+ * @brief Remove the smallest data from the AVL tree without calling the comparison function.
+ *
+ * @param tree The AVL tree from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller, of at least its data size. If NULL,
+ * the deletion function is called on the data instead.
+ * @return true if data was removed, false if the tree was empty.
+ */
+extern bool avl_pop_min(AVLTree tree, void* out);
+
+/**
+ * @brief Remove the largest data from the AVL tree without calling the comparison function.
+ *
+ * @param tree The AVL tree from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller, of at least its data size. If NULL,
+ * the deletion function is called on the data instead.
+ * @return true if data was removed, false if the tree was empty.
+ */
+extern bool avl_pop_max(AVLTree tree, void* out);
+
+/**
+ * @brief Remove all data between lo and hi (inclusive) from the AVL tree, calling the deletion function on each.
+ *
+ * The range is detached and freed whole and the remaining parts joined back, in O(log n + k) for k removed data.
+ *
+ * @param tree The AVL tree.
+ * @param lo Pointer to the lower bound.
+ * @param hi Pointer to the upper bound.
+ * @return The number of data removed, 0 if lo > hi.
+ */
+extern size_t avl_remove_range(AVLTree tree, const void* lo, const void* hi);
+
+// --- Compaction ---
+
+/**
+ * @brief Move every node of the AVL tree into a single contiguous region, in order, so that subtrees are contiguous.
+ *
+ * Nodes added afterwards are allocated separately, and removed nodes are only freed with the region, by the next
+ * compaction or avl_delete. Finishes a compaction already in progress instead of starting a new one.
+ *
+ * @param tree The AVL tree.
+ * @param before Footprint before compacting, or NULL.
+ * @param after Footprint after compacting, or NULL.
+ * @return 0 on success, ENOMEM if the region could not be allocated, in which case the tree is left as it was.
+ */
+extern int avl_compact(AVLTree tree, AVLFootprint* before, AVLFootprint* after);
+
+/**
+ * @brief Start an incremental compaction of the AVL tree, run by avl_compact_step.
+ *
+ * The region is sized for the current nodes. The tree can be modified between steps, nodes added past the progress of
+ * the compaction are moved too while the region has room. Does nothing if a compaction is already in progress.
+ *
+ * @param tree The AVL tree.
+ * @return 0 on success, ENOMEM if the region could not be allocated.
+ */
+extern int avl_compact_begin(AVLTree tree);
+
+/**
+ * @brief Visit at most max_nodes nodes of an incremental compaction, moving them, in O(log n + max_nodes).
+ *
+ * Steps resume after the last node moved. If it was removed in between, the next step starts over from the first node,
+ * skipping the nodes already moved.
+ *
+ * @param tree The AVL tree.
+ * @param max_nodes Maximum number of nodes visited by this step.
+ * @param done Set to true once the compaction is finished, or if none is in progress.
+ * @return 0 on success, ENOMEM if a node of the previous region could not be moved out of it, the step can be retried.
+ */
+extern int avl_compact_step(AVLTree tree, size_t max_nodes, bool* done);
+
+/**
+ * @brief Measure the memory used by the nodes of the AVL tree, in O(n).
+ *
+ * @param tree The AVL tree.
+ * @param out Footprint of the tree.
+ */
+extern void avl_get_footprint(AVLTree tree, AVLFootprint* out);
+
+// --- Small Mode ---
+
+/**
+ * @brief Make the AVL tree adaptive: up to threshold records are kept sorted in a single array allocated up front,
+ * searched by bisection, without any node allocation. Past the threshold the records move into nodes, and they move
+ * back once removals bring them down to half of it. The rest of the API behaves the same with both representations,
+ * except for the lifetime of the data pointers it hands out.
+ *
+ * Functions handing out nodes (avl_get_root, avl_first, avl_last, avl_find_node) first move the records into nodes if
+ * needed, and the tree then keeps its nodes and stops being adaptive, so the nodes stay valid as in a regular tree.
+ * They return NULL, with errno set to ENOMEM, if the records could not be moved into nodes, the tree being left
+ * unchanged.
+ * Data pointers (avl_find_data, avl_map_get, avl_find_batch) are only valid until the next change to the tree: records
+ * in the array are shifted by insertions and removals, and move between the array and nodes past the thresholds.
+ * Adaptive trees cannot have variable-length records, augmentations, subtree hashes, filters or lookup caches.
+ *
+ * @param tree The AVL tree, empty.
+ * @param threshold Most records kept in the array, 0 makes the tree a regular one again.
+ * @return 0 on success, EINVAL if the tree is not empty or uses one of the features above, ENOMEM if the array could
+ * not be allocated.
+ */
+extern int avl_set_adaptive(AVLTree tree, size_t threshold);
+
+// --- Bloom Filter ---
+
+/**
+ * @brief Attach a blocked Bloom filter to the AVL tree, so most lookups of absent data return without a descent.
+ * The filter is sized for twice the current size, rebuilt twice as large once that many elements were added, and
+ * rebuilt from the tree once more than half of its elements were removed. Lookups of present data pay one extra
+ * cache line.
+ *
+ * @param tree The AVL tree.
+ * @param hash Hash function of the keys, consistent with the comparison function (data comparing equal hash the
+ * same). NULL detaches the filter.
+ * @param bits_per_element Bits of filter per element, about 10 gives a 1% false-positive rate.
+ * @return 0 on success, EINVAL if bits_per_element is 0 or the tree is adaptive, ENOMEM if the filter could not be
+ * allocated, in which case the previous filter, if any, is kept.
+ */
+extern int avl_set_filter(AVLTree tree, size_t (*hash)(const void* key), size_t bits_per_element);
+
+/**
+ * @brief Get the statistics of the AVL tree's Bloom filter, in O(m) for a filter of m bytes.
+ *
+ * @param tree The AVL tree.
+ * @param out Statistics of the filter, all 0 if no filter is attached.
+ */
+extern void avl_get_filter_stats(AVLTree tree, AVLFilterStats* out);
+
+// --- Lookup Cache ---
+
+/**
+ * @brief Attach a direct-mapped cache of recently found nodes to the AVL tree, so repeated lookups of the same keys
+ * skip the descent and pay a single comparison. Found nodes replace whatever their entry held, removed nodes are
+ * dropped from it.
+ *
+ * @param tree The AVL tree.
+ * @param hash Hash function of the keys, consistent with the comparison function (data comparing equal hash the
+ * same). NULL detaches the cache.
+ * @param entries Number of entries, rounded up to a power of 2 of at least 4 (one cache line).
+ * @return 0 on success, EINVAL if entries is 0 or the tree is adaptive, ENOMEM if the cache could not be allocated, in
+ * which case the previous cache, if any, is kept.
+ */
+extern int avl_set_cache(AVLTree tree, size_t (*hash)(const void* key), size_t entries);
+
+/**
+ * @brief Get the statistics of the AVL tree's lookup cache.
+ *
+ * @param tree The AVL tree.
+ * @param out Statistics of the cache, all 0 if no cache is attached.
+ */
+extern void avl_get_cache_stats(AVLTree tree, AVLCacheStats* out);
+
+// --- Merkle Hashes ---
+
+/**
+ * @brief Keep a hash of every subtree, maintained through insertions, removals and rotations, so trees holding the
+ * same data (such as replicas) can be compared with avl_get_merkle_hash and diffed with avl_diff. Nodes then store
+ * their subtree hash, so it can only be changed while the tree is empty.
+ *
+ * A subtree hash is the sum of the mixed hashes of its records, so it does not depend on the shape of the tree: trees
+ * built in different orders have the same hash when they hold the same records.
+ *
+ * @param tree The AVL tree, empty and of fixed-size records.
+ * @param hash Hash function of whole records, values included in maps. NULL stops keeping hashes.
+ * @return 0 on success, EINVAL if the tree is not empty, adaptive or has variable-length records.
+ */
+extern int avl_set_merkle(AVLTree tree, size_t (*hash)(const void* data));
+
+/**
+ * @brief Get the hash of all the records of an AVL tree, in constant time.
+ *
+ * @param tree The AVL tree.
+ * @return The hash of the whole tree, 0 if it is empty or does not keep hashes.
+ */
+extern size_t avl_get_merkle_hash(AVLTree tree);
+
+/**
+ * @brief Call a function on every difference between two AVL trees keeping hashes with the same hash function, in
+ * order. Subtrees of a whose hash matches the records of b in the same range are skipped, so d differences cost
+ * O((d + 1) log^2 n) comparisons instead of O(n).
+ * The function must not change the trees.
+ *
+ * @param a The first AVL tree.
+ * @param b The second AVL tree.
+ * @param func Function called with the data of a and the data of b comparing equal to it, a_data being NULL for data
+ * only in b, b_data NULL for data only in a, and both set for data whose records hash differently (as map values).
+ * @param arg Argument passed to the function along with the data.
+ * @return 0 on success, EINVAL if either tree does not keep hashes.
+ */
+extern int avl_diff(AVLTree a, AVLTree b, void (*func)(const void* a_data, const void* b_data, void* arg), void* arg);
+
 // --- Search ---
 
 /**
@@ -142,9 +557,45 @@ extern AVLNode avl_find_node(AVLTree tree, const void* data);
 
 /**
  * @brief Find data in the AVL tree.
+ * In adaptive trees, the pointer is only valid until the next change to the tree (see avl_set_adaptive).
  *
  * @param tree The AVL tree to search.
  * @param data Pointer to the data to search for.
  * @return Pointer to the found data, or NULL if not found.
  */
 extern void* avl_find_data(AVLTree tree, const void* data);
+
+/**
+ * @brief Find the value of a key in an AVL map, only comparing keys.
+ * In adaptive trees, the pointer is only valid until the next change to the tree (see avl_set_adaptive).
+ *
+ * @param tree The AVL map to search.
+ * @param key Pointer to the key to search for.
+ * @return Pointer to the value, which can be updated in place, or NULL if not found.
+ */
+extern void* avl_map_get(AVLTree tree, const void* key);
+
+/**
+ * @brief Find many data in the AVL tree at once, interleaving the lookups so their cache misses overlap.
+ * In adaptive trees, the pointers are only valid until the next change to the tree (see avl_set_adaptive).
+ *
+ * @param tree The AVL tree to search.
+ * @param data Array of count data to search for, each of the tree's data size (key size for maps). For
+ *        variable-length trees, array of count pointers to records.
+ * @param count Number of data to search for.
+ * @param results Array of count pointers, receiving the found data or NULL for each searched data.
+ * @return The number of data found.
+ */
+extern size_t avl_find_batch(AVLTree tree, const void* data, size_t count, void** results);
+
+/**
+ * @brief Aggregate all data between lo and hi (both included) in O(log n), using the tree's augmentation.
+ * Works in scratch space allocated with the tree, so concurrent calls on the same tree are not allowed.
+ *
+ * @param tree The augmented AVL tree.
+ * @param lo Pointer to the lower bound.
+ * @param hi Pointer to the upper bound.
+ * @param out Buffer receiving the aggregate, the identity if no data is in the range.
+ * @return 0 on success, EINVAL if the tree was not created with an augmentation.
+ */
+extern int avl_range_aggregate(AVLTree tree, const void* lo, const void* hi, void* out);
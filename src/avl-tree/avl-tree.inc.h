@@ -8,8 +8,18 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
-typedef struct _TreeNode* AVLNode;
+#include "avl-tree.h"
+
+#define AVL_MAX_HEIGHT 96  // 1.44 * log2(n) stays below it for any size_t node count
+#define AVL_BATCH_GROUP 16  // lookups in flight in avl_find_batch
+#define AVL_CACHE_LINE 64
+#define AVL_MAX_PREFIX 16  // largest key prefix stored in front of variable-length nodes
+#define AVL_FILTER_BLOCK_WORDS 8  // 512-bit filter blocks, one cache line each
+#define AVL_FILTER_MIN_CAPACITY 64
+#define AVL_FILTER_MAX_HASHES 16
+#define AVL_LOOKUP_CACHE_LINE_ENTRIES 4  // lookup cache entries sharing a cache line
 
 struct _TreeNode {
   AVLNode left;
@@ -18,9 +28,71 @@ struct _TreeNode {
   char data[1];
 };
 
+// Blocked Bloom filter: every key sets bits of a single block, so testing it reads one cache line
+// see: Putze et al., "Cache-, Hash- and Space-Efficient Bloom Filters" (2007)
+struct avl_filter {
+  uint64_t* blocks;  // NULL when no filter is attached
+  void* allocation;  // blocks, before they were aligned on a cache line
+  size_t block_count;
+  size_t capacity;  // elements the filter was sized for, it is rebuilt larger beyond them
+  size_t count;     // elements set since the last rebuild, removed ones included
+  size_t bits_per_element;
+  int hash_count;
+  size_t (*hash)(const void* key);
+  size_t lookups;
+  size_t rejected;
+  size_t false_positives;
+  size_t rebuilds;
+};
+
+// Direct-mapped cache of found nodes, indexed and tagged by the mixed key hash. Entries are dropped when their node is
+// freed and follow it when compaction moves it, removals never move data between nodes.
+struct avl_lookup_entry {
+  uint64_t tag;
+  AVLNode node;  // NULL for an empty entry
+};
+
+struct avl_lookup_cache {
+  struct avl_lookup_entry* entries;  // NULL when no cache is attached
+  void* allocation;                 // entries, before they were aligned on a cache line
+  size_t mask;                      // entry count - 1, a power of 2
+  size_t (*hash)(const void* key);
+  size_t lookups;
+  size_t hits;
+  size_t invalidations;
+};
+
 struct _AVLTree {
   AVLNode root;
+  AVLNode min;
+  AVLNode max;
   size_t data_size;
+  size_t key_size;  // leading bytes of the data read by the comparison function, the value follows in maps
+  size_t node_size;
+  size_t augment_offset;  // aggregates are stored after the data, aligned from the start of the node
+  AVLAugment augment;     // compute is NULL when the tree is not augmented
+  char* augment_scratch;  // room for the 3 aggregates of a range query, allocated with the identity
+  size_t merkle_offset;   // subtree hashes are stored after the aggregate, 0 when they are not kept
+  size_t (*merkle_hash)(const void* data);
+  AVLAllocator allocator;
+  size_t (*record_size)(const void* data);  // NULL unless records have variable lengths
+  size_t prefix_size;                       // record bytes kept in front of variable-length nodes for early-outs
+  size_t header_size;                       // bytes allocated in front of each node, 0 for fixed-size records
+  size_t node_align;                        // alignment of the nodes in compacted regions
+  size_t node_count;
+  size_t node_bytes;      // size of a compacted region holding every node
+  size_t rotations;       // single rotations done since the tree was created
+  char* small;            // sorted records of an adaptive tree, NULL when it is not adaptive
+  size_t small_capacity;  // records the array holds, the tree switches to nodes past them
+  struct avl_filter filter;
+  struct avl_lookup_cache cache;
+  // Compaction: region holds the nodes laid out by the last one, next_region is filled by the one in progress
+  char* region;
+  size_t region_size;
+  char* next_region;
+  size_t next_region_size;
+  size_t next_region_used;
+  AVLNode cursor;  // last node moved by the compaction in progress, NULL to start from the first node
   int (*compare)(const void* a, const void* b);
   void (*delete_data)(void* data);
 };
@@ -0,0 +1,143 @@
+/**
+ * @file dary-heap.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "dary-heap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dary-heap.inc.h"
+
+#define INITIAL_CAPACITY 16
+
+static inline char* element(DAryHeap heap, int index) { return heap->data + (size_t)index * heap->data_size; }
+
+// --- Constructor and Destructor ---
+
+DAryHeap dheap_new(size_t size, int arity, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  DAryHeap heap = malloc(sizeof(struct _DAryHeap));
+  if (!heap) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+
+  heap->data = malloc(INITIAL_CAPACITY * size);
+  heap->hole = malloc(size);
+  if (!heap->data || !heap->hole) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  heap->data_size = size;
+  heap->arity = arity < 2 ? 2 : arity;
+  heap->size = 0;
+  heap->capacity = INITIAL_CAPACITY;
+  heap->compare = cmp;
+  heap->delete_data = del;
+
+  return heap;
+}
+
+void dheap_delete(DAryHeap heap) {
+  if (!heap) {
+    return;
+  }
+
+  if (heap->delete_data) {
+    for (int i = 0; i < heap->size; i++) {
+      heap->delete_data(element(heap, i));
+    }
+  }
+  free(heap->data);
+  free(heap->hole);
+  free(heap);
+}
+
+// --- Getters ---
+
+int dheap_get_size(DAryHeap heap) { return heap->size; }
+
+void* dheap_peek(DAryHeap heap) {
+  if (heap == NULL || heap->size == 0) {
+    return NULL;
+  }
+  return heap->data;
+}
+
+bool dheap_is_valid(DAryHeap heap) {
+  for (int i = 1; i < heap->size; i++) {
+    if (heap->compare(element(heap, i), element(heap, (i - 1) / heap->arity)) < 0) return false;
+  }
+  return true;
+}
+
+// --- Sifting ---
+// The moving element waits in heap->hole while the elements it passes are shifted by one level, saving a copy per level
+// compared to swapping.
+
+static void sift_up(DAryHeap heap, int index) {
+  while (index > 0) {
+    int parent = (index - 1) / heap->arity;
+    if (heap->compare(heap->hole, element(heap, parent)) >= 0) break;
+    memcpy(element(heap, index), element(heap, parent), heap->data_size);
+    index = parent;
+  }
+  memcpy(element(heap, index), heap->hole, heap->data_size);
+}
+
+static void sift_down(DAryHeap heap, int index) {
+  for (;;) {
+    int first = index * heap->arity + 1;
+    if (first >= heap->size) break;
+
+    int last = first + heap->arity < heap->size ? first + heap->arity : heap->size;
+    int smallest = first;
+    for (int child = first + 1; child < last; child++) {
+      if (heap->compare(element(heap, child), element(heap, smallest)) < 0) smallest = child;
+    }
+
+    if (heap->compare(element(heap, smallest), heap->hole) >= 0) break;
+    memcpy(element(heap, index), element(heap, smallest), heap->data_size);
+    index = smallest;
+  }
+  memcpy(element(heap, index), heap->hole, heap->data_size);
+}
+
+// --- Insertion ---
+
+void dheap_push(DAryHeap heap, const void* data) {
+  if (heap->size == heap->capacity) {
+    char* data_array = realloc(heap->data, 2 * (size_t)heap->capacity * heap->data_size);
+    if (!data_array) {
+      perror("Out of memory");
+      exit(EXIT_FAILURE);
+    }
+    heap->data = data_array;
+    heap->capacity *= 2;
+  }
+
+  memcpy(heap->hole, data, heap->data_size);
+  sift_up(heap, heap->size++);
+}
+
+// --- Deletion ---
+
+bool dheap_pop(DAryHeap heap, void* out) {
+  if (heap->size == 0) return false;
+
+  if (out != NULL) {
+    memcpy(out, heap->data, heap->data_size);
+  } else if (heap->delete_data) {
+    heap->delete_data(heap->data);
+  }
+
+  if (--heap->size > 0) {
+    memcpy(heap->hole, element(heap, heap->size), heap->data_size);
+    sift_down(heap, 0);
+  }
+  return true;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file dary-heap.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief d-ary min-heap type, elements are stored inline in one contiguous array.
+ */
+typedef struct _DAryHeap* DAryHeap;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new d-ary heap.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param arity Number of children per node, at least 2. 4 keeps all children of a small element in one cache line.
+ * @param cmp Comparison function for the data, the smallest element is on top.
+ * @param del Deletion function for the data.
+ * @return The newly created d-ary heap.
+ */
+extern DAryHeap dheap_new(size_t size, int arity, int (*cmp)(const void*, const void*), void (*del)(void*));
+
+/**
+ * @brief Delete a d-ary heap, freeing all associated memory.
+ *
+ * @param heap The d-ary heap to be deleted.
+ */
+extern void dheap_delete(DAryHeap heap);
+
+// --- Getters ---
+
+/**
+ * @brief Get the number of elements in the d-ary heap.
+ *
+ * @param heap The d-ary heap.
+ * @return The number of elements.
+ */
+extern int dheap_get_size(DAryHeap heap);
+
+/**
+ * @brief Get the smallest element of the d-ary heap without removing it.
+ *
+ * @param heap The d-ary heap.
+ * @return Pointer to the smallest element, or NULL if the heap is empty. Invalidated by the next push or pop.
+ */
+extern void* dheap_peek(DAryHeap heap);
+
+/**
+ * @brief Check if the d-ary heap is valid (every element is not smaller than its parent).
+ *
+ * @param heap The d-ary heap to be checked.
+ * @return true if the heap is valid, false otherwise.
+ */
+extern bool dheap_is_valid(DAryHeap heap);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the d-ary heap.
+ *
+ * @param heap The d-ary heap where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ */
+extern void dheap_push(DAryHeap heap, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove the smallest element from the d-ary heap.
+ *
+ * @param heap The d-ary heap from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller. If NULL, the deletion function is
+ * called on the data instead.
+ * @return true if data was removed, false if the heap was empty.
+ */
+extern bool dheap_pop(DAryHeap heap, void* out);
@@ -0,0 +1,21 @@
+/**
+ * @file dary-heap.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+struct _DAryHeap {
+  char* data;  // element i is at data + i * data_size, children of i are i * arity + 1 ... i * arity + arity
+  char* hole;  // scratch element used to sift without swapping
+  size_t data_size;
+  int arity;
+  int size;
+  int capacity;
+  int (*compare)(const void* a, const void* b);
+  void (*delete_data)(void* data);
+};
@@ -0,0 +1,200 @@
+/**
+ * @file pairing-heap.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "pairing-heap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pairing-heap.inc.h"
+
+// see: Fredman, Sedgewick, Sleator & Tarjan, "The pairing heap: A new form of self-adjusting heap" (1986)
+
+// --- Constructor and Destructor ---
+
+static PairingNode pheap_node_new(const void* data, size_t size) {
+  PairingNode node = malloc(offsetof(struct _PairingNode, data) + size);
+  if (!node) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  node->child = NULL;
+  node->sibling = NULL;
+  node->prev = NULL;
+  memcpy(node->data, data, size);
+  return node;
+}
+
+PairingHeap pheap_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  PairingHeap heap = malloc(sizeof(struct _PairingHeap));
+  if (!heap) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+
+  heap->root = NULL;
+  heap->data_size = size;
+  heap->size = 0;
+  heap->compare = cmp;
+  heap->delete_data = del;
+
+  return heap;
+}
+
+// iterative, a pairing heap can degenerate into a very long sibling list
+static void delete_all_nodes(PairingNode node, void del(void*)) {
+  while (node != NULL) {
+    if (node->child != NULL) {
+      // splice the children in front of the siblings to flatten the heap as we go
+      PairingNode last = node->child;
+      while (last->sibling != NULL) last = last->sibling;
+      last->sibling = node->sibling;
+      node->sibling = node->child;
+      node->child = NULL;
+    }
+    PairingNode next = node->sibling;
+    if (del) del(node->data);
+    free(node);
+    node = next;
+  }
+}
+
+void pheap_delete(PairingHeap heap) {
+  if (!heap) {
+    return;
+  }
+
+  delete_all_nodes(heap->root, heap->delete_data);
+  free(heap);
+}
+
+// --- Getters ---
+
+int pheap_get_size(PairingHeap heap) { return heap->size; }
+
+PairingNode pheap_peek(PairingHeap heap) {
+  if (heap == NULL) {
+    return NULL;
+  }
+  return heap->root;
+}
+
+void* pheap_node_get_data(PairingNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->data;
+}
+
+static bool pheap_node_is_valid(PairingHeap heap, PairingNode node) {
+  PairingNode prev = node;
+  for (PairingNode child = node->child; child != NULL; child = child->sibling) {
+    if (child->prev != prev) return false;
+    if (heap->compare(child->data, node->data) < 0) return false;
+    if (!pheap_node_is_valid(heap, child)) return false;
+    prev = child;
+  }
+  return true;
+}
+
+bool pheap_is_valid(PairingHeap heap) {
+  if (heap->root == NULL) return heap->size == 0;
+  if (heap->root->prev != NULL || heap->root->sibling != NULL) return false;
+  return pheap_node_is_valid(heap, heap->root);
+}
+
+// --- Linking ---
+
+// Both nodes must be detached roots, the larger becomes the leftmost child of the smaller
+static PairingNode pheap_merge(PairingHeap heap, PairingNode a, PairingNode b) {
+  if (heap->compare(b->data, a->data) < 0) {
+    PairingNode temp = a;
+    a = b;
+    b = temp;
+  }
+
+  b->sibling = a->child;
+  if (a->child != NULL) a->child->prev = b;
+  b->prev = a;
+  a->child = b;
+  return a;
+}
+
+// Two-pass pairing: merge children in pairs left to right, then fold the pairs right to left
+static PairingNode pheap_merge_pairs(PairingHeap heap, PairingNode first) {
+  PairingNode pairs = NULL;  // merged pairs, stacked through their sibling link
+
+  while (first != NULL) {
+    PairingNode a = first;
+    PairingNode b = a->sibling;
+    first = b != NULL ? b->sibling : NULL;
+
+    a->sibling = NULL;
+    a->prev = NULL;
+    if (b != NULL) {
+      b->sibling = NULL;
+      b->prev = NULL;
+      a = pheap_merge(heap, a, b);
+    }
+    a->sibling = pairs;
+    pairs = a;
+  }
+
+  PairingNode root = NULL;
+  while (pairs != NULL) {
+    PairingNode next = pairs->sibling;
+    pairs->sibling = NULL;
+    root = root == NULL ? pairs : pheap_merge(heap, root, pairs);
+    pairs = next;
+  }
+  return root;
+}
+
+// --- Insertion ---
+
+PairingNode pheap_push(PairingHeap heap, const void* data) {
+  PairingNode node = pheap_node_new(data, heap->data_size);
+  heap->root = heap->root == NULL ? node : pheap_merge(heap, heap->root, node);
+  heap->size++;
+  return node;
+}
+
+void pheap_decrease_key(PairingHeap heap, PairingNode node, const void* data) {
+  memcpy(node->data, data, heap->data_size);
+  if (node == heap->root) return;
+
+  // cut the subtree rooted at node and merge it back with the root
+  if (node->prev->child == node) {
+    node->prev->child = node->sibling;
+  } else {
+    node->prev->sibling = node->sibling;
+  }
+  if (node->sibling != NULL) node->sibling->prev = node->prev;
+  node->sibling = NULL;
+  node->prev = NULL;
+
+  heap->root = pheap_merge(heap, heap->root, node);
+}
+
+// --- Deletion ---
+
+bool pheap_pop(PairingHeap heap, void* out) {
+  if (heap->root == NULL) return false;
+
+  PairingNode root = heap->root;
+  if (out != NULL) {
+    memcpy(out, root->data, heap->data_size);
+  } else if (heap->delete_data) {
+    heap->delete_data(root->data);
+  }
+
+  heap->root = pheap_merge_pairs(heap, root->child);
+  heap->size--;
+  free(root);
+  return true;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file pairing-heap.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief Pairing min-heap type.
+ */
+typedef struct _PairingHeap* PairingHeap;
+
+/**
+ * @brief Pairing heap node type, stays valid as a handle to its element until the element is popped.
+ */
+typedef struct _PairingNode* PairingNode;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new pairing heap.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param cmp Comparison function for the data, the smallest element is on top.
+ * @param del Deletion function for the data.
+ * @return The newly created pairing heap.
+ */
+extern PairingHeap pheap_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*));
+
+/**
+ * @brief Delete a pairing heap, freeing all associated memory.
+ *
+ * @param heap The pairing heap to be deleted.
+ */
+extern void pheap_delete(PairingHeap heap);
+
+// --- Getters ---
+
+/**
+ * @brief Get the number of elements in the pairing heap.
+ *
+ * @param heap The pairing heap.
+ * @return The number of elements.
+ */
+extern int pheap_get_size(PairingHeap heap);
+
+/**
+ * @brief Get the node holding the smallest element of the pairing heap.
+ *
+ * @param heap The pairing heap.
+ * @return The top node, or NULL if the heap is empty.
+ */
+extern PairingNode pheap_peek(PairingHeap heap);
+
+/**
+ * @brief Get the data stored in a given pairing heap node.
+ *
+ * @param node The pairing heap node.
+ * @return Pointer to the data stored in the node.
+ */
+extern void* pheap_node_get_data(PairingNode node);
+
+/**
+ * @brief Check if the pairing heap is valid (every node is not smaller than its parent and links are consistent).
+ *
+ * @param heap The pairing heap to be checked.
+ * @return true if the heap is valid, false otherwise.
+ */
+extern bool pheap_is_valid(PairingHeap heap);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the pairing heap in constant time.
+ *
+ * @param heap The pairing heap where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ * @return Handle to the new element, usable with pheap_decrease_key until it is popped.
+ */
+extern PairingNode pheap_push(PairingHeap heap, const void* data);
+
+/**
+ * @brief Replace the data of an element with a smaller or equal one, in constant time.
+ *
+ * @param heap The pairing heap holding the node.
+ * @param node Handle returned by pheap_push.
+ * @param data Pointer to the new data, must not compare greater than the current data.
+ */
+extern void pheap_decrease_key(PairingHeap heap, PairingNode node, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove the smallest element from the pairing heap, in amortized O(log n) time.
+ *
+ * @param heap The pairing heap from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller. If NULL, the deletion function is
+ * called on the data instead.
+ * @return true if data was removed, false if the heap was empty.
+ */
+extern bool pheap_pop(PairingHeap heap, void* out);
@@ -0,0 +1,27 @@
+/**
+ * @file pairing-heap.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+typedef struct _PairingNode* PairingNode;
+
+struct _PairingNode {
+  PairingNode child;    // leftmost child
+  PairingNode sibling;  // next sibling to the right
+  PairingNode prev;     // previous sibling, or parent for a leftmost child
+  char data[1];
+};
+
+struct _PairingHeap {
+  PairingNode root;
+  size_t data_size;
+  int size;
+  int (*compare)(const void* a, const void* b);
+  void (*delete_data)(void* data);
+};
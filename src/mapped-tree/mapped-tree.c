@@ -0,0 +1,334 @@
+/**
+ * @file mapped-tree.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "mapped-tree.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../min-max.h"
+#include "mapped-tree.inc.h"
+
+// --- File Allocator ---
+
+static struct mapped_header* mapped_header(MappedTree tree) { return (struct mapped_header*)tree->base; }
+
+// Node pointers are only valid until the file grows, offsets stay valid forever
+static struct mapped_node* mapped_node(MappedTree tree, uint64_t offset) {
+  return (struct mapped_node*)(tree->base + offset);
+}
+
+// Maps the first size bytes of the file, replacing the previous mapping
+static int mapped_map(MappedTree tree, size_t size) {
+  void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, tree->fd, 0);
+  if (base == MAP_FAILED) return errno;
+  if (tree->base) munmap(tree->base, tree->mapped_size);
+  tree->base = base;
+  tree->mapped_size = size;
+  return 0;
+}
+
+// Makes sure the next allocation fits in the mapping, so no node pointer is invalidated during an insertion
+static int mapped_reserve(MappedTree tree) {
+  struct mapped_header* header = mapped_header(tree);
+  if (header->free_list != 0 || header->used + header->node_size <= tree->mapped_size) return 0;
+
+  // Doubling may not be enough for nodes larger than the file, sizes stay multiples of the page size
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t size = (MAX(tree->mapped_size * 2, header->used + header->node_size) + page - 1) / page * page;
+  if (ftruncate(tree->fd, size) != 0) return errno;
+  return mapped_map(tree, size);
+}
+
+static uint64_t mapped_alloc(MappedTree tree) {
+  struct mapped_header* header = mapped_header(tree);
+  uint64_t offset = header->free_list;
+  if (offset != 0) {
+    header->free_list = mapped_node(tree, offset)->left;
+  } else {
+    offset = header->used;
+    header->used += header->node_size;
+  }
+  return offset;
+}
+
+static void mapped_free(MappedTree tree, uint64_t offset) {
+  struct mapped_header* header = mapped_header(tree);
+  mapped_node(tree, offset)->left = header->free_list;
+  header->free_list = offset;
+}
+
+// --- Constructor and Destructor ---
+
+// Closes a tree that could not be opened, errno is left to the error that prevented it
+static MappedTree mapped_open_failed(MappedTree tree, int error) {
+  mapped_close(tree);
+  errno = error;
+  return NULL;
+}
+
+MappedTree mapped_open(const char* path, size_t size, int (*cmp)(const void*, const void*)) {
+  MappedTree tree = malloc(sizeof(struct _MappedTree));
+  if (!tree) {
+    return NULL;
+  }
+
+  tree->base = NULL;
+  tree->mapped_size = 0;
+  tree->compare = cmp;
+  tree->fd = open(path, O_RDWR | O_CREAT, 0644);
+  struct stat st;
+  if (tree->fd < 0 || fstat(tree->fd, &st) != 0) return mapped_open_failed(tree, errno);
+
+  bool created = st.st_size == 0;
+  if (created && ftruncate(tree->fd, MAPPED_INITIAL_SIZE) != 0) return mapped_open_failed(tree, errno);
+  size_t file_size = created ? MAPPED_INITIAL_SIZE : (size_t)st.st_size;
+  if (file_size < MAPPED_HEADER_SIZE) return mapped_open_failed(tree, EINVAL);
+  int error = mapped_map(tree, file_size);
+  if (error) return mapped_open_failed(tree, error);
+
+  struct mapped_header* header = mapped_header(tree);
+  size_t node_size = (offsetof(struct mapped_node, data) + size + 7) / 8 * 8;
+  if (created) {
+    memcpy(header->magic, MAPPED_MAGIC, sizeof(header->magic));
+    header->version = MAPPED_VERSION;
+    header->data_size = size;
+    header->node_size = node_size;
+    header->root = 0;
+    header->node_count = 0;
+    header->free_list = 0;
+    header->used = MAPPED_HEADER_SIZE;
+  } else if (memcmp(header->magic, MAPPED_MAGIC, sizeof(header->magic)) != 0 || header->version != MAPPED_VERSION ||
+             header->data_size != size || header->node_size != node_size || header->used > file_size) {
+    return mapped_open_failed(tree, EINVAL);
+  }
+
+  return tree;
+}
+
+void mapped_close(MappedTree tree) {
+  if (!tree) {
+    return;
+  }
+
+  if (tree->base) munmap(tree->base, tree->mapped_size);
+  if (tree->fd >= 0) close(tree->fd);
+  free(tree);
+}
+
+int mapped_sync(MappedTree tree) { return msync(tree->base, tree->mapped_size, MS_SYNC) == 0 ? 0 : errno; }
+
+// --- Getters ---
+
+size_t mapped_get_size(MappedTree tree) { return mapped_header(tree)->node_count; }
+
+size_t mapped_get_file_size(MappedTree tree) { return tree->mapped_size; }
+
+static int mapped_height(MappedTree tree, uint64_t offset) { return offset ? mapped_node(tree, offset)->height : 0; }
+
+// Returns the height of a valid subtree, -1 otherwise. prev is the last data visited in order, NULL before the first.
+static int mapped_node_is_valid(MappedTree tree, uint64_t offset, const void** prev, size_t* count) {
+  if (offset == 0) return 0;
+  if (offset >= mapped_header(tree)->used) return -1;
+
+  struct mapped_node* node = mapped_node(tree, offset);
+  int left = mapped_node_is_valid(tree, node->left, prev, count);
+  if (left < 0 || (*prev != NULL && tree->compare(*prev, node->data) >= 0)) return -1;
+  *prev = node->data;
+  (*count)++;
+  int right = mapped_node_is_valid(tree, node->right, prev, count);
+  if (right < 0 || abs(left - right) > 1 || node->height != 1 + MAX(left, right)) return -1;
+  return node->height;
+}
+
+bool mapped_is_valid(MappedTree tree) {
+  const void* prev = NULL;
+  size_t count = 0;
+  return mapped_node_is_valid(tree, mapped_header(tree)->root, &prev, &count) >= 0 &&
+         count == mapped_header(tree)->node_count;
+}
+
+// --- Rotations and Rebalancing ---
+
+static void mapped_update(MappedTree tree, uint64_t offset) {
+  struct mapped_node* node = mapped_node(tree, offset);
+  node->height = 1 + MAX(mapped_height(tree, node->left), mapped_height(tree, node->right));
+}
+
+static uint64_t rotate_left(MappedTree tree, uint64_t offset) {
+  struct mapped_node* node = mapped_node(tree, offset);
+  uint64_t right = node->right;
+  node->right = mapped_node(tree, right)->left;
+  mapped_node(tree, right)->left = offset;
+  mapped_update(tree, offset);
+  mapped_update(tree, right);
+  return right;
+}
+
+static uint64_t rotate_right(MappedTree tree, uint64_t offset) {
+  struct mapped_node* node = mapped_node(tree, offset);
+  uint64_t left = node->left;
+  node->left = mapped_node(tree, left)->right;
+  mapped_node(tree, left)->right = offset;
+  mapped_update(tree, offset);
+  mapped_update(tree, left);
+  return left;
+}
+
+static uint64_t rebalance(MappedTree tree, uint64_t offset) {
+  mapped_update(tree, offset);
+  struct mapped_node* node = mapped_node(tree, offset);
+  int balance = mapped_height(tree, node->left) - mapped_height(tree, node->right);
+
+  if (balance > 1) {
+    struct mapped_node* left = mapped_node(tree, node->left);
+    if (mapped_height(tree, left->left) < mapped_height(tree, left->right)) {
+      node->left = rotate_left(tree, node->left);
+    }
+    return rotate_right(tree, offset);
+  }
+  if (balance < -1) {
+    struct mapped_node* right = mapped_node(tree, node->right);
+    if (mapped_height(tree, right->right) < mapped_height(tree, right->left)) {
+      node->right = rotate_right(tree, node->right);
+    }
+    return rotate_left(tree, offset);
+  }
+  return offset;
+}
+
+// --- Insertion ---
+
+// Returns the offset of the subtree root, the file must already have room for a node
+static uint64_t mapped_node_add(MappedTree tree, uint64_t offset, const void* data) {
+  if (offset == 0) {
+    struct mapped_header* header = mapped_header(tree);
+    uint64_t new_offset = mapped_alloc(tree);
+    struct mapped_node* new_node = mapped_node(tree, new_offset);
+    new_node->left = 0;
+    new_node->right = 0;
+    new_node->height = 1;
+    memcpy(new_node->data, data, header->data_size);
+    header->node_count++;
+    return new_offset;
+  }
+
+  struct mapped_node* node = mapped_node(tree, offset);
+  int cmp = tree->compare(data, node->data);
+  if (cmp == 0) return offset;  // data already in tree
+  if (cmp < 0) {
+    node->left = mapped_node_add(tree, node->left, data);
+  } else {
+    node->right = mapped_node_add(tree, node->right, data);
+  }
+  return rebalance(tree, offset);
+}
+
+int mapped_add(MappedTree tree, const void* data) {
+  int error = mapped_reserve(tree);
+  if (error) return error;
+
+  struct mapped_header* header = mapped_header(tree);
+  header->root = mapped_node_add(tree, header->root, data);
+  return 0;
+}
+
+// --- Deletion ---
+
+static uint64_t mapped_detach_min(MappedTree tree, uint64_t offset, uint64_t* min) {
+  struct mapped_node* node = mapped_node(tree, offset);
+  if (node->left == 0) {
+    *min = offset;
+    return node->right;
+  }
+
+  node->left = mapped_detach_min(tree, node->left, min);
+  return rebalance(tree, offset);
+}
+
+static uint64_t mapped_node_remove(MappedTree tree, uint64_t offset, const void* data, bool* removed) {
+  if (offset == 0) {
+    return 0;
+  }
+
+  struct mapped_node* node = mapped_node(tree, offset);
+  int cmp = tree->compare(data, node->data);
+  if (cmp < 0) {
+    node->left = mapped_node_remove(tree, node->left, data, removed);
+  } else if (cmp > 0) {
+    node->right = mapped_node_remove(tree, node->right, data, removed);
+  } else {
+    *removed = true;
+    mapped_header(tree)->node_count--;
+    if (node->left == 0 || node->right == 0) {  // One child or no child
+      uint64_t child = node->left ? node->left : node->right;
+      mapped_free(tree, offset);
+      return child;
+    }
+
+    // The successor node takes the place of the removed one
+    uint64_t successor;
+    uint64_t right = mapped_detach_min(tree, node->right, &successor);
+    mapped_node(tree, successor)->left = node->left;
+    mapped_node(tree, successor)->right = right;
+    mapped_free(tree, offset);
+    offset = successor;
+  }
+
+  return rebalance(tree, offset);
+}
+
+bool mapped_remove(MappedTree tree, const void* data) {
+  bool removed = false;
+  struct mapped_header* header = mapped_header(tree);
+  header->root = mapped_node_remove(tree, header->root, data, &removed);
+  return removed;
+}
+
+// --- Search ---
+
+void* mapped_find_data(MappedTree tree, const void* data) {
+  uint64_t offset = mapped_header(tree)->root;
+
+  while (offset != 0) {
+    struct mapped_node* node = mapped_node(tree, offset);
+    int cmp = tree->compare(data, node->data);
+    if (cmp == 0) {
+      return node->data;
+    }
+    offset = cmp < 0 ? node->left : node->right;
+  }
+
+  return NULL;
+}
+
+static size_t mapped_node_range(MappedTree tree, uint64_t offset, const void* lo, const void* hi,
+                                void (*func)(const void* data, void* arg), void* arg) {
+  if (offset == 0) return 0;
+
+  struct mapped_node* node = mapped_node(tree, offset);
+  bool above_lo = lo == NULL || tree->compare(node->data, lo) >= 0;
+  bool below_hi = hi == NULL || tree->compare(node->data, hi) <= 0;
+  size_t count = 0;
+  if (above_lo) count += mapped_node_range(tree, node->left, lo, hi, func, arg);
+  if (above_lo && below_hi) {
+    func(node->data, arg);
+    count++;
+  }
+  if (below_hi) count += mapped_node_range(tree, node->right, lo, hi, func, arg);
+  return count;
+}
+
+size_t mapped_range(MappedTree tree, const void* lo, const void* hi, void (*func)(const void* data, void* arg),
+                    void* arg) {
+  return mapped_node_range(tree, mapped_header(tree)->root, lo, hi, func, arg);
+}
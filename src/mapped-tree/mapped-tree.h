@@ -0,0 +1,130 @@
+/**
+ * @file mapped-tree.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief File-backed AVL tree type.
+ *
+ * The whole tree lives in a file mapped in memory: nodes are linked by their offsets in the file rather than by
+ * pointers, and are allocated from the file itself, so the file can be mapped at any address. Opening an existing file
+ * gives a usable tree right away, pages being read from the file as they are first accessed.
+ *
+ * Data are stored as raw bytes, so they must not hold pointers. The tree is not thread-safe, and a file must not be
+ * opened by more than one tree at a time.
+ */
+typedef struct _MappedTree* MappedTree;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Open the tree stored in a file, creating an empty one if the file does not exist or is empty.
+ *
+ * @param path Path of the file.
+ * @param size Size of the stored data in bytes, must be the one the file was created with.
+ * @param cmp Comparison function for the data, must order them as when the file was written.
+ * @return The opened tree, or NULL if the file could not be opened or mapped, or does not hold a tree of data of this
+ * size (errno is then set).
+ */
+extern MappedTree mapped_open(const char* path, size_t size, int (*cmp)(const void*, const void*));
+
+/**
+ * @brief Close a tree, unmapping its file. Changes not made durable by mapped_sync are written back by the system at
+ * some later point, unless it crashes first.
+ *
+ * @param tree The tree to be closed.
+ */
+extern void mapped_close(MappedTree tree);
+
+/**
+ * @brief Write every change made to the tree back to its file, and wait until it is on disk.
+ * A tree synced after its last change is found as it was when the file is opened again, even after a system crash.
+ *
+ * @param tree The tree.
+ * @return 0 on success, the error of msync otherwise.
+ */
+extern int mapped_sync(MappedTree tree);
+
+// --- Getters ---
+
+/**
+ * @brief Get the number of data in the tree, in constant time.
+ *
+ * @param tree The tree.
+ * @return The number of data.
+ */
+extern size_t mapped_get_size(MappedTree tree);
+
+/**
+ * @brief Get the size of the tree's file.
+ *
+ * @param tree The tree.
+ * @return The size of the file in bytes, freed nodes included since the file never shrinks.
+ */
+extern size_t mapped_get_file_size(MappedTree tree);
+
+/**
+ * @brief Check if the tree is a valid AVL tree (ordered, balanced, with correct heights and size).
+ *
+ * @param tree The tree to be checked.
+ * @return true if the tree is valid, false otherwise.
+ */
+extern bool mapped_is_valid(MappedTree tree);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the tree, nothing is done if it is already present.
+ * The file grows, doubling in size, when no freed node can be reused.
+ *
+ * @param tree The tree where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ * @return 0 on success, otherwise the error that prevented the file from growing or being mapped again, in which case
+ * the tree is left unchanged.
+ */
+extern int mapped_add(MappedTree tree, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove data from the tree, its node is reused by later insertions.
+ *
+ * @param tree The tree from which data will be removed.
+ * @param data Pointer to the data to be removed.
+ * @return true if the data was removed, false if it was not present.
+ */
+extern bool mapped_remove(MappedTree tree, const void* data);
+
+// --- Search ---
+
+/**
+ * @brief Find data in the tree.
+ *
+ * @param tree The tree to search.
+ * @param data Pointer to the data to search for.
+ * @return Pointer to the found data inside the mapping, valid until the next insertion, or NULL if not found.
+ */
+extern void* mapped_find_data(MappedTree tree, const void* data);
+
+/**
+ * @brief Call a function on every data of the tree between two bounds (both included), in order.
+ * The function must not change the tree.
+ *
+ * @param tree The tree.
+ * @param lo Lowest data visited, NULL for no lower bound.
+ * @param hi Highest data visited, NULL for no upper bound.
+ * @param func Function called on each data.
+ * @param arg Argument passed to the function along with the data.
+ * @return The number of data visited.
+ */
+extern size_t mapped_range(MappedTree tree, const void* lo, const void* hi, void (*func)(const void* data, void* arg),
+                           void* arg);
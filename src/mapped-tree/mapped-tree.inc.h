@@ -0,0 +1,45 @@
+/**
+ * @file mapped-tree.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mapped-tree.h"
+
+#define MAPPED_MAGIC "CDSAVLMT"
+#define MAPPED_VERSION 1
+#define MAPPED_INITIAL_SIZE 4096
+#define MAPPED_HEADER_SIZE 64  // nodes start after the header, so no node has offset 0
+
+// Stored at the start of the file
+struct mapped_header {
+  char magic[8];
+  uint64_t version;
+  uint64_t data_size;
+  uint64_t node_size;
+  uint64_t root;  // offset of the root node, 0 for an empty tree
+  uint64_t node_count;
+  uint64_t free_list;  // offset of the first freed node, each one holding the offset of the next in its left link
+  uint64_t used;       // end of the bytes handed out to nodes, the rest of the file is free
+};
+
+// Links are offsets from the start of the file, 0 for no node
+struct mapped_node {
+  uint64_t left;
+  uint64_t right;
+  int32_t height;
+  char data[1];
+};
+
+struct _MappedTree {
+  int fd;
+  char* base;  // start of the mapping, which moves when the file grows
+  size_t mapped_size;
+  int (*compare)(const void* a, const void* b);
+};
@@ -7,68 +7,459 @@
 
 #include "red-black-tree.h"
 
-#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../min-max.h"
+#include "../trace.h"
 #include "red-black-tree.inc.h"
 
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void)(addr))
+#endif
+
 static bool is_red(RBNode node) {
   if (node == NULL) return false;
   return node->isRed;
 }
 
+// --- Bloom Filter ---
+
+// Finalizer of splitmix64, so user hashes with poor low or high bits still spread over blocks, bits and entries
+static uint64_t rb_mix_hash(uint64_t hash) {
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31);
+}
+
+// The block is picked by the mixed hash, the bits inside it by double hashing on a second mix
+static bool rb_filter_probe(const struct rb_filter* filter, const void* key, bool set) {
+  uint64_t hash = rb_mix_hash(filter->hash(key));
+  uint64_t* block = filter->blocks + (hash >> 32) % filter->block_count * RB_FILTER_BLOCK_WORDS;
+  uint64_t bits = rb_mix_hash(hash);
+  uint32_t position = (uint32_t)bits;
+  uint32_t step = (uint32_t)(bits >> 32) | 1;
+  bool present = true;
+  for (int i = 0; i < filter->hash_count; i++, position += step) {
+    uint32_t bit = position >> 23;  // 9 bits, one of the 512 of the block
+    uint64_t mask = 1ULL << (bit % 64);
+    if (set) {
+      block[bit / 64] |= mask;
+    } else if (!(block[bit / 64] & mask)) {
+      present = false;
+      break;
+    }
+  }
+  return present;
+}
+
+static void rb_filter_add_subtree(struct rb_filter* filter, RBNode node) {
+  if (node == NULL) return;
+  rb_filter_probe(filter, node->data, true);
+  filter->count++;
+  rb_filter_add_subtree(filter, node->left);
+  rb_filter_add_subtree(filter, node->right);
+}
+
+// Replaces the filter by one sized for capacity elements holding every element of the tree, the filter is kept as is
+// if the new one cannot be allocated
+static int rb_filter_build(RBTree tree, size_t capacity, size_t (*hash)(const void*), size_t bits_per_element) {
+  const size_t block_bits = RB_FILTER_BLOCK_WORDS * 64;
+  const size_t block_bytes = RB_FILTER_BLOCK_WORDS * sizeof(uint64_t);
+  struct rb_filter filter = tree->filter;
+  filter.capacity = MAX(capacity, (size_t)RB_FILTER_MIN_CAPACITY);
+  filter.block_count = (filter.capacity * bits_per_element + block_bits - 1) / block_bits;
+  filter.allocation = tree->allocator.alloc(tree->allocator.ctx, filter.block_count * block_bytes + RB_CACHE_LINE);
+  if (!filter.allocation) return ENOMEM;
+  filter.blocks = (uint64_t*)(((uintptr_t)filter.allocation + RB_CACHE_LINE - 1) & ~(uintptr_t)(RB_CACHE_LINE - 1));
+  memset(filter.blocks, 0, filter.block_count * block_bytes);
+  filter.bits_per_element = bits_per_element;
+  filter.hash_count = (int)MIN(MAX((bits_per_element * 69 + 50) / 100, 1), RB_FILTER_MAX_HASHES);  // ln(2) per bit
+  filter.hash = hash;
+  filter.count = 0;
+  rb_filter_add_subtree(&filter, tree->root);
+
+  if (tree->filter.allocation) {
+    tree->allocator.free(tree->allocator.ctx, tree->filter.allocation);
+    filter.rebuilds++;
+  }
+  tree->filter = filter;
+  return 0;
+}
+
+// Called on every new node, before it is linked: a full filter is first rebuilt twice as large from the tree. If that
+// fails, the node is added to the full filter anyway, which only raises its false-positive rate.
+static void rb_filter_add(RBTree tree, RBNode node) {
+  struct rb_filter* filter = &tree->filter;
+  if (filter->blocks == NULL) return;
+  if (filter->count >= filter->capacity) {
+    rb_filter_build(tree, 2 * filter->capacity, filter->hash, filter->bits_per_element);
+  }
+  rb_filter_probe(filter, node->data, true);
+  filter->count++;
+}
+
+// Called after removals: bits cannot be cleared, so once removed elements outnumber the remaining ones the filter is
+// rebuilt from the tree, for twice its size like a fresh one
+static void rb_filter_shrink(RBTree tree) {
+  struct rb_filter* filter = &tree->filter;
+  if (filter->blocks == NULL) return;
+  size_t removed = filter->count - tree->node_count;
+  if (removed <= MAX(tree->node_count, (size_t)RB_FILTER_MIN_CAPACITY)) return;
+  rb_filter_build(tree, 2 * tree->node_count, filter->hash, filter->bits_per_element);
+}
+
+// false when key is certainly absent, the lookup is then counted as rejected
+static bool rb_filter_admits(RBTree tree, const void* key) {
+  struct rb_filter* filter = &tree->filter;
+  if (filter->blocks == NULL) return true;
+  filter->lookups++;
+  if (rb_filter_probe(filter, key, false)) return true;
+  filter->rejected++;
+  return false;
+}
+
+int rb_set_filter(RBTree tree, size_t (*hash)(const void* key), size_t bits_per_element) {
+  if (hash == NULL) {
+    if (tree->filter.allocation) tree->allocator.free(tree->allocator.ctx, tree->filter.allocation);
+    tree->filter = (struct rb_filter){0};
+    return 0;
+  }
+  if (bits_per_element == 0 || tree->small) return EINVAL;
+  return rb_filter_build(tree, 2 * tree->node_count, hash, bits_per_element);
+}
+
+void rb_get_filter_stats(RBTree tree, RBFilterStats* out) {
+  const struct rb_filter* filter = &tree->filter;
+  *out = (RBFilterStats){0};
+  if (filter->blocks == NULL) return;
+
+  size_t words = filter->block_count * RB_FILTER_BLOCK_WORDS;
+  size_t set_bits = 0;
+  for (size_t i = 0; i < words; i++) {
+    for (uint64_t word = filter->blocks[i]; word != 0; word &= word - 1) set_bits++;
+  }
+  out->bytes = words * sizeof(uint64_t) + RB_CACHE_LINE;
+  out->elements = filter->count;
+  out->lookups = filter->lookups;
+  out->rejected = filter->rejected;
+  out->false_positives = filter->false_positives;
+  out->rebuilds = filter->rebuilds;
+  out->expected_fpr = 1;  // a lookup passes when all its bits are set
+  for (int i = 0; i < filter->hash_count; i++) {
+    out->expected_fpr *= (double)set_bits / (double)(words * 64);
+  }
+  if (filter->rejected + filter->false_positives > 0) {
+    out->measured_fpr = (double)filter->false_positives / (double)(filter->rejected + filter->false_positives);
+  }
+}
+
+// --- Lookup Cache ---
+
+static struct rb_lookup_entry* rb_cache_entry(RBTree tree, uint64_t tag) {
+  return &tree->cache.entries[tag & tree->cache.mask];
+}
+
+// Cached node holding key, counted as a hit, or NULL
+static RBNode rb_cache_find(RBTree tree, const void* key, uint64_t tag) {
+  tree->cache.lookups++;
+  struct rb_lookup_entry* entry = rb_cache_entry(tree, tag);
+  if (entry->node == NULL || entry->tag != tag || tree->compare(key, entry->node->data) != 0) return NULL;
+  tree->cache.hits++;
+  return entry->node;
+}
+
+// Called before a node is freed, while its data can still be hashed
+static void rb_cache_forget(RBTree tree, RBNode node) {
+  if (tree->cache.entries == NULL) return;
+  struct rb_lookup_entry* entry = rb_cache_entry(tree, rb_mix_hash(tree->cache.hash(node->data)));
+  if (entry->node != node) return;
+  entry->node = NULL;
+  tree->cache.invalidations++;
+}
+
+// Called when compaction copied node to moved
+static void rb_cache_move(RBTree tree, RBNode node, RBNode moved) {
+  if (tree->cache.entries == NULL) return;
+  struct rb_lookup_entry* entry = rb_cache_entry(tree, rb_mix_hash(tree->cache.hash(moved->data)));
+  if (entry->node == node) entry->node = moved;
+}
+
+int rb_set_cache(RBTree tree, size_t (*hash)(const void* key), size_t entries) {
+  if (hash != NULL && (entries == 0 || tree->small)) return EINVAL;
+
+  struct rb_lookup_cache cache = {0};
+  if (hash != NULL) {
+    size_t count = RB_LOOKUP_CACHE_LINE_ENTRIES;
+    while (count < entries) count *= 2;
+    size_t bytes = count * sizeof(struct rb_lookup_entry);
+    cache.allocation = tree->allocator.alloc(tree->allocator.ctx, bytes + RB_CACHE_LINE);
+    if (!cache.allocation) return ENOMEM;
+    uintptr_t aligned = ((uintptr_t)cache.allocation + RB_CACHE_LINE - 1) & ~(uintptr_t)(RB_CACHE_LINE - 1);
+    cache.entries = (struct rb_lookup_entry*)aligned;
+    memset(cache.entries, 0, bytes);
+    cache.mask = count - 1;
+    cache.hash = hash;
+  }
+
+  if (tree->cache.allocation) tree->allocator.free(tree->allocator.ctx, tree->cache.allocation);
+  tree->cache = cache;
+  return 0;
+}
+
+void rb_get_cache_stats(RBTree tree, RBCacheStats* out) {
+  const struct rb_lookup_cache* cache = &tree->cache;
+  *out = (RBCacheStats){0};
+  if (cache->entries == NULL) return;
+
+  out->entries = cache->mask + 1;
+  out->bytes = out->entries * sizeof(struct rb_lookup_entry) + RB_CACHE_LINE;
+  out->lookups = cache->lookups;
+  out->hits = cache->hits;
+  out->invalidations = cache->invalidations;
+  if (cache->lookups > 0) out->hit_rate = (double)cache->hits / (double)cache->lookups;
+}
+
 // --- Constructor and Destructor ---
 
-static RBNode rb_node_new(const void* data, size_t size, bool isRed) {
-  RBNode node = malloc(2 * sizeof(RBNode) + sizeof(bool) + size);
-  if (!node) {
-    perror("Out of memory");
-    exit(EXIT_FAILURE);
+static void* rb_node_aggregate(RBTree tree, RBNode node) { return (char*)node + tree->augment_offset; }
+
+// Aggregate of a possibly empty subtree
+static const void* rb_subtree_aggregate(RBTree tree, RBNode node) {
+  return node ? rb_node_aggregate(tree, node) : tree->augment.identity;
+}
+
+// Recomputes the aggregate of a node from its children, which must already be up to date
+static void rb_node_update(RBTree tree, RBNode node) {
+  if (tree->augment.compute) {
+    tree->augment.compute(rb_node_aggregate(tree, node), node->data, rb_subtree_aggregate(tree, node->left),
+                          rb_subtree_aggregate(tree, node->right));
   }
+}
+
+static void* default_alloc(void* ctx, size_t size) { return malloc(size); }
+
+static void default_free(void* ctx, void* ptr) { free(ptr); }
+
+// Map nodes start on a cache line, so the links and the key that follows them are read together
+static void* cache_aligned_alloc(void* ctx, size_t size) {
+  return aligned_alloc(RB_CACHE_LINE, (size + RB_CACHE_LINE - 1) / RB_CACHE_LINE * RB_CACHE_LINE);
+}
+
+// Variable-length nodes are preceded by a header holding the record prefix and, right before the node, its length
+static size_t* rb_node_length(RBNode node) { return (size_t*)node - 1; }
+
+static unsigned char* rb_node_prefix(RBTree tree, RBNode node) { return (unsigned char*)node - tree->header_size; }
+
+// First prefix_size bytes of a record, zero padded when the record is shorter
+static void rb_record_prefix(RBTree tree, const void* data, size_t length, unsigned char* prefix) {
+  size_t copied = MIN(length, tree->prefix_size);
+  memcpy(prefix, data, copied);
+  memset(prefix + copied, 0, tree->prefix_size - copied);
+}
+
+// Prefix of a searched record, computed once per operation
+static const unsigned char* rb_key_prefix(RBTree tree, const void* data, unsigned char* prefix) {
+  if (tree->prefix_size == 0) return NULL;
+  rb_record_prefix(tree, data, tree->record_size(data), prefix);
+  return prefix;
+}
+
+// Differing prefixes settle the order without reading the record, only equal ones call the comparison function
+static int rb_compare_node(RBTree tree, const void* data, const unsigned char* prefix, RBNode node) {
+  if (prefix != NULL) {
+    int cmp = memcmp(prefix, rb_node_prefix(tree, node), tree->prefix_size);
+    if (cmp != 0) return cmp;
+  }
+  return tree->compare(data, node->data);
+}
+
+// Size of the allocation holding a node, its header included
+static size_t rb_node_block_size(RBTree tree, RBNode node) {
+  if (tree->record_size == NULL) return tree->node_size;
+  return tree->header_size + offsetof(struct _TreeNode, data) + *rb_node_length(node);
+}
+
+// Bytes a node of the given block size takes in a compacted region
+static size_t rb_node_stride(RBTree tree, size_t block_size) {
+  return (block_size + tree->node_align - 1) / tree->node_align * tree->node_align;
+}
+
+static bool rb_in_region(const char* region, size_t region_size, const void* ptr) {
+  return region != NULL && (uintptr_t)ptr >= (uintptr_t)region && (uintptr_t)ptr < (uintptr_t)region + region_size;
+}
+
+// Nodes inside a compacted region are only freed with the whole region
+static void rb_free_block(RBTree tree, RBNode node) {
+  char* block = (char*)node - tree->header_size;
+  if (rb_in_region(tree->region, tree->region_size, block)) return;
+  if (rb_in_region(tree->next_region, tree->next_region_size, block)) return;
+  tree->allocator.free(tree->allocator.ctx, block);
+}
+
+// value is NULL when data already holds the whole record, otherwise data is only the key
+static RBNode rb_node_new(RBTree tree, const void* data, const void* value, bool isRed) {
+  size_t length = tree->record_size ? tree->record_size(data) : tree->data_size;
+  size_t size = tree->record_size ? tree->header_size + offsetof(struct _TreeNode, data) + length : tree->node_size;
+  char* block = tree->allocator.alloc(tree->allocator.ctx, size);
+  if (!block) {
+    return NULL;
+  }
+  tree->node_count++;
+  tree->node_bytes += rb_node_stride(tree, size);
+  RBNode node = (RBNode)(block + tree->header_size);
   node->left = NULL;
   node->right = NULL;
   node->isRed = isRed;
-  memcpy(node->data, data, size);
+  if (tree->record_size) {
+    *rb_node_length(node) = length;
+    rb_record_prefix(tree, data, length, rb_node_prefix(tree, node));
+  }
+  if (value == NULL) {
+    memcpy(node->data, data, length);
+  } else {
+    memcpy(node->data, data, tree->key_size);
+    memcpy(node->data + tree->key_size, value, tree->data_size - tree->key_size);
+  }
+  rb_node_update(tree, node);
+  rb_filter_add(tree, node);
   return node;
 }
 
 RBTree rb_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
-  RBTree tree =
-      malloc(sizeof(void*) + sizeof(size_t) + sizeof(int (*)(const void*, const void*)) + sizeof(void (*)(void*)));
+  return rb_new_with_allocator(size, cmp, del, NULL, NULL);
+}
+
+RBTree rb_new_augmented(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*),
+                        const RBAugment* augment) {
+  return rb_new_with_allocator(size, cmp, del, augment, NULL);
+}
+
+RBTree rb_new_map(size_t key_size, size_t value_size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  return rb_new_map_with_allocator(key_size, value_size, cmp, del, NULL);
+}
+
+RBTree rb_new_map_with_allocator(size_t key_size, size_t value_size, int (*cmp)(const void*, const void*),
+                                 void (*del)(void*), const RBAllocator* allocator) {
+  RBAllocator aligned = {cache_aligned_alloc, default_free, NULL};
+  RBTree tree = rb_new_with_allocator(key_size + value_size, cmp, del, NULL, allocator ? allocator : &aligned);
+  if (tree) {
+    tree->key_size = key_size;
+    tree->node_align = RB_CACHE_LINE;
+  }
+  return tree;
+}
+
+RBTree rb_new_variable(size_t prefix_size, size_t (*record_size)(const void*), int (*cmp)(const void*, const void*),
+                       void (*del)(void*)) {
+  if (prefix_size > RB_MAX_PREFIX) return NULL;
+  RBTree tree = rb_new_with_allocator(0, cmp, del, NULL, NULL);
+  if (tree) {
+    const size_t align = _Alignof(struct _TreeNode);
+    tree->record_size = record_size;
+    tree->prefix_size = prefix_size;
+    tree->header_size = (prefix_size + sizeof(size_t) + align - 1) / align * align;
+  }
+  return tree;
+}
+
+RBTree rb_new_with_allocator(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*),
+                             const RBAugment* augment, const RBAllocator* allocator) {
+  RBAllocator alloc = allocator ? *allocator : (RBAllocator){default_alloc, default_free, NULL};
+  RBTree tree = alloc.alloc(alloc.ctx, sizeof(struct _RBTree));
   if (!tree) {
-    perror("Out of memory");
-    exit(EXIT_FAILURE);
+    return NULL;
   }
 
+  tree->allocator = alloc;
   tree->data_size = size;
+  tree->key_size = size;
   tree->compare = cmp;
   tree->delete_data = del;
   tree->root = NULL;
+  tree->min = NULL;
+  tree->max = NULL;
+  tree->node_size = offsetof(struct _TreeNode, data) + size;
+  tree->augment_offset = 0;
+  tree->augment = (RBAugment){0};
+  tree->augment_scratch = NULL;
+  tree->classic = false;
+  tree->record_size = NULL;
+  tree->prefix_size = 0;
+  tree->header_size = 0;
+  tree->node_align = _Alignof(struct _TreeNode);
+  tree->node_count = 0;
+  tree->node_bytes = 0;
+  tree->rotations = 0;
+  tree->filter = (struct rb_filter){0};
+  tree->cache = (struct rb_lookup_cache){0};
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  tree->region = NULL;
+  tree->region_size = 0;
+  tree->next_region = NULL;
+  tree->next_region_size = 0;
+  tree->next_region_used = 0;
+  tree->cursor = NULL;
+
+  if (augment != NULL) {
+    const size_t align = _Alignof(max_align_t);
+    // the identity is followed by the scratch aggregates of range queries, so they never allocate
+    const size_t stride = (augment->size + align - 1) / align * align;
+    char* identity = alloc.alloc(alloc.ctx, 4 * stride);
+    if (!identity) {
+      alloc.free(alloc.ctx, tree);
+      return NULL;
+    }
+    memcpy(identity, augment->identity, augment->size);
+
+    tree->augment = *augment;
+    tree->augment.identity = identity;
+    tree->augment_scratch = identity + stride;
+    tree->augment_offset = (tree->node_size + align - 1) / align * align;
+    tree->node_size = tree->augment_offset + augment->size;
+    tree->node_align = align;
+  }
 
   return tree;
 }
 
-static void delete_node(RBNode node, void del(void*), bool del_data) {
+// An adaptive tree keeps its records in its array until there are more than small_capacity of them
+static bool rb_is_small(RBTree tree) { return tree->small != NULL && tree->root == NULL; }
+
+static char* rb_small_record(RBTree tree, size_t i) { return tree->small + i * tree->data_size; }
+
+static void delete_node(RBTree tree, RBNode node, bool del_data) {
   if (!node) {
     return;
   }
 
-  if (del && del_data) {
-    del(node->data);
+  tree->node_count--;
+  tree->node_bytes -= rb_node_stride(tree, rb_node_block_size(tree, node));
+  if (node == tree->cursor) tree->cursor = NULL;  // the next compaction step starts over from the first node
+  rb_cache_forget(tree, node);
+  if (tree->delete_data && del_data) {
+    tree->delete_data(node->data);
   }
-  free(node);
+  rb_free_block(tree, node);
 }
 
-static void delete_all_nodes(RBNode node, void del(void*)) {
+// Returns the number of nodes freed
+static size_t delete_all_nodes(RBTree tree, RBNode node) {
   if (node == NULL) {
-    return;
+    return 0;
   }
 
-  delete_all_nodes(node->left, del);
-  delete_all_nodes(node->right, del);
-  delete_node(node, del, true);
+  size_t count = delete_all_nodes(tree, node->left) + delete_all_nodes(tree, node->right);
+  delete_node(tree, node, true);
+  return count + 1;
 }
 
 void rb_delete(RBTree tree) {
@@ -76,16 +467,80 @@ void rb_delete(RBTree tree) {
     return;
   }
 
-  delete_all_nodes(tree->root, tree->delete_data);
-  free(tree);
+  for (size_t i = 0; rb_is_small(tree) && tree->delete_data && i < tree->node_count; i++) {
+    tree->delete_data(rb_small_record(tree, i));
+  }
+  delete_all_nodes(tree, tree->root);
+  if (tree->region) tree->allocator.free(tree->allocator.ctx, tree->region);
+  if (tree->next_region) tree->allocator.free(tree->allocator.ctx, tree->next_region);
+  if (tree->augment.identity) tree->allocator.free(tree->allocator.ctx, (void*)tree->augment.identity);
+  if (tree->filter.allocation) tree->allocator.free(tree->allocator.ctx, tree->filter.allocation);
+  if (tree->cache.allocation) tree->allocator.free(tree->allocator.ctx, tree->cache.allocation);
+  if (tree->small) tree->allocator.free(tree->allocator.ctx, tree->small);
+  tree->allocator.free(tree->allocator.ctx, tree);
 }
 
+static void* rb_delete_thread(void* tree) {
+  rb_delete(tree);
+  return NULL;
+}
+
+int rb_delete_async(RBTree tree) {
+  if (!tree) return 0;
+
+  pthread_attr_t attr;
+  int error = pthread_attr_init(&attr);
+  if (!error) {
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    error = pthread_create(&thread, &attr, rb_delete_thread, tree);
+    pthread_attr_destroy(&attr);
+  }
+  if (error) rb_delete(tree);
+  return error;
+}
+
+bool rb_delete_step(RBTree tree, size_t max_nodes) {
+  if (rb_is_small(tree)) {  // the records of a small tree are deleted at once, there are few of them
+    rb_delete(tree);
+    return true;
+  }
+  if (tree->cache.allocation) {  // nothing is looked up anymore, nodes need not be dropped from it one by one
+    tree->allocator.free(tree->allocator.ctx, tree->cache.allocation);
+    tree->cache = (struct rb_lookup_cache){0};
+  }
+
+  // root holds what remains of the tree, whose leftmost node is freed once it has no left child
+  for (size_t i = 0; i < max_nodes && tree->root != NULL; i++) {
+    RBNode node = tree->root;
+    if (node->left != NULL) {
+      RBNode left = node->left;
+      node->left = left->right;
+      left->right = node;
+      tree->root = left;
+    } else {
+      tree->root = node->right;
+      delete_node(tree, node, true);
+    }
+  }
+  if (tree->root != NULL) return false;
+
+  tree->min = NULL;
+  tree->max = NULL;
+  rb_delete(tree);
+  return true;
+}
+
+// Defined with the small mode, getters returning nodes first move the records of small trees into nodes
+static bool rb_small_pin(RBTree tree);
+
 // --- Getters ---
 
 RBNode rb_get_root(RBTree tree) {
   if (tree == NULL) {
     return NULL;
   }
+  if (!rb_small_pin(tree)) return NULL;
   return tree->root;
 }
 
@@ -93,6 +548,13 @@ int rb_get_height(RBTree tree) {
   if (tree == NULL) {
     return 0;
   }
+  if (rb_is_small(tree)) {  // height of a balanced tree of the records
+    int height = 0;
+    for (size_t count = tree->node_count; count > 0; count /= 2) {
+      height++;
+    }
+    return height;
+  }
   return rb_node_get_height(tree->root);
 }
 
@@ -104,16 +566,15 @@ int rb_node_get_height(RBNode node) {
   }
 }
 
-static int rb_node_get_size(RBNode node) {
-  if (node == NULL) {
+int rb_get_size(RBTree tree) { return (int)tree->node_count; }
+
+size_t rb_get_rotations(RBTree tree) {
+  if (tree == NULL) {
     return 0;
-  } else {
-    return 1 + rb_node_get_size(node->left) + rb_node_get_size(node->right);
   }
+  return tree->rotations;
 }
 
-int rb_get_size(RBTree tree) { return rb_node_get_size(tree->root); }
-
 RBNode rb_node_get_left(RBNode node) {
   if (node == NULL) {
     return NULL;
@@ -128,6 +589,22 @@ RBNode rb_node_get_right(RBNode node) {
   return node->right;
 }
 
+RBNode rb_first(RBTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  if (!rb_small_pin(tree)) return NULL;
+  return tree->min;
+}
+
+RBNode rb_last(RBTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  if (!rb_small_pin(tree)) return NULL;
+  return tree->max;
+}
+
 void* rb_node_get_data(RBNode node) {
   if (node == NULL) {
     return NULL;
@@ -135,6 +612,20 @@ void* rb_node_get_data(RBNode node) {
   return node->data;
 }
 
+void* rb_node_get_value(RBTree tree, RBNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->data + tree->key_size;
+}
+
+size_t rb_node_get_data_size(RBTree tree, RBNode node) {
+  if (node == NULL) {
+    return 0;
+  }
+  return tree->record_size ? *rb_node_length(node) : tree->data_size;
+}
+
 bool rb_node_is_red(RBNode node) { return is_red(node); }
 
 static int rb_node_is_valid(RBNode node, int black_nodes) {
@@ -155,6 +646,12 @@ static int rb_node_is_valid(RBNode node, int black_nodes) {
 }
 
 bool rb_is_valid(RBTree tree) {
+  if (rb_is_small(tree)) {
+    for (size_t i = 1; i < tree->node_count; i++) {
+      if (tree->compare(rb_small_record(tree, i - 1), rb_small_record(tree, i)) >= 0) return false;
+    }
+    return tree->node_count <= tree->small_capacity;
+  }
   if (tree->root == NULL) return true;
   if (tree->root->isRed) return false;
   return rb_node_is_valid(tree->root, 0) != -1;
@@ -168,7 +665,7 @@ static void flip_colors(RBNode node) {
   if (node->right != NULL) node->right->isRed = !node->right->isRed;
 }
 
-static RBNode rotate_left(RBNode node) {
+static RBNode rotate_left(RBTree tree, RBNode node) {
   if (node == NULL || node->right == NULL) {
     return node;
   }
@@ -179,10 +676,14 @@ static RBNode rotate_left(RBNode node) {
   r_node->isRed = node->isRed;
   node->isRed = true;
 
+  rb_node_update(tree, node);
+  rb_node_update(tree, r_node);
+  tree->rotations++;
+
   return r_node;
 }
 
-static RBNode rotate_right(RBNode node) {
+static RBNode rotate_right(RBTree tree, RBNode node) {
   if (node == NULL || node->left == NULL) {
     return node;
   }
@@ -193,33 +694,39 @@ static RBNode rotate_right(RBNode node) {
   l_node->isRed = node->isRed;
   node->isRed = true;
 
+  rb_node_update(tree, node);
+  rb_node_update(tree, l_node);
+  tree->rotations++;
+
   return l_node;
 }
 
-static RBNode rb_fixup(RBNode* node) {
-  if (is_red((*node)->right) && !is_red((*node)->left)) *node = rotate_left(*node);
-  if (is_red((*node)->left) && is_red((*node)->left->left)) *node = rotate_right(*node);
+// Also refreshes the aggregate of the node, called on the way back up of every structural change
+static RBNode rb_fixup(RBTree tree, RBNode* node) {
+  rb_node_update(tree, *node);
+  if (is_red((*node)->right) && !is_red((*node)->left)) *node = rotate_left(tree, *node);
+  if (is_red((*node)->left) && is_red((*node)->left->left)) *node = rotate_right(tree, *node);
   if (is_red((*node)->left) && is_red((*node)->right)) flip_colors(*node);
 
   return *node;
 }
 
 // rb_node_remove LLRB tree operation for easier deletion (fewer "cases" to handle)
-static RBNode rb_move_red_right(RBNode* node) {
+static RBNode rb_move_red_right(RBTree tree, RBNode* node) {
   flip_colors(*node);
   if ((*node)->left != NULL && is_red((*node)->left->left)) {
-    *node = rotate_right(*node);
+    *node = rotate_right(tree, *node);
     flip_colors(*node);
   }
   return *node;
 }
 
 // rb_node_remove LLRB tree operation for easier deletion (fewer "cases" to handle)
-static RBNode rb_move_red_left(RBNode* node) {
+static RBNode rb_move_red_left(RBTree tree, RBNode* node) {
   flip_colors(*node);
   if ((*node)->right != NULL && is_red((*node)->right->left)) {
-    (*node)->right = rotate_right((*node)->right);
-    *node = rotate_left(*node);
+    (*node)->right = rotate_right(tree, (*node)->right);
+    *node = rotate_left(tree, *node);
     flip_colors(*node);
   }
   return *node;
@@ -231,33 +738,476 @@ static RBNode rb_move_red_left(RBNode* node) {
 // This simplifies a lot of code by removing many of the "cases" that have to be managed during deletion
 // see: https://sedgewick.io/wp-content/themes/sedgewick/papers/2008LLRB.pdf
 // also: https://algs4.cs.princeton.edu/33balanced/RedBlackBST.java.html
-static RBNode rb_node_add(RBNode* node, const void* data, size_t size, int (*compare)(const void*, const void*)) {
+// leftmost/rightmost track whether the descent only went left/right, in which case the new node is the new min/max
+// If the new node cannot be allocated, error is set and the empty link is kept, rb_fixup is then a no-op on the way up
+// With a value, data is a key alone and the value of an existing node is overwritten (rb_map_put)
+static RBNode rb_node_add(RBTree tree, RBNode* node, const void* data, const void* value,
+                          const unsigned char* prefix, bool leftmost, bool rightmost, int* error) {
   if (*node == NULL) {
-    return rb_node_new(data, size, true);
+    RBNode new_node = rb_node_new(tree, data, value, true);
+    if (new_node == NULL) {
+      *error = ENOMEM;
+      return NULL;
+    }
+    if (leftmost) tree->min = new_node;
+    if (rightmost) tree->max = new_node;
+    return new_node;
   }
 
-  int cmp = compare(data, (*node)->data);
+  int cmp = rb_compare_node(tree, data, prefix, *node);
   if (cmp < 0)
-    (*node)->left = rb_node_add(&(*node)->left, data, size, compare);
+    (*node)->left = rb_node_add(tree, &(*node)->left, data, value, prefix, leftmost, false, error);
   else if (cmp > 0)
-    (*node)->right = rb_node_add(&(*node)->right, data, size, compare);
+    (*node)->right = rb_node_add(tree, &(*node)->right, data, value, prefix, false, rightmost, error);
+  else if (value != NULL)
+    memcpy((*node)->data + tree->key_size, value, tree->data_size - tree->key_size);
+
+  return rb_fixup(tree, node);
+}
+
+// --- Classic Mode Insertion ---
+
+// Classic red-black trees allow red right links, so updates are iterative and bottom-up: the descent records the
+// address of every link it follows, and fixing up climbs back along them only while a violation remains. Insertions
+// do at most 2 rotations, removals at most 3, and recolorings are O(1) amortized.
+// see: Cormen et al., "Introduction to Algorithms" (3rd ed.), chapter 13
+//
+// The rotations of the left-leaning code give the new top the color of the old one and make the old one red, which is
+// exactly the recoloring of the classic cases, so they are shared. Aggregates of augmented trees are refreshed along
+// the whole path before fixing up, rotations then keep them up to date.
+static void rb_classic_refresh(RBTree tree, RBNode** links, int depth) {
+  if (!tree->augment.compute) return;
+  for (int i = depth; i >= 0; i--) {
+    if (*links[i] != NULL) rb_node_update(tree, *links[i]);
+  }
+}
+
+static void rb_classic_insert_fixup(RBTree tree, RBNode** links, int depth) {
+  int i = depth;
+  while (i >= 2 && (*links[i - 1])->isRed) {  // a red parent is never the root
+    RBNode node = *links[i];
+    RBNode parent = *links[i - 1];
+    RBNode grandparent = *links[i - 2];
+    bool parent_left = parent == grandparent->left;
+    RBNode uncle = parent_left ? grandparent->right : grandparent->left;
+
+    if (is_red(uncle)) {
+      parent->isRed = false;
+      uncle->isRed = false;
+      grandparent->isRed = true;
+      i -= 2;
+      continue;
+    }
+
+    if (parent_left) {
+      if (node == parent->right) grandparent->left = rotate_left(tree, parent);
+      *links[i - 2] = rotate_right(tree, grandparent);
+    } else {
+      if (node == parent->left) grandparent->right = rotate_right(tree, parent);
+      *links[i - 2] = rotate_left(tree, grandparent);
+    }
+    break;
+  }
+  tree->root->isRed = false;
+}
+
+// Descends from *links[depth], which may already be empty, then links a red node where data belongs
+static int rb_classic_add(RBTree tree, RBNode** links, int depth, const void* data, const void* value,
+                          const unsigned char* prefix, bool leftmost, bool rightmost) {
+  while (*links[depth] != NULL) {
+    RBNode node = *links[depth];
+    int cmp = rb_compare_node(tree, data, prefix, node);
+    if (cmp == 0) {
+      if (value == NULL) return 0;  // data already in tree
+      memcpy(node->data + tree->key_size, value, tree->data_size - tree->key_size);
+      rb_classic_refresh(tree, links, depth);
+      return 0;
+    }
+    if (cmp < 0) {
+      links[depth + 1] = &node->left;
+      rightmost = false;
+    } else {
+      links[depth + 1] = &node->right;
+      leftmost = false;
+    }
+    depth++;
+  }
+
+  RBNode new_node = rb_node_new(tree, data, value, true);
+  if (new_node == NULL) return ENOMEM;
+  *links[depth] = new_node;
+  if (leftmost) tree->min = new_node;
+  if (rightmost) tree->max = new_node;
+
+  rb_classic_refresh(tree, links, depth - 1);
+  rb_classic_insert_fixup(tree, links, depth);
+  return 0;
+}
+
+int rb_set_classic(RBTree tree, bool classic) {
+  if (tree->node_count != 0) return EINVAL;
+  tree->classic = classic;
+  return 0;
+}
+
+static int rb_root_add(RBTree tree, const void* data, const void* value) {
+  if (tree->classic) {
+    RBNode* links[RB_MAX_HEIGHT + 2];
+    unsigned char buffer[RB_MAX_PREFIX];
+    links[0] = &tree->root;
+    return rb_classic_add(tree, links, 0, data, value, rb_key_prefix(tree, data, buffer), true, true);
+  }
+
+  int error = 0;
+  unsigned char prefix[RB_MAX_PREFIX];
+  tree->root = rb_node_add(tree, &tree->root, data, value, rb_key_prefix(tree, data, prefix), true, true, &error);
+  if (tree->root != NULL) tree->root->isRed = false;
+  return error;
+}
+
+// --- Tracing ---
+
+// USDT probes of provider rb, each operation firing <op>_entry then <op>_return:
+// - add, map_put, add_edge, remove, find (find_data) and map_get: entry(key, key size),
+//   return(result, key size, depth, rotations)
+// - pop_min and pop_max: entry(out, record size), return(popped, record size, depth, rotations)
+// - remove_range: entry(lo, hi, key size of lo), return(removed count, key size, depth of lo, rotations)
+// - find_batch: entry(keys, count), return(found count, key size, 0, rotations)
+// The depth counts the nodes from the root down to the key, or to where it belongs, and the rotations are the ones done
+// by the call. Record and key sizes are 0 for batches of variable-length records.
+TRACE_SEMAPHORE(rb, add_entry);
+TRACE_SEMAPHORE(rb, add_return);
+TRACE_SEMAPHORE(rb, map_put_entry);
+TRACE_SEMAPHORE(rb, map_put_return);
+TRACE_SEMAPHORE(rb, add_edge_entry);
+TRACE_SEMAPHORE(rb, add_edge_return);
+TRACE_SEMAPHORE(rb, remove_entry);
+TRACE_SEMAPHORE(rb, remove_return);
+TRACE_SEMAPHORE(rb, find_entry);
+TRACE_SEMAPHORE(rb, find_return);
+TRACE_SEMAPHORE(rb, map_get_entry);
+TRACE_SEMAPHORE(rb, map_get_return);
+TRACE_SEMAPHORE(rb, pop_min_entry);
+TRACE_SEMAPHORE(rb, pop_min_return);
+TRACE_SEMAPHORE(rb, pop_max_entry);
+TRACE_SEMAPHORE(rb, pop_max_return);
+TRACE_SEMAPHORE(rb, remove_range_entry);
+TRACE_SEMAPHORE(rb, remove_range_return);
+TRACE_SEMAPHORE(rb, find_batch_entry);
+TRACE_SEMAPHORE(rb, find_batch_return);
+
+// Probe arguments taken on entry, all zero unless a tracer is attached
+struct rb_trace {
+  size_t key_size;
+  int depth;  // nodes compared on the way down to the key, or to where it belongs, 0 while the tree is small
+  size_t rotations;
+};
+
+// The depth is measured by a descent of its own, so untraced calls do not pay for it. data is NULL when there is no
+// single key, as in batches.
+static struct rb_trace rb_trace_begin(RBTree tree, const void* data, bool active) {
+  struct rb_trace trace = {0};
+  if (!active) return trace;
+
+  trace.rotations = tree->rotations;
+  if (data == NULL) {
+    trace.key_size = tree->record_size ? 0 : tree->key_size;
+    return trace;
+  }
+  trace.key_size = tree->record_size ? tree->record_size(data) : tree->key_size;
+  unsigned char buffer[RB_MAX_PREFIX];
+  const unsigned char* prefix = rb_key_prefix(tree, data, buffer);
+  for (RBNode node = tree->root; node != NULL;) {
+    int cmp = rb_compare_node(tree, data, prefix, node);
+    trace.depth++;
+    if (cmp == 0) break;
+    node = cmp < 0 ? node->left : node->right;
+  }
+  return trace;
+}
+
+// Pops follow the spine down to the smallest or largest record, their size is that of the popped record
+static struct rb_trace rb_trace_edge(RBTree tree, bool largest, bool active) {
+  struct rb_trace trace = rb_trace_begin(tree, NULL, active);
+  if (!active || tree->root == NULL) return trace;
+
+  RBNode node = tree->root;
+  for (trace.depth = 1; (largest ? node->right : node->left) != NULL; trace.depth++) {
+    node = largest ? node->right : node->left;
+  }
+  trace.key_size = rb_node_get_data_size(tree, node);
+  return trace;
+}
+
+// --- Small Mode ---
+
+// Small trees keep their records sorted in one array, searched by bisection. The comparison function is opaque, so
+// comparisons cannot be vectorized, the savings are the node allocations and the pointer chasing.
+
+// Frees the nodes of a subtree without deleting their data, which lives on elsewhere
+static void rb_free_nodes(RBTree tree, RBNode node) {
+  if (node == NULL) return;
+  rb_free_nodes(tree, node->left);
+  rb_free_nodes(tree, node->right);
+  delete_node(tree, node, false);
+}
+
+// Index of the first record not below data, found tells whether it compares equal
+static size_t rb_small_search(RBTree tree, const void* data, bool* found) {
+  size_t lo = 0;
+  size_t hi = tree->node_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (tree->compare(rb_small_record(tree, mid), data) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  *found = lo < tree->node_count && tree->compare(data, rb_small_record(tree, lo)) == 0;
+  return lo;
+}
+
+static void* rb_small_find(RBTree tree, const void* data) {
+  bool found;
+  size_t i = rb_small_search(tree, data, &found);
+  return found ? rb_small_record(tree, i) : NULL;
+}
+
+// Moves the records into nodes, added in order through the regular insertion. On failure the nodes made so far are
+// freed and the records stay in the array.
+static int rb_small_promote(RBTree tree) {
+  size_t count = tree->node_count;
+  tree->node_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    int error = rb_root_add(tree, rb_small_record(tree, i), NULL);
+    if (error) {
+      rb_free_nodes(tree, tree->root);
+      tree->root = NULL;
+      tree->min = NULL;
+      tree->max = NULL;
+      tree->node_count = count;
+      return error;
+    }
+  }
+  return 0;
+}
+
+// Nodes handed out must stay valid, so a tree handing one out keeps its nodes for good and is no longer adaptive.
+// Returns false, errno set to ENOMEM, when the records could not be moved into nodes.
+static bool rb_small_pin(RBTree tree) {
+  if (tree->small == NULL) return true;
+  if (rb_is_small(tree)) {
+    int error = rb_small_promote(tree);
+    if (error) {
+      errno = error;
+      return false;
+    }
+  }
+  tree->allocator.free(tree->allocator.ctx, tree->small);
+  tree->small = NULL;
+  tree->small_capacity = 0;
+  return true;
+}
+
+// Copies the records of a subtree in order into the array from index *count, freeing their nodes
+static void rb_small_gather(RBTree tree, RBNode node, size_t* count) {
+  if (node == NULL) return;
+  rb_small_gather(tree, node->left, count);
+  RBNode right = node->right;
+  memcpy(rb_small_record(tree, (*count)++), node->data, tree->data_size);
+  delete_node(tree, node, false);
+  rb_small_gather(tree, right, count);
+}
+
+// Called after removals, records go back to the array once they fill half of it, so a tree hovering around the
+// threshold does not switch at every operation
+static void rb_small_shrink(RBTree tree) {
+  if (tree->small == NULL || tree->root == NULL || tree->node_count > tree->small_capacity / 2) return;
+  size_t count = 0;
+  rb_small_gather(tree, tree->root, &count);
+  tree->root = NULL;
+  tree->min = NULL;
+  tree->max = NULL;
+  tree->node_count = count;
+}
+
+// value is NULL when data already holds the whole record, as in rb_root_add
+static int rb_small_add(RBTree tree, const void* data, const void* value) {
+  bool found;
+  size_t i = rb_small_search(tree, data, &found);
+  if (found) {
+    if (value != NULL) memcpy(rb_small_record(tree, i) + tree->key_size, value, tree->data_size - tree->key_size);
+    return 0;
+  }
+  if (tree->node_count == tree->small_capacity) {  // full, the tree switches to nodes
+    int error = rb_small_promote(tree);
+    return error ? error : rb_root_add(tree, data, value);
+  }
+
+  char* record = rb_small_record(tree, i);
+  memmove(record + tree->data_size, record, (tree->node_count - i) * tree->data_size);
+  memcpy(record, data, value ? tree->key_size : tree->data_size);
+  if (value != NULL) memcpy(record + tree->key_size, value, tree->data_size - tree->key_size);
+  tree->node_count++;
+  return 0;
+}
+
+// Removes the records from first to last (excluded)
+static void rb_small_erase(RBTree tree, size_t first, size_t last, bool del_data) {
+  for (size_t i = first; i < last && del_data && tree->delete_data; i++) {
+    tree->delete_data(rb_small_record(tree, i));
+  }
+  memmove(rb_small_record(tree, first), rb_small_record(tree, last), (tree->node_count - last) * tree->data_size);
+  tree->node_count -= last - first;
+}
+
+static bool rb_small_pop(RBTree tree, bool max, void* out) {
+  if (tree->node_count == 0) return false;
+  size_t i = max ? tree->node_count - 1 : 0;
+  if (out != NULL) memcpy(out, rb_small_record(tree, i), tree->data_size);
+  rb_small_erase(tree, i, i + 1, out == NULL);
+  return true;
+}
+
+static size_t rb_small_remove_range(RBTree tree, const void* lo, const void* hi) {
+  bool found;
+  size_t first = rb_small_search(tree, lo, &found);
+  size_t last = rb_small_search(tree, hi, &found) + found;
+  rb_small_erase(tree, first, last, true);
+  return last - first;
+}
+
+int rb_set_adaptive(RBTree tree, size_t threshold) {
+  if (tree->root != NULL || tree->node_count > 0 || tree->record_size != NULL || tree->augment.compute != NULL ||
+      tree->filter.blocks != NULL || tree->cache.entries != NULL) {
+    return EINVAL;
+  }
+
+  char* small = NULL;
+  if (threshold > 0) {
+    small = tree->allocator.alloc(tree->allocator.ctx, threshold * tree->data_size);
+    if (!small) return ENOMEM;
+  }
+  if (tree->small) tree->allocator.free(tree->allocator.ctx, tree->small);
+  tree->small = small;
+  tree->small_capacity = threshold;
+  return 0;
+}
+
+int rb_add(RBTree tree, const void* data) {
+  struct rb_trace trace = rb_trace_begin(tree, data, TRACE_ACTIVE(rb, add_entry) || TRACE_ACTIVE(rb, add_return));
+  TRACE2(rb, add_entry, data, trace.key_size);
+  int error = rb_is_small(tree) ? rb_small_add(tree, data, NULL) : rb_root_add(tree, data, NULL);
+  TRACE4(rb, add_return, error, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return error;
+}
 
-  return rb_fixup(node);
+int rb_map_put(RBTree tree, const void* key, const void* value) {
+  struct rb_trace trace =
+      rb_trace_begin(tree, key, TRACE_ACTIVE(rb, map_put_entry) || TRACE_ACTIVE(rb, map_put_return));
+  TRACE2(rb, map_put_entry, key, trace.key_size);
+  int error = rb_is_small(tree) ? rb_small_add(tree, key, value) : rb_root_add(tree, key, value);
+  TRACE4(rb, map_put_return, error, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return error;
 }
 
-void rb_add(RBTree tree, const void* data) {
-  tree->root = rb_node_add(&tree->root, data, tree->data_size, tree->compare);
+// Insertion from one edge of the tree: the spine is collected without comparisons, then climbed from its end
+// until data fits below it, so data d positions away from the edge costs O(log d) comparisons instead of O(log n).
+// The spine is then fixed up bottom-up, like the recursion of rb_node_add would on its way back up.
+static int rb_root_add_edge(RBTree tree, bool left, const void* data) {
+  if (tree->root == NULL) return rb_is_small(tree) ? rb_small_add(tree, data, NULL) : rb_root_add(tree, data, NULL);
+
+  bool from_right = !left;
+  RBNode spine[RB_MAX_HEIGHT];
+  int depth = 0;
+  for (RBNode node = tree->root; node != NULL; node = from_right ? node->right : node->left) {
+    spine[depth++] = node;
+  }
+
+  unsigned char buffer[RB_MAX_PREFIX];
+  const unsigned char* prefix = rb_key_prefix(tree, data, buffer);
+  int top = depth - 1;
+  while (top >= 0) {
+    int cmp = rb_compare_node(tree, data, prefix, spine[top]);
+    if (cmp == 0) return 0;  // data already in tree
+    if (from_right ? cmp > 0 : cmp < 0) break;
+    top--;
+  }
+
+  if (tree->classic) {  // the spine is the path down to where data belongs, no fixing up on the way back
+    RBNode* links[RB_MAX_HEIGHT + 2];
+    links[0] = &tree->root;
+    for (int i = 1; i <= MIN(top + 2, depth); i++) {
+      links[i] = from_right ? &spine[i - 1]->right : &spine[i - 1]->left;
+    }
+    if (top == depth - 1) return rb_classic_add(tree, links, depth, data, NULL, prefix, !from_right, from_right);
+    links[top + 2] = from_right ? &spine[top + 1]->left : &spine[top + 1]->right;
+    bool outermost = top < 0;
+    return rb_classic_add(tree, links, top + 2, data, NULL, prefix, outermost && from_right, outermost && !from_right);
+  }
+
+  if (top == depth - 1) {  // beyond the edge, appended without further comparisons
+    RBNode new_node = rb_node_new(tree, data, NULL, true);
+    if (new_node == NULL) return ENOMEM;
+    if (from_right) {
+      spine[top]->right = new_node;
+      tree->max = new_node;
+    } else {
+      spine[top]->left = new_node;
+      tree->min = new_node;
+    }
+  } else {  // between spine[top] and spine[top + 1], in the inner subtree of the latter
+    RBNode* inner = from_right ? &spine[top + 1]->left : &spine[top + 1]->right;
+    bool outermost = top < 0;  // past the root, data may be the new extreme on the other side
+    int error = 0;
+    *inner =
+        rb_node_add(tree, inner, data, NULL, prefix, outermost && from_right, outermost && !from_right, &error);
+    if (error) return error;
+  }
+
+  for (int i = MIN(top + 1, depth - 1); i >= 0; i--) {
+    RBNode fixed = rb_fixup(tree, &spine[i]);
+    if (i == 0) {
+      tree->root = fixed;
+    } else if (from_right) {
+      spine[i - 1]->right = fixed;
+    } else {
+      spine[i - 1]->left = fixed;
+    }
+  }
   tree->root->isRed = false;
+  return 0;
+}
+
+int rb_add_edge(RBTree tree, bool left, const void* data) {
+  struct rb_trace trace =
+      rb_trace_begin(tree, data, TRACE_ACTIVE(rb, add_edge_entry) || TRACE_ACTIVE(rb, add_edge_return));
+  TRACE2(rb, add_edge_entry, data, trace.key_size);
+  int error = rb_root_add_edge(tree, left, data);
+  TRACE4(rb, add_edge_return, error, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return error;
 }
 
 // --- Search ---
 
 RBNode rb_find_node(RBTree tree, const void* data) {
+  if (!rb_small_pin(tree)) return NULL;
   RBNode current = tree->root;
+  unsigned char buffer[RB_MAX_PREFIX];
+  const unsigned char* prefix = rb_key_prefix(tree, data, buffer);
+  uint64_t tag = 0;
+  if (tree->cache.entries) {
+    tag = rb_mix_hash(tree->cache.hash(data));
+    RBNode cached = rb_cache_find(tree, data, tag);
+    if (cached) return cached;
+  }
+  if (!rb_filter_admits(tree, data)) return NULL;
 
   while (current != NULL) {
-    int cmp = tree->compare(data, current->data);
+    int cmp = rb_compare_node(tree, data, prefix, current);
     if (cmp == 0) {
+      if (tree->cache.entries) *rb_cache_entry(tree, tag) = (struct rb_lookup_entry){tag, current};
       return current;
     } else if (cmp < 0) {
       current = current->left;
@@ -266,12 +1216,108 @@ RBNode rb_find_node(RBTree tree, const void* data) {
     }
   }
 
+  if (tree->filter.blocks) tree->filter.false_positives++;
   return NULL;
 }
 
 void* rb_find_data(RBTree tree, const void* data) {
-  RBNode node = rb_find_node(tree, data);
-  return node ? node->data : NULL;
+  struct rb_trace trace = rb_trace_begin(tree, data, TRACE_ACTIVE(rb, find_entry) || TRACE_ACTIVE(rb, find_return));
+  TRACE2(rb, find_entry, data, trace.key_size);
+  void* found;
+  if (rb_is_small(tree)) {
+    found = rb_small_find(tree, data);
+  } else {
+    RBNode node = rb_find_node(tree, data);
+    found = node ? node->data : NULL;
+  }
+  TRACE4(rb, find_return, found, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return found;
+}
+
+void* rb_map_get(RBTree tree, const void* key) {
+  struct rb_trace trace =
+      rb_trace_begin(tree, key, TRACE_ACTIVE(rb, map_get_entry) || TRACE_ACTIVE(rb, map_get_return));
+  TRACE2(rb, map_get_entry, key, trace.key_size);
+  char* record;
+  if (rb_is_small(tree)) {
+    record = rb_small_find(tree, key);
+  } else {
+    RBNode node = rb_find_node(tree, key);
+    record = node ? node->data : NULL;
+  }
+  void* value = record ? record + tree->key_size : NULL;
+  TRACE4(rb, map_get_return, value, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return value;
+}
+
+// Variable-length records cannot be strided, batches of them are arrays of pointers
+static const void* rb_batch_key(RBTree tree, const char* keys, size_t i) {
+  return tree->record_size ? ((const void* const*)keys)[i] : keys + i * tree->key_size;
+}
+
+// Group prefetching: the lookups of a group advance one level each per round, prefetching their next node, so the
+// cache misses of the whole group overlap instead of being paid one after the other
+// see: Chen et al., "Improving Hash Join Performance through Prefetching" (2004)
+static size_t rb_root_find_batch(RBTree tree, const void* data, size_t count, void** results) {
+  const char* keys = data;
+  size_t found = 0;
+  if (rb_is_small(tree)) {
+    for (size_t i = 0; i < count; i++) {
+      results[i] = rb_small_find(tree, rb_batch_key(tree, keys, i));
+      found += results[i] != NULL;
+    }
+    return found;
+  }
+
+  for (size_t start = 0; start < count; start += RB_BATCH_GROUP) {
+    size_t group = MIN((size_t)RB_BATCH_GROUP, count - start);
+    RBNode current[RB_BATCH_GROUP];
+    bool admitted[RB_BATCH_GROUP];  // keys the filter rejected are never searched
+    for (size_t i = 0; i < group; i++) {
+      admitted[i] = rb_filter_admits(tree, rb_batch_key(tree, keys, start + i));
+      current[i] = admitted[i] ? tree->root : NULL;
+      results[start + i] = NULL;
+    }
+
+    size_t active = tree->root ? group : 0;
+    while (active > 0) {
+      active = 0;
+      for (size_t i = 0; i < group; i++) {
+        RBNode node = current[i];
+        if (node == NULL) continue;
+
+        int cmp = tree->compare(rb_batch_key(tree, keys, start + i), node->data);
+        if (cmp == 0) {
+          results[start + i] = node->data;
+          current[i] = NULL;
+          found++;
+          continue;
+        }
+
+        node = cmp < 0 ? node->left : node->right;
+        current[i] = node;
+        if (node != NULL) {
+          PREFETCH(node);
+          active++;
+        }
+      }
+    }
+
+    for (size_t i = 0; i < group && tree->filter.blocks; i++) {
+      if (admitted[i] && results[start + i] == NULL) tree->filter.false_positives++;
+    }
+  }
+
+  return found;
+}
+
+size_t rb_find_batch(RBTree tree, const void* data, size_t count, void** results) {
+  struct rb_trace trace =
+      rb_trace_begin(tree, NULL, TRACE_ACTIVE(rb, find_batch_entry) || TRACE_ACTIVE(rb, find_batch_return));
+  TRACE2(rb, find_batch_entry, data, count);
+  size_t found = rb_root_find_batch(tree, data, count, results);
+  TRACE4(rb, find_batch_return, found, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return found;
 }
 
 static RBNode rb_get_min_node(RBNode node) {
@@ -279,69 +1325,674 @@ static RBNode rb_get_min_node(RBNode node) {
   return rb_get_min_node(node->left);
 }
 
+static RBNode rb_get_max_node(RBNode node) {
+  if (node->right == NULL) return node;
+  return rb_get_max_node(node->right);
+}
+
 // --- Deletion ---
 // see: https://www.teachsolaisgames.com/articles/balanced_left_leaning.html (better comments than original paper)
 
-static RBNode rb_node_remove_min(RBNode* node, const void* data, int (*compare)(const void*, const void*),
-                                 void (*del)(void*), bool del_data) {
+// Frees a node unlinked from the tree, the cached min/max are reset if they pointed to it
+static void rb_free_node(RBTree tree, RBNode node, bool del_data) {
+  if (node == tree->min) tree->min = NULL;
+  if (node == tree->max) tree->max = NULL;
+  delete_node(tree, node, del_data);
+}
+
+// Restores the cached min/max after a removal, only walks down the spines when they were freed, and shrinks the
+// Bloom filter
+static void rb_update_bounds(RBTree tree) {
+  rb_filter_shrink(tree);
+  if (tree->root == NULL) {
+    tree->min = NULL;
+    tree->max = NULL;
+    return;
+  }
+  tree->root->isRed = false;
+  if (tree->min == NULL) tree->min = rb_get_min_node(tree->root);
+  if (tree->max == NULL) tree->max = rb_get_max_node(tree->root);
+}
+
+// No comparisons needed, the leftmost node of a subtree is found by following left links and unlinked into min
+static RBNode rb_node_detach_min(RBTree tree, RBNode* node, RBNode* min) {
   if ((*node)->left == NULL) {
-    delete_node(*node, del, del_data);
+    *min = *node;
     return NULL;
   }
 
   if (!is_red((*node)->left) && (*node)->left != NULL && !is_red((*node)->left->left)) {
-    *node = rb_move_red_left(node);
+    *node = rb_move_red_left(tree, node);
+  }
+
+  (*node)->left = rb_node_detach_min(tree, &(*node)->left, min);
+
+  return rb_fixup(tree, node);
+}
+
+static RBNode rb_node_remove_min(RBTree tree, RBNode* node, bool del_data) {
+  RBNode min;
+  RBNode root = rb_node_detach_min(tree, node, &min);
+  rb_free_node(tree, min, del_data);
+  return root;
+}
+
+// Mirror of rb_node_remove_min, red left links are rotated to the right on the way down
+static RBNode rb_node_remove_max(RBTree tree, RBNode* node, bool del_data) {
+  if (is_red((*node)->left)) {
+    *node = rotate_right(tree, *node);
+  }
+
+  if ((*node)->right == NULL) {
+    rb_free_node(tree, *node, del_data);
+    return NULL;
+  }
+
+  if (!is_red((*node)->right) && !is_red((*node)->right->left)) {
+    *node = rb_move_red_right(tree, node);
   }
 
-  (*node)->left = rb_node_remove_min(&(*node)->left, data, compare, del, del_data);
+  (*node)->right = rb_node_remove_max(tree, &(*node)->right, del_data);
 
-  return rb_fixup(node);
+  return rb_fixup(tree, node);
 }
 
 // avoids "double-black" scenarios ("2-nodes" in 2-3-4 trees) by forcing the branch we descend into to never have two
 // blacks in a row This simplifies the actual deletion of the node, but can cause some extra unnecessary operations
 // during descent Any two reds in a row caused by these operations are fixed during ascent with the same rb_fixup as
 // rb_node_add
-static RBNode rb_node_remove(RBNode* node, const void* data, size_t size, int (*compare)(const void*, const void*),
-                             void (*del)(void*)) {
+static RBNode rb_node_remove(RBTree tree, RBNode* node, const void* data, const unsigned char* prefix) {
   if (*node == NULL) return NULL;
 
-  if (compare(data, (*node)->data) < 0) {
+  if (rb_compare_node(tree, data, prefix, *node) < 0) {
     if (!is_red((*node)->left) && (*node)->left != NULL && !is_red((*node)->left->left)) {
-      *node = rb_move_red_left(node);
+      *node = rb_move_red_left(tree, node);
     }
-    (*node)->left = rb_node_remove(&(*node)->left, data, size, compare, del);
+    (*node)->left = rb_node_remove(tree, &(*node)->left, data, prefix);
 
   } else {
     if (is_red((*node)->left)) {
-      *node = rotate_right(*node);
+      *node = rotate_right(tree, *node);
     }
 
     // node is leaf, explanation: https://stackoverflow.com/questions/13360369/deletion-in-left-leaning-red-black-trees
-    if (compare(data, (*node)->data) == 0 && (*node)->right == NULL) {
-      delete_node(*node, del, true);
+    if (rb_compare_node(tree, data, prefix, *node) == 0 && (*node)->right == NULL) {
+      rb_free_node(tree, *node, true);
       return NULL;
     }
 
     if (!is_red((*node)->right) && (*node)->right != NULL && !is_red((*node)->right->left)) {
-      *node = rb_move_red_right(node);
+      *node = rb_move_red_right(tree, node);
     }
 
-    // node is internal
-    if (compare(data, (*node)->data) == 0) {
-      if (del) del((*node)->data);
-      memcpy((*node)->data, rb_get_min_node((*node)->right)->data, size);
-      (*node)->right = rb_node_remove_min(&(*node)->right, data, compare, del, false);
+    // node is internal, its successor node takes its place: records are never copied between nodes since their
+    // lengths may differ
+    if (rb_compare_node(tree, data, prefix, *node) == 0) {
+      RBNode successor;
+      RBNode right = rb_node_detach_min(tree, &(*node)->right, &successor);
+      successor->left = (*node)->left;
+      successor->right = right;
+      successor->isRed = (*node)->isRed;
+      rb_free_node(tree, *node, true);
+      *node = successor;
     }
 
     else
-      (*node)->right = rb_node_remove(&(*node)->right, data, size, compare, del);
+      (*node)->right = rb_node_remove(tree, &(*node)->right, data, prefix);
   }
 
-  return rb_fixup(node);
+  return rb_fixup(tree, node);
+}
+
+// --- Classic Mode Deletion ---
+
+// links[depth] lost a black node and holds a subtree one black short, possibly empty. The deficit climbs while the
+// sibling and its children are black, otherwise 1 to 3 rotations end it.
+static void rb_classic_remove_fixup(RBTree tree, RBNode** links, int depth) {
+  int i = depth;
+  while (i > 0 && !is_red(*links[i])) {
+    RBNode parent = *links[i - 1];
+    bool is_left = links[i] == &parent->left;
+    RBNode sibling = is_left ? parent->right : parent->left;
+
+    if (sibling->isRed) {  // the parent goes one level down, the path grows by one link
+      *links[i - 1] = is_left ? rotate_left(tree, parent) : rotate_right(tree, parent);
+      links[i] = is_left ? &sibling->left : &sibling->right;
+      links[i + 1] = is_left ? &parent->left : &parent->right;
+      i++;
+      sibling = is_left ? parent->right : parent->left;
+    }
+
+    if (!is_red(sibling->left) && !is_red(sibling->right)) {
+      sibling->isRed = true;
+      i--;
+      continue;
+    }
+
+    if (is_left) {
+      if (!is_red(sibling->right)) sibling = parent->right = rotate_right(tree, sibling);
+      *links[i - 1] = rotate_left(tree, parent);
+    } else {
+      if (!is_red(sibling->left)) sibling = parent->left = rotate_left(tree, sibling);
+      *links[i - 1] = rotate_right(tree, parent);
+    }
+    parent->isRed = false;
+    if (is_left) {
+      sibling->right->isRed = false;
+    } else {
+      sibling->left->isRed = false;
+    }
+    return;
+  }
+  if (*links[i] != NULL) (*links[i])->isRed = false;
+}
+
+// Unlinks the node held by links[depth] and frees it. A node with two children is replaced by its successor node,
+// the removed color is then the successor's and fixing up starts from the successor's old link.
+static void rb_classic_remove_at(RBTree tree, RBNode** links, int depth, bool del_data) {
+  RBNode node = *links[depth];
+  int hole = depth;
+  bool removed_red = node->isRed;
+
+  if (node->left == NULL || node->right == NULL) {
+    *links[depth] = node->left ? node->left : node->right;
+  } else {
+    links[depth + 1] = &node->right;
+    hole = depth + 1;
+    while ((*links[hole])->left != NULL) {
+      links[hole + 1] = &(*links[hole])->left;
+      hole++;
+    }
+
+    RBNode successor = *links[hole];
+    removed_red = successor->isRed;
+    *links[hole] = successor->right;
+    successor->left = node->left;
+    successor->right = node->right;
+    successor->isRed = node->isRed;
+    *links[depth] = successor;
+    links[depth + 1] = &successor->right;
+  }
+  rb_free_node(tree, node, del_data);
+
+  rb_classic_refresh(tree, links, hole - 1);
+  if (!removed_red) rb_classic_remove_fixup(tree, links, hole);
+}
+
+// Removes the smallest or largest node without comparisons
+static void rb_classic_remove_edge(RBTree tree, bool largest, bool del_data) {
+  RBNode* links[RB_MAX_HEIGHT + 2];
+  int depth = 0;
+  links[0] = &tree->root;
+  while ((largest ? (*links[depth])->right : (*links[depth])->left) != NULL) {
+    links[depth + 1] = largest ? &(*links[depth])->right : &(*links[depth])->left;
+    depth++;
+  }
+  rb_classic_remove_at(tree, links, depth, del_data);
+}
+
+static void rb_classic_remove(RBTree tree, const void* data) {
+  RBNode* links[RB_MAX_HEIGHT + 2];
+  int depth = 0;
+  unsigned char buffer[RB_MAX_PREFIX];
+  const unsigned char* prefix = rb_key_prefix(tree, data, buffer);
+
+  links[0] = &tree->root;
+  while (*links[depth] != NULL) {
+    int cmp = rb_compare_node(tree, data, prefix, *links[depth]);
+    if (cmp == 0) {
+      rb_classic_remove_at(tree, links, depth, true);
+      return;
+    }
+    links[depth + 1] = cmp < 0 ? &(*links[depth])->left : &(*links[depth])->right;
+    depth++;
+  }
+}
+
+static void rb_root_remove(RBTree tree, const void* data) {
+  if (rb_is_small(tree)) {
+    bool found;
+    size_t i = rb_small_search(tree, data, &found);
+    if (found) rb_small_erase(tree, i, i + 1, true);
+    return;
+  }
+  if (tree->classic) {
+    rb_classic_remove(tree, data);
+  } else {
+    unsigned char prefix[RB_MAX_PREFIX];
+    tree->root = rb_node_remove(tree, &tree->root, data, rb_key_prefix(tree, data, prefix));
+  }
+  rb_update_bounds(tree);
+  rb_small_shrink(tree);
 }
 
 void rb_remove(RBTree tree, const void* data) {
-  tree->root = rb_node_remove(&tree->root, data, tree->data_size, tree->compare, tree->delete_data);
-  if (tree->root != NULL) tree->root->isRed = false;
+  struct rb_trace trace = rb_trace_begin(tree, data, TRACE_ACTIVE(rb, remove_entry) || TRACE_ACTIVE(rb, remove_return));
+  TRACE2(rb, remove_entry, data, trace.key_size);
+  size_t count = tree->node_count;
+  rb_root_remove(tree, data);
+  TRACE4(rb, remove_return, tree->node_count != count, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+}
+
+static bool rb_root_pop_min(RBTree tree, void* out) {
+  if (rb_is_small(tree)) return rb_small_pop(tree, false, out);
+  if (tree->root == NULL) return false;
+
+  if (out != NULL) memcpy(out, tree->min->data, rb_node_get_data_size(tree, tree->min));
+  if (tree->classic) {
+    rb_classic_remove_edge(tree, false, out == NULL);
+  } else {
+    tree->root = rb_node_remove_min(tree, &tree->root, out == NULL);
+  }
+  rb_update_bounds(tree);
+  rb_small_shrink(tree);
+  return true;
+}
+
+bool rb_pop_min(RBTree tree, void* out) {
+  struct rb_trace trace =
+      rb_trace_edge(tree, false, TRACE_ACTIVE(rb, pop_min_entry) || TRACE_ACTIVE(rb, pop_min_return));
+  TRACE2(rb, pop_min_entry, out, trace.key_size);
+  bool popped = rb_root_pop_min(tree, out);
+  TRACE4(rb, pop_min_return, popped, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return popped;
+}
+
+static bool rb_root_pop_max(RBTree tree, void* out) {
+  if (rb_is_small(tree)) return rb_small_pop(tree, true, out);
+  if (tree->root == NULL) return false;
+
+  if (out != NULL) memcpy(out, tree->max->data, rb_node_get_data_size(tree, tree->max));
+  if (tree->classic) {
+    rb_classic_remove_edge(tree, true, out == NULL);
+  } else {
+    tree->root = rb_node_remove_max(tree, &tree->root, out == NULL);
+  }
+  rb_update_bounds(tree);
+  rb_small_shrink(tree);
+  return true;
+}
+
+bool rb_pop_max(RBTree tree, void* out) {
+  struct rb_trace trace =
+      rb_trace_edge(tree, true, TRACE_ACTIVE(rb, pop_max_entry) || TRACE_ACTIVE(rb, pop_max_return));
+  TRACE2(rb, pop_max_entry, out, trace.key_size);
+  bool popped = rb_root_pop_max(tree, out);
+  TRACE4(rb, pop_max_return, popped, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return popped;
+}
+
+// Black height of a subtree, counting its root if black. Every path has the same number of black nodes.
+static int rb_black_height(RBNode node) {
+  int height = 0;
+  for (; node != NULL; node = node->left) {
+    height += !node->isRed;
+  }
+  return height;
+}
+
+// Makes a subtree of black height height a tree of its own with a black root, returns its new black height
+static int rb_blacken(RBNode node, int height) {
+  if (!is_red(node)) return height;
+  node->isRed = false;
+  return height + 1;
+}
+
+// Attaches node as a red node where the right spine of a black-rooted subtree of black height height reaches the black
+// height of right, then fixes up on the way back like an insertion
+static RBNode rb_join_right(RBTree tree, RBNode* left, int height, RBNode node, RBNode right, int right_height) {
+  if (height == right_height && !is_red(*left)) {
+    node->left = *left;
+    node->right = right;
+    node->isRed = true;
+    rb_node_update(tree, node);
+    return node;
+  }
+  (*left)->right = rb_join_right(tree, &(*left)->right, height - !(*left)->isRed, node, right, right_height);
+  return rb_fixup(tree, left);
+}
+
+// Mirror of rb_join_right along the left spine, whose red nodes are skipped so that node's right link stays black
+static RBNode rb_join_left(RBTree tree, RBNode* right, int height, RBNode node, RBNode left, int left_height) {
+  if (height == left_height && !is_red(*right)) {
+    node->left = left;
+    node->right = *right;
+    node->isRed = true;
+    rb_node_update(tree, node);
+    return node;
+  }
+  (*right)->left = rb_join_left(tree, &(*right)->left, height - !(*right)->isRed, node, left, left_height);
+  return rb_fixup(tree, right);
+}
+
+// Joins two black-rooted subtrees around a middle node, all data of left < node < all data of right, in O(black height
+// difference). The result has a black root, its black height is written to height.
+// see: Blelloch et al., "Just Join for Parallel Ordered Sets" (2016)
+static RBNode rb_join(RBTree tree, RBNode left, int left_height, RBNode node, RBNode right, int right_height,
+                      int* height) {
+  RBNode root;
+  if (left_height > right_height) {
+    root = rb_join_right(tree, &left, left_height, node, right, right_height);
+  } else if (left_height < right_height) {
+    root = rb_join_left(tree, &right, right_height, node, left, left_height);
+  } else {
+    node->left = left;
+    node->right = right;
+    node->isRed = true;
+    rb_node_update(tree, node);
+    root = node;
+  }
+  *height = rb_blacken(root, MAX(left_height, right_height));
+  return root;
+}
+
+// Joins two black-rooted subtrees without a middle node, the minimum of right is detached to take its place
+static RBNode rb_merge(RBTree tree, RBNode left, int left_height, RBNode right, int right_height, int* height) {
+  if (right == NULL) {
+    *height = left_height;
+    return left;
+  }
+  if (left == NULL) {
+    *height = right_height;
+    return right;
+  }
+  RBNode min;
+  right = rb_node_detach_min(tree, &right, &min);
+  if (right != NULL) right->isRed = false;
+  return rb_join(tree, left, left_height, min, right, rb_black_height(right), height);
+}
+
+// A NULL bound is unbounded. height is the black height of node, the result has a black root and its black height is
+// written to out_height. Nodes outside the range are joined back with what is left of their subtree on the range's
+// side, and below the first node inside it, the range only reaches into one side of each subtree. The joins along a
+// path telescope to O(log n), and the removed subtrees are freed whole.
+static RBNode rb_node_remove_range(RBTree tree, RBNode node, int height, const void* lo, const void* hi,
+                                   size_t* removed, int* out_height) {
+  *out_height = 0;
+  if (node == NULL) return NULL;
+  if (lo == NULL && hi == NULL) {
+    *removed += delete_all_nodes(tree, node);
+    return NULL;
+  }
+
+  int child_height = height - !node->isRed;
+  int left_height, right_height;
+  if (lo != NULL && tree->compare(node->data, lo) < 0) {
+    RBNode right = rb_node_remove_range(tree, node->right, child_height, lo, hi, removed, &right_height);
+    left_height = rb_blacken(node->left, child_height);
+    return rb_join(tree, node->left, left_height, node, right, right_height, out_height);
+  }
+  if (hi != NULL && tree->compare(node->data, hi) > 0) {
+    RBNode left = rb_node_remove_range(tree, node->left, child_height, lo, hi, removed, &left_height);
+    right_height = rb_blacken(node->right, child_height);
+    return rb_join(tree, left, left_height, node, node->right, right_height, out_height);
+  }
+
+  RBNode left = rb_node_remove_range(tree, node->left, child_height, lo, NULL, removed, &left_height);
+  RBNode right = rb_node_remove_range(tree, node->right, child_height, NULL, hi, removed, &right_height);
+  delete_node(tree, node, true);
+  (*removed)++;
+  return rb_merge(tree, left, left_height, right, right_height, out_height);
+}
+
+// Joins rely on left-leaning fixups, a classic tree removes the range one node at a time instead: the descent towards
+// lo records the path to the first node inside the range, which is removed until the first node is past hi
+static size_t rb_classic_remove_range(RBTree tree, const void* lo, const void* hi) {
+  size_t removed = 0;
+  for (;;) {
+    RBNode* links[RB_MAX_HEIGHT + 2];
+    int depth = 0;
+    int found = -1;
+    links[0] = &tree->root;
+    while (*links[depth] != NULL) {
+      RBNode node = *links[depth];
+      if (lo == NULL || tree->compare(node->data, lo) >= 0) {
+        found = depth;
+        links[depth + 1] = &node->left;
+      } else {
+        links[depth + 1] = &node->right;
+      }
+      depth++;
+    }
+    if (found < 0 || (hi != NULL && tree->compare((*links[found])->data, hi) > 0)) return removed;
+
+    rb_classic_remove_at(tree, links, found, true);
+    removed++;
+  }
+}
+
+static size_t rb_root_remove_range(RBTree tree, const void* lo, const void* hi) {
+  if (rb_is_small(tree)) return tree->compare(lo, hi) > 0 ? 0 : rb_small_remove_range(tree, lo, hi);
+  if (tree->root == NULL || tree->compare(lo, hi) > 0) return 0;
+
+  size_t removed = 0;
+  if (tree->classic) {
+    removed = rb_classic_remove_range(tree, lo, hi);
+  } else {
+    int height;
+    tree->root = rb_node_remove_range(tree, tree->root, rb_black_height(tree->root), lo, hi, &removed, &height);
+  }
+  if (removed > 0) {
+    tree->min = NULL;  // possibly freed with the range
+    tree->max = NULL;
+    rb_update_bounds(tree);
+    rb_small_shrink(tree);
+  }
+  return removed;
+}
+
+size_t rb_remove_range(RBTree tree, const void* lo, const void* hi) {
+  struct rb_trace trace =
+      rb_trace_begin(tree, lo, TRACE_ACTIVE(rb, remove_range_entry) || TRACE_ACTIVE(rb, remove_range_return));
+  TRACE3(rb, remove_range_entry, lo, hi, trace.key_size);
+  size_t removed = rb_root_remove_range(tree, lo, hi);
+  TRACE4(rb, remove_range_return, removed, trace.key_size, trace.depth, tree->rotations - trace.rotations);
+  return removed;
+}
+
+// --- Compaction ---
+
+// Moves path[depth - 1] into the region being filled and relinks it. Once the region is full, nodes stay where they
+// are, unless they live in the previous region, which is freed when the compaction ends.
+static RBNode rb_move_node(RBTree tree, RBNode* path, int depth) {
+  RBNode node = path[depth - 1];
+  if (rb_in_region(tree->next_region, tree->next_region_size, (char*)node - tree->header_size)) {
+    return node;  // already moved, before the compaction started over
+  }
+  size_t size = rb_node_block_size(tree, node);
+  size_t stride = rb_node_stride(tree, size);
+  char* block;
+  if (tree->next_region_used + stride <= tree->next_region_size) {
+    block = tree->next_region + tree->next_region_used;
+    tree->next_region_used += stride;
+  } else if (rb_in_region(tree->region, tree->region_size, (char*)node - tree->header_size)) {
+    block = tree->allocator.alloc(tree->allocator.ctx, size);
+    if (!block) return NULL;
+  } else {
+    return node;
+  }
+
+  memcpy(block, (char*)node - tree->header_size, size);
+  RBNode moved = (RBNode)(block + tree->header_size);
+  rb_cache_move(tree, node, moved);
+  if (depth == 1) {
+    tree->root = moved;
+  } else if (path[depth - 2]->left == node) {
+    path[depth - 2]->left = moved;
+  } else {
+    path[depth - 2]->right = moved;
+  }
+  if (tree->min == node) tree->min = moved;
+  if (tree->max == node) tree->max = moved;
+  rb_free_block(tree, node);
+  path[depth - 1] = moved;
+  return moved;
+}
+
+int rb_compact_begin(RBTree tree) {
+  if (tree->next_region != NULL) return 0;
+  if (tree->node_bytes == 0) {  // nothing to move, a previous region only holds removed nodes
+    if (tree->region) tree->allocator.free(tree->allocator.ctx, tree->region);
+    tree->region = NULL;
+    tree->region_size = 0;
+    return 0;
+  }
+
+  tree->next_region = tree->allocator.alloc(tree->allocator.ctx, tree->node_bytes);
+  if (tree->next_region == NULL) return ENOMEM;
+  tree->next_region_size = tree->node_bytes;
+  tree->next_region_used = 0;
+  return 0;
+}
+
+// Nodes are moved in order, so every subtree ends up contiguous. Steps resume after the data of the last moved node
+// rather than from a saved path, the tree can then change freely between them. If that node is removed, its data may
+// be gone with it, so the next step starts over from the first node instead.
+int rb_compact_step(RBTree tree, size_t max_nodes, bool* done) {
+  *done = tree->next_region == NULL;
+  if (*done || max_nodes == 0) return 0;
+
+  RBNode path[RB_MAX_HEIGHT];
+  int depth = 0;
+  int found = 0;
+  for (RBNode node = tree->root; node != NULL;) {
+    path[depth++] = node;
+    if (tree->cursor == NULL || tree->compare(tree->cursor->data, node->data) < 0) {
+      found = depth;
+      node = node->left;
+    } else {
+      node = node->right;
+    }
+  }
+  depth = found;
+
+  for (size_t visited = 0; depth > 0 && visited < max_nodes; visited++) {
+    RBNode node = rb_move_node(tree, path, depth);
+    if (node == NULL) return ENOMEM;  // the next step retries from the same cursor
+    tree->cursor = node;
+
+    if (node->right != NULL) {
+      for (RBNode next = node->right; next != NULL; next = next->left) {
+        path[depth++] = next;
+      }
+    } else {
+      RBNode child;
+      do {
+        child = path[--depth];
+      } while (depth > 0 && path[depth - 1]->right == child);
+    }
+  }
+
+  if (depth == 0) {
+    tree->cursor = NULL;
+    if (tree->region) tree->allocator.free(tree->allocator.ctx, tree->region);
+    tree->region = tree->next_region;
+    tree->region_size = tree->next_region_size;
+    tree->next_region = NULL;
+    tree->next_region_size = 0;
+    *done = true;
+  }
+  return 0;
+}
+
+static void rb_node_footprint(RBTree tree, RBNode node, RBFootprint* out, uintptr_t* low, uintptr_t* high) {
+  if (node == NULL) return;
+
+  char* block = (char*)node - tree->header_size;
+  size_t size = rb_node_block_size(tree, node);
+  out->nodes++;
+  if (!rb_in_region(tree->region, tree->region_size, block) &&
+      !rb_in_region(tree->next_region, tree->next_region_size, block)) {
+    out->allocations++;
+    out->bytes += size;
+  }
+  *low = MIN(*low, (uintptr_t)block);
+  *high = MAX(*high, (uintptr_t)block + size);
+  rb_node_footprint(tree, node->left, out, low, high);
+  rb_node_footprint(tree, node->right, out, low, high);
+}
+
+void rb_get_footprint(RBTree tree, RBFootprint* out) {
+  *out = (RBFootprint){0};
+  uintptr_t low = UINTPTR_MAX, high = 0;
+  rb_node_footprint(tree, tree->root, out, &low, &high);
+  out->allocations += (tree->region != NULL) + (tree->next_region != NULL);
+  out->bytes += tree->region_size + tree->next_region_size;
+  if (tree->small) {  // the array of an adaptive tree, allocated whether or not it holds the records
+    out->allocations++;
+    out->bytes += tree->small_capacity * tree->data_size;
+  }
+  out->span = out->nodes > 0 ? high - low : 0;
+}
+
+int rb_compact(RBTree tree, RBFootprint* before, RBFootprint* after) {
+  if (before) rb_get_footprint(tree, before);
+  int error = rb_compact_begin(tree);
+  bool done = false;
+  while (!error && !done) {
+    error = rb_compact_step(tree, SIZE_MAX, &done);
+  }
+  if (after) rb_get_footprint(tree, after);
+  return error;
+}
+
+// --- Aggregates ---
+
+// Aggregate of the data of a subtree that is >= bound (from_lo) or <= bound (!from_lo). The nodes kept on the search
+// path are combined bottom-up with the stored aggregate of their subtree on the inner side.
+static void rb_node_aggregate_bound(RBTree tree, RBNode node, const void* bound, bool from_lo, void* out, void* tmp) {
+  RBNode path[RB_MAX_HEIGHT];
+  int depth = 0;
+
+  while (node != NULL) {
+    int cmp = tree->compare(node->data, bound);
+    if (from_lo ? cmp >= 0 : cmp <= 0) {
+      path[depth++] = node;
+      node = from_lo ? node->left : node->right;
+    } else {
+      node = from_lo ? node->right : node->left;
+    }
+  }
+
+  memcpy(out, tree->augment.identity, tree->augment.size);
+  while (depth-- > 0) {
+    RBNode current = path[depth];
+    if (from_lo) {
+      tree->augment.compute(tmp, current->data, out, rb_subtree_aggregate(tree, current->right));
+    } else {
+      tree->augment.compute(tmp, current->data, rb_subtree_aggregate(tree, current->left), out);
+    }
+    memcpy(out, tmp, tree->augment.size);
+  }
+}
+
+int rb_range_aggregate(RBTree tree, const void* lo, const void* hi, void* out) {
+  if (tree->augment.compute == NULL) return EINVAL;
+
+  // highest node inside the range, both bounds are then searched for in its subtrees
+  RBNode split = tree->root;
+  while (split != NULL) {
+    if (tree->compare(split->data, lo) < 0) {
+      split = split->right;
+    } else if (tree->compare(split->data, hi) > 0) {
+      split = split->left;
+    } else {
+      break;
+    }
+  }
+
+  if (split == NULL) {
+    memcpy(out, tree->augment.identity, tree->augment.size);
+    return 0;
+  }
+
+  const size_t stride = tree->augment_scratch - (const char*)tree->augment.identity;
+  char* left = tree->augment_scratch;
+  char* right = left + stride;
+  char* tmp = right + stride;
+
+  rb_node_aggregate_bound(tree, split->left, lo, true, left, tmp);
+  rb_node_aggregate_bound(tree, split->right, hi, false, right, tmp);
+  tree->augment.compute(out, split->data, left, right);
+  return 0;
 }
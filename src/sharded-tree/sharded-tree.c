@@ -0,0 +1,380 @@
+/**
+ * @file sharded-tree.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "sharded-tree.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sharded-tree.inc.h"
+
+// --- Constructor and Destructor ---
+
+// Frees a tree whose first created shards were initialized
+static void sharded_free(ShardedTree tree, size_t created) {
+  for (size_t i = 0; i < created; i++) {
+    rb_delete(tree->shards[i].tree);
+    pthread_mutex_destroy(&tree->shards[i].lock);
+  }
+  free(tree->shards);
+  free(tree->bounds);
+  free(tree);
+}
+
+ShardedTree sharded_new(size_t size, size_t shard_count, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  if (shard_count == 0) {
+    return NULL;
+  }
+
+  ShardedTree tree = malloc(sizeof(struct _ShardedTree));
+  if (!tree) {
+    return NULL;
+  }
+
+  tree->shards = aligned_alloc(SHARDED_CACHE_LINE, shard_count * sizeof(struct shard));
+  tree->bounds = malloc(shard_count * size);  // shard_count - 1 bounds, one more keeps the size non-zero
+  if (!tree->shards || !tree->bounds) {
+    sharded_free(tree, 0);
+    return NULL;
+  }
+
+  for (size_t i = 0; i < shard_count; i++) {
+    tree->shards[i].tree = rb_new(size, cmp, del);
+    if (!tree->shards[i].tree) {
+      sharded_free(tree, i);
+      return NULL;
+    }
+    pthread_mutex_init(&tree->shards[i].lock, NULL);
+  }
+
+  pthread_rwlock_init(&tree->bounds_lock, NULL);
+  tree->shard_count = shard_count;
+  tree->bound_count = 0;
+  atomic_init(&tree->size, 0);
+  atomic_flag_clear(&tree->rebalancing);
+  tree->rebalances = 0;
+  tree->data_size = size;
+  tree->compare = cmp;
+  tree->delete_data = del;
+
+  return tree;
+}
+
+void sharded_delete(ShardedTree tree) {
+  if (!tree) {
+    return;
+  }
+
+  pthread_rwlock_destroy(&tree->bounds_lock);
+  sharded_free(tree, tree->shard_count);
+}
+
+// --- Routing ---
+
+// Index of the shard whose range holds the key, the number of set bounds not above it
+static size_t sharded_route(ShardedTree tree, const void* key) {
+  size_t lo = 0;
+  size_t hi = tree->bound_count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (tree->compare(tree->bounds + mid * tree->data_size, key) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// The bounds cannot move once the shard is locked, so the read lock is only held for the routing
+static struct shard* sharded_lock_shard(ShardedTree tree, const void* key, size_t* index) {
+  pthread_rwlock_rdlock(&tree->bounds_lock);
+  *index = sharded_route(tree, key);
+  struct shard* shard = &tree->shards[*index];
+  pthread_mutex_lock(&shard->lock);
+  pthread_rwlock_unlock(&tree->bounds_lock);
+  return shard;
+}
+
+static void sharded_lock_all(ShardedTree tree) {
+  pthread_rwlock_wrlock(&tree->bounds_lock);
+  for (size_t i = 0; i < tree->shard_count; i++) {
+    pthread_mutex_lock(&tree->shards[i].lock);
+  }
+}
+
+static void sharded_unlock_all(ShardedTree tree) {
+  for (size_t i = 0; i < tree->shard_count; i++) {
+    pthread_mutex_unlock(&tree->shards[i].lock);
+  }
+  pthread_rwlock_unlock(&tree->bounds_lock);
+}
+
+// Bounds are copies of the smallest key of the shard after them, or of the next non-empty one, so that they never
+// route a present key away from its shard. Requires every lock.
+static void sharded_update_bounds(ShardedTree tree) {
+  const void* first = NULL;
+  tree->bound_count = 0;
+  for (size_t i = tree->shard_count - 1; i > 0; i--) {
+    RBNode node = rb_first(tree->shards[i].tree);
+    if (node != NULL) {
+      first = rb_node_get_data(node);
+      if (tree->bound_count == 0) tree->bound_count = i;
+    }
+    if (first != NULL) memcpy(tree->bounds + (i - 1) * tree->data_size, first, tree->data_size);
+  }
+}
+
+// --- Getters ---
+
+size_t sharded_get_size(ShardedTree tree) { return atomic_load(&tree->size); }
+
+size_t sharded_get_shard_count(ShardedTree tree) { return tree->shard_count; }
+
+size_t sharded_get_shard_size(ShardedTree tree, size_t shard) {
+  if (shard >= tree->shard_count) {
+    return 0;
+  }
+
+  pthread_mutex_lock(&tree->shards[shard].lock);
+  size_t size = rb_get_size(tree->shards[shard].tree);
+  pthread_mutex_unlock(&tree->shards[shard].lock);
+  return size;
+}
+
+size_t sharded_get_rebalances(ShardedTree tree) {
+  pthread_rwlock_rdlock(&tree->bounds_lock);
+  size_t rebalances = tree->rebalances;
+  pthread_rwlock_unlock(&tree->bounds_lock);
+  return rebalances;
+}
+
+// Routing is monotonic, so every key of a shard routes to it when its smallest and largest ones do
+bool sharded_is_valid(ShardedTree tree) {
+  size_t total = 0;
+  for (size_t i = 0; i < tree->shard_count; i++) {
+    RBTree shard = tree->shards[i].tree;
+    if (!rb_is_valid(shard)) return false;
+    if (rb_get_size(shard) == 0) continue;
+    if (sharded_route(tree, rb_node_get_data(rb_first(shard))) != i) return false;
+    if (sharded_route(tree, rb_node_get_data(rb_last(shard))) != i) return false;
+    total += rb_get_size(shard);
+  }
+  return total == atomic_load(&tree->size);
+}
+
+// --- Rebalancing ---
+
+// Shard i should hold the elements of rank start(i) to start(i + 1) excluded
+static size_t sharded_start(ShardedTree tree, size_t total, size_t shard) { return total * shard / tree->shard_count; }
+
+static size_t sharded_rank_shard(ShardedTree tree, size_t total, size_t rank) {
+  size_t shard = rank * tree->shard_count / total;
+  while (shard + 1 < tree->shard_count && sharded_start(tree, total, shard + 1) <= rank) shard++;
+  while (sharded_start(tree, total, shard) > rank) shard--;
+  return shard;
+}
+
+// The copy is added before the original is popped, a failed allocation leaves the element where it was
+static int sharded_move(RBTree from, RBTree to, bool largest, void* scratch) {
+  RBNode node = largest ? rb_last(from) : rb_first(from);
+  int error = rb_add(to, rb_node_get_data(node));
+  if (error) return error;
+  if (largest) {
+    rb_pop_max(from, scratch);  // the data now belongs to the destination shard
+  } else {
+    rb_pop_min(from, scratch);
+  }
+  return 0;
+}
+
+// Every element goes straight to the shard its rank falls in. From the last shard to the first, the largest elements
+// of each shard that belong further right are moved out, the rank of a shard's largest element being the number of
+// elements in the shards after it subtracted from the total. Then from the first shard to the last, the smallest
+// elements that belong further left are moved out. A shard never both receives and sends elements on the same side,
+// so each pass only sees elements that have not moved yet, and the shards stay ordered after every move.
+static int sharded_repartition(ShardedTree tree, void* scratch) {
+  size_t total = 0;
+  for (size_t i = 0; i < tree->shard_count; i++) total += rb_get_size(tree->shards[i].tree);
+  if (total == 0) return 0;
+
+  size_t after = 0;
+  for (size_t i = tree->shard_count; i-- > 0;) {
+    RBTree shard = tree->shards[i].tree;
+    size_t moved = 0;
+    while (rb_get_size(shard) > 0) {
+      size_t target = sharded_rank_shard(tree, total, total - 1 - (after + moved));
+      if (target <= i) break;
+      int error = sharded_move(shard, tree->shards[target].tree, true, scratch);
+      if (error) return error;
+      moved++;
+    }
+    after += rb_get_size(shard) + moved;
+  }
+
+  size_t before = 0;
+  for (size_t i = 0; i < tree->shard_count; i++) {
+    RBTree shard = tree->shards[i].tree;
+    while (rb_get_size(shard) > 0) {
+      size_t target = sharded_rank_shard(tree, total, before);
+      if (target >= i) break;
+      int error = sharded_move(shard, tree->shards[target].tree, false, scratch);
+      if (error) return error;
+      before++;
+    }
+    before += rb_get_size(shard);
+  }
+
+  return 0;
+}
+
+int sharded_rebalance(ShardedTree tree) {
+  void* scratch = malloc(tree->data_size);
+  if (!scratch) return ENOMEM;
+
+  sharded_lock_all(tree);
+  int error = sharded_repartition(tree, scratch);
+  sharded_update_bounds(tree);
+  tree->rebalances++;
+  sharded_unlock_all(tree);
+
+  free(scratch);
+  return error;
+}
+
+// --- Insertion ---
+
+int sharded_add(ShardedTree tree, const void* data) {
+  size_t index;
+  struct shard* shard = sharded_lock_shard(tree, data, &index);
+  size_t size = rb_get_size(shard->tree);
+  int error = rb_add(shard->tree, data);
+  size_t shard_size = rb_get_size(shard->tree);
+  pthread_mutex_unlock(&shard->lock);
+  if (error || shard_size == size) return error;
+
+  // a single thread rebalances, the others keep adding to the skewed shard meanwhile
+  size_t total = atomic_fetch_add(&tree->size, 1) + 1;
+  if (shard_size > 2 * (total / tree->shard_count) + SHARDED_MIN_SKEW &&
+      !atomic_flag_test_and_set(&tree->rebalancing)) {
+    sharded_rebalance(tree);  // on ENOMEM the tree stays valid, a later add retries
+    atomic_flag_clear(&tree->rebalancing);
+  }
+  return 0;
+}
+
+// --- Deletion ---
+
+bool sharded_remove(ShardedTree tree, const void* data) {
+  size_t index;
+  struct shard* shard = sharded_lock_shard(tree, data, &index);
+
+  // The smallest key of a shard is copied into the bound before it, which must stay comparable once the data is
+  // deleted: such a removal locks everything and replaces the bound right away
+  if (index == 0 || tree->compare(tree->bounds + (index - 1) * tree->data_size, data) != 0) {
+    int size = rb_get_size(shard->tree);
+    rb_remove(shard->tree, data);
+    bool removed = rb_get_size(shard->tree) < size;
+    pthread_mutex_unlock(&shard->lock);
+    if (removed) atomic_fetch_sub(&tree->size, 1);
+    return removed;
+  }
+  pthread_mutex_unlock(&shard->lock);
+
+  sharded_lock_all(tree);
+  RBTree bound_shard = tree->shards[sharded_route(tree, data)].tree;
+  int size = rb_get_size(bound_shard);
+  rb_remove(bound_shard, data);
+  bool removed = rb_get_size(bound_shard) < size;
+  sharded_update_bounds(tree);
+  sharded_unlock_all(tree);
+
+  if (removed) atomic_fetch_sub(&tree->size, 1);
+  return removed;
+}
+
+// --- Search ---
+
+bool sharded_find_data(ShardedTree tree, const void* data, void* out) {
+  size_t index;
+  struct shard* shard = sharded_lock_shard(tree, data, &index);
+  void* found = rb_find_data(shard->tree, data);
+  if (found != NULL && out != NULL) memcpy(out, found, tree->data_size);
+  pthread_mutex_unlock(&shard->lock);
+  return found != NULL;
+}
+
+static RBNode sharded_successor(ShardedTree tree, RBTree shard, const void* after) {
+  RBNode node = rb_get_root(shard);
+  RBNode successor = NULL;
+  while (node != NULL) {
+    if (tree->compare(rb_node_get_data(node), after) > 0) {
+      successor = node;
+      node = rb_node_get_left(node);
+    } else {
+      node = rb_node_get_right(node);
+    }
+  }
+  return successor;
+}
+
+bool sharded_next(ShardedTree tree, const void* after, void* out) {
+  bool found = false;
+
+  pthread_rwlock_rdlock(&tree->bounds_lock);
+  for (size_t i = after ? sharded_route(tree, after) : 0; i < tree->shard_count && !found; i++) {
+    struct shard* shard = &tree->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    RBNode node = after ? sharded_successor(tree, shard->tree, after) : rb_first(shard->tree);
+    if (node != NULL) {
+      memcpy(out, rb_node_get_data(node), tree->data_size);
+      found = true;
+    }
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&tree->bounds_lock);
+
+  return found;
+}
+
+static size_t sharded_visit(ShardedTree tree, RBNode node, const void* lo, const void* hi,
+                            void (*func)(const void* data, void* arg), void* arg) {
+  if (node == NULL) {
+    return 0;
+  }
+
+  const void* data = rb_node_get_data(node);
+  bool above_lo = lo == NULL || tree->compare(data, lo) >= 0;
+  bool below_hi = hi == NULL || tree->compare(data, hi) <= 0;
+  size_t count = 0;
+  if (above_lo) count += sharded_visit(tree, rb_node_get_left(node), lo, hi, func, arg);
+  if (above_lo && below_hi) {
+    func(data, arg);
+    count++;
+  }
+  if (below_hi) count += sharded_visit(tree, rb_node_get_right(node), lo, hi, func, arg);
+  return count;
+}
+
+size_t sharded_range(ShardedTree tree, const void* lo, const void* hi, void (*func)(const void* data, void* arg),
+                     void* arg) {
+  size_t count = 0;
+
+  pthread_rwlock_rdlock(&tree->bounds_lock);
+  size_t first = lo ? sharded_route(tree, lo) : 0;
+  size_t last = hi ? sharded_route(tree, hi) : tree->shard_count - 1;
+  for (size_t i = first; i <= last; i++) {
+    struct shard* shard = &tree->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    count += sharded_visit(tree, rb_get_root(shard->tree), lo, hi, func, arg);
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&tree->bounds_lock);
+
+  return count;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file sharded-tree.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief Range-sharded ordered container type.
+ *
+ * The key space is split into consecutive ranges, each held by its own red-black tree behind its own lock, so writers
+ * working on different ranges do not serialize. When a shard grows much larger than the average, the boundaries are
+ * moved so every shard holds about the same number of elements again.
+ *
+ * All operations except sharded_delete and sharded_is_valid may be called concurrently from any number of threads.
+ */
+typedef struct _ShardedTree* ShardedTree;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new sharded tree.
+ * Every element first goes to the first shard, the others are filled by the first rebalancing.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param shard_count Number of shards, at least 1.
+ * @param cmp Comparison function for the data.
+ * @param del Deletion function for the data.
+ * @return The newly created sharded tree, or NULL if it could not be allocated.
+ */
+extern ShardedTree sharded_new(size_t size, size_t shard_count, int (*cmp)(const void*, const void*),
+                               void (*del)(void*));
+
+/**
+ * @brief Delete a sharded tree, freeing all associated memory.
+ * Must not run concurrently with any other operation on the tree.
+ *
+ * @param tree The sharded tree to be deleted.
+ */
+extern void sharded_delete(ShardedTree tree);
+
+// --- Getters ---
+
+/**
+ * @brief Get the number of elements in the sharded tree.
+ *
+ * @param tree The sharded tree.
+ * @return The number of elements, exact only when no operation is in progress.
+ */
+extern size_t sharded_get_size(ShardedTree tree);
+
+/**
+ * @brief Get the number of shards of the sharded tree.
+ *
+ * @param tree The sharded tree.
+ * @return The number of shards.
+ */
+extern size_t sharded_get_shard_count(ShardedTree tree);
+
+/**
+ * @brief Get the number of elements held by one shard of the sharded tree.
+ *
+ * @param tree The sharded tree.
+ * @param shard Index of the shard, shards are ordered by the keys they hold.
+ * @return The number of elements of the shard, 0 if there is no such shard.
+ */
+extern size_t sharded_get_shard_size(ShardedTree tree, size_t shard);
+
+/**
+ * @brief Get the number of times the shard boundaries were moved since the tree was created.
+ *
+ * @param tree The sharded tree.
+ * @return The number of rebalancings.
+ */
+extern size_t sharded_get_rebalances(ShardedTree tree);
+
+/**
+ * @brief Check if the sharded tree is valid (every shard is a valid red-black tree holding only keys of its range,
+ * and the shards are ordered).
+ * Must not run concurrently with any other operation on the tree.
+ *
+ * @param tree The sharded tree to be checked.
+ * @return true if the tree is valid, false otherwise.
+ */
+extern bool sharded_is_valid(ShardedTree tree);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the sharded tree, nothing is done if it is already present.
+ * May rebalance the shards afterwards if the one the data went to became too large.
+ *
+ * @param tree The sharded tree where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ * @return 0 on success, ENOMEM if no node could be allocated, in which case the tree is left unchanged.
+ */
+extern int sharded_add(ShardedTree tree, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove data from the sharded tree.
+ *
+ * @param tree The sharded tree from which data will be removed.
+ * @param data Pointer to the data to be removed.
+ * @return true if the data was removed, false if it was not present.
+ */
+extern bool sharded_remove(ShardedTree tree, const void* data);
+
+// --- Rebalancing ---
+
+/**
+ * @brief Move the shard boundaries so every shard holds the same number of elements, give or take one.
+ * Blocks every other operation while elements move, each element moving at most once.
+ *
+ * @param tree The sharded tree.
+ * @return 0 on success, ENOMEM if an element could not be moved, in which case the tree is valid but some shards may
+ * still be unbalanced.
+ */
+extern int sharded_rebalance(ShardedTree tree);
+
+// --- Search ---
+
+/**
+ * @brief Find data in the sharded tree.
+ *
+ * @param tree The sharded tree to search.
+ * @param data Pointer to the data to search for.
+ * @param out Buffer receiving a copy of the found data, may be NULL.
+ * @return true if the data was found, false otherwise.
+ */
+extern bool sharded_find_data(ShardedTree tree, const void* data, void* out);
+
+/**
+ * @brief Find the smallest data of the sharded tree greater than a given one, crossing shard boundaries.
+ * Calling it repeatedly from NULL iterates over the tree in order.
+ *
+ * @param tree The sharded tree to search.
+ * @param after Pointer to the data to start after, NULL to get the smallest data of the tree.
+ * @param out Buffer receiving a copy of the found data.
+ * @return true if such data was found, false if there is none.
+ */
+extern bool sharded_next(ShardedTree tree, const void* after, void* out);
+
+/**
+ * @brief Call a function on every data of the sharded tree between two bounds (both included), in order.
+ * Shards are locked one at a time while their data is visited and the boundaries cannot move during the scan, so
+ * concurrent writers may or may not be seen in shards not yet reached. The function must not use the tree.
+ *
+ * @param tree The sharded tree.
+ * @param lo Lowest data visited, NULL for no lower bound.
+ * @param hi Highest data visited, NULL for no upper bound.
+ * @param func Function called on each data.
+ * @param arg Argument passed to the function along with the data.
+ * @return The number of data visited.
+ */
+extern size_t sharded_range(ShardedTree tree, const void* lo, const void* hi, void (*func)(const void* data, void* arg),
+                            void* arg);
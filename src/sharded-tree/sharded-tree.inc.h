@@ -0,0 +1,42 @@
+/**
+ * @file sharded-tree.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "../red-black-tree/red-black-tree.h"
+#include "sharded-tree.h"
+
+#define SHARDED_CACHE_LINE 64
+#define SHARDED_MIN_SKEW 64  // elements a shard may hold above twice the average before the boundaries move
+
+// Each shard sits on its own cache lines, so threads locking neighbouring shards do not share them
+struct shard {
+  _Alignas(SHARDED_CACHE_LINE) pthread_mutex_t lock;
+  RBTree tree;
+};
+
+// Shard i holds the keys k with bounds[i - 1] <= k < bounds[i]. Only the first bound_count bounds are set, the shards
+// after shard bound_count are empty and every key above the last bound goes to shard bound_count.
+// Operations read the bounds under bounds_lock and release it once their shard is locked. Rebalancing takes it for
+// writing, then every shard lock, so it waits for the operations in progress and routes nothing while elements move.
+struct _ShardedTree {
+  struct shard* shards;
+  size_t shard_count;
+  char* bounds;
+  size_t bound_count;
+  pthread_rwlock_t bounds_lock;
+  atomic_size_t size;
+  atomic_flag rebalancing;  // set while a rebalancing triggered by an add is pending, so only one thread waits for it
+  size_t rebalances;
+  size_t data_size;
+  int (*compare)(const void* a, const void* b);
+  void (*delete_data)(void* data);
+};
@@ -0,0 +1,400 @@
+/**
+ * @file skip-list.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "skip-list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "skip-list.inc.h"
+
+// Lock-free skip list from Herlihy & Shavit, "The Art of Multiprocessor Programming", chapter 14.4
+// with Fraser's insert/remove handshake so a node is only retired once neither thread can link it anymore
+// see: https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf
+
+#define MARK ((uintptr_t)1)
+#define NODE_INSERTED 1
+#define NODE_REMOVED 2
+#define RECLAIM_THRESHOLD 64
+
+static inline SkipListNode get_node(uintptr_t link) { return (SkipListNode)(link & ~MARK); }
+
+static inline bool is_marked(uintptr_t link) { return (link & MARK) != 0; }
+
+static inline void* node_data(SkipListNode node) { return (void*)(node->next + node->level); }
+
+static int random_level(void) {
+  static _Thread_local uint64_t state = 0;
+  if (state == 0) {
+    state = (uint64_t)(uintptr_t)&state ^ (uint64_t)time(NULL) ^ 0x9E3779B97F4A7C15ULL;
+  }
+  // xorshift64, one coin flip per bit
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  int level = 1 + __builtin_ctzll(state | (1ULL << (SKIPLIST_MAX_LEVEL - 1)));
+  return level;
+}
+
+// --- Constructor and Destructor ---
+
+static SkipListNode skiplist_node_new(const void* data, size_t size, int level) {
+  SkipListNode node = malloc(sizeof(struct _SkipListNode) + level * sizeof(uintptr_t) + size);
+  if (!node) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  node->retire_next = NULL;
+  node->retire_epoch = 0;
+  atomic_init(&node->state, 0);
+  node->level = level;
+  for (int i = 0; i < level; i++) {
+    atomic_init(&node->next[i], 0);
+  }
+  if (data) memcpy(node_data(node), data, size);
+  return node;
+}
+
+static void delete_node(SkipListNode node, void del(void*)) {
+  if (del) del(node_data(node));
+  free(node);
+}
+
+static void release_record(void* record) { atomic_store(&((EpochRecord)record)->owned, false); }
+
+SkipList skiplist_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  SkipList list = malloc(sizeof(struct _SkipList));
+  if (!list) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+
+  list->head = skiplist_node_new(NULL, 0, SKIPLIST_MAX_LEVEL);
+  list->data_size = size;
+  list->compare = cmp;
+  list->delete_data = del;
+  atomic_init(&list->level, 1);
+  atomic_init(&list->size, 0);
+  atomic_init(&list->epoch, 0);
+  atomic_init(&list->records, NULL);
+  if (pthread_key_create(&list->record_key, release_record) != 0) {
+    perror("Out of thread-specific keys");
+    exit(EXIT_FAILURE);
+  }
+
+  return list;
+}
+
+void skiplist_delete(SkipList list) {
+  if (!list) {
+    return;
+  }
+
+  pthread_key_delete(list->record_key);
+
+  EpochRecord record = atomic_load(&list->records);
+  while (record != NULL) {
+    EpochRecord next_record = record->next;
+    SkipListNode node = record->limbo_head;
+    while (node != NULL) {
+      SkipListNode next_node = node->retire_next;
+      delete_node(node, list->delete_data);
+      node = next_node;
+    }
+    free(record);
+    record = next_record;
+  }
+
+  SkipListNode node = get_node(atomic_load(&list->head->next[0]));
+  while (node != NULL) {
+    SkipListNode next_node = get_node(atomic_load(&node->next[0]));
+    delete_node(node, list->delete_data);
+    node = next_node;
+  }
+  free(list->head);
+  free(list);
+}
+
+// --- Epoch-Based Reclamation ---
+// A node retired while the global epoch is e can only still be referenced by threads that entered at epoch e or
+// earlier. The global epoch only advances once every active thread has caught up with it, so once it reaches e + 2
+// all of those threads have left and the node can be freed.
+
+static EpochRecord epoch_record(SkipList list) {
+  EpochRecord record = pthread_getspecific(list->record_key);
+  if (record != NULL) return record;
+
+  for (record = atomic_load(&list->records); record != NULL; record = record->next) {
+    bool expected = false;
+    if (atomic_compare_exchange_strong(&record->owned, &expected, true)) break;
+  }
+
+  if (record == NULL) {
+    record = malloc(sizeof(struct _EpochRecord));
+    if (!record) {
+      perror("Out of memory");
+      exit(EXIT_FAILURE);
+    }
+    atomic_init(&record->owned, true);
+    atomic_init(&record->active, false);
+    atomic_init(&record->epoch, 0);
+    record->limbo_head = NULL;
+    record->limbo_tail = NULL;
+    record->limbo_count = 0;
+    record->next = atomic_load(&list->records);
+    while (!atomic_compare_exchange_weak(&list->records, &record->next, record));
+  }
+
+  pthread_setspecific(list->record_key, record);
+  return record;
+}
+
+static void epoch_reclaim(SkipList list, EpochRecord record) {
+  uint64_t epoch = atomic_load(&list->epoch);
+  while (record->limbo_head != NULL && record->limbo_head->retire_epoch + 2 <= epoch) {
+    SkipListNode node = record->limbo_head;
+    record->limbo_head = node->retire_next;
+    record->limbo_count--;
+    delete_node(node, list->delete_data);
+  }
+  if (record->limbo_head == NULL) record->limbo_tail = NULL;
+}
+
+static void epoch_try_advance(SkipList list) {
+  uint64_t epoch = atomic_load(&list->epoch);
+  for (EpochRecord record = atomic_load(&list->records); record != NULL; record = record->next) {
+    if (atomic_load(&record->active) && atomic_load(&record->epoch) != epoch) return;
+  }
+  atomic_compare_exchange_strong(&list->epoch, &epoch, epoch + 1);
+}
+
+static EpochRecord epoch_enter(SkipList list) {
+  EpochRecord record = epoch_record(list);
+  atomic_store(&record->active, true);
+  atomic_store(&record->epoch, atomic_load(&list->epoch));
+  return record;
+}
+
+static void epoch_exit(EpochRecord record) { atomic_store(&record->active, false); }
+
+// node must already be unreachable from the list
+static void epoch_retire(SkipList list, EpochRecord record, SkipListNode node) {
+  node->retire_epoch = atomic_load(&list->epoch);
+  node->retire_next = NULL;
+  if (record->limbo_tail != NULL) {
+    record->limbo_tail->retire_next = node;
+  } else {
+    record->limbo_head = node;
+  }
+  record->limbo_tail = node;
+
+  if (++record->limbo_count >= RECLAIM_THRESHOLD) {
+    epoch_try_advance(list);
+    epoch_reclaim(list, record);
+  }
+}
+
+// --- Getters ---
+
+int skiplist_get_size(SkipList list) { return atomic_load(&list->size); }
+
+bool skiplist_is_valid(SkipList list) {
+  for (int i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
+    SkipListNode below = list->head;
+    SkipListNode prev = NULL;
+    for (SkipListNode node = get_node(atomic_load(&list->head->next[i])); node != NULL;
+         node = get_node(atomic_load(&node->next[i]))) {
+      if (is_marked(atomic_load(&node->next[i]))) return false;
+      if (prev != NULL && list->compare(node_data(prev), node_data(node)) >= 0) return false;
+      while (below != NULL && below != node) below = get_node(atomic_load(&below->next[0]));
+      if (below == NULL) return false;  // not linked at level 0
+      prev = node;
+    }
+  }
+  return true;
+}
+
+// --- Search ---
+
+// Fills preds and succs with the nodes surrounding data at every level, unlinking marked nodes on the way
+static bool skiplist_find(SkipList list, const void* data, SkipListNode* preds, SkipListNode* succs) {
+  SkipListNode pred;
+  int cmp;
+retry:
+  pred = list->head;
+  cmp = 1;
+  for (int i = SKIPLIST_MAX_LEVEL - 1; i >= 0; i--) {
+    if (i >= atomic_load(&list->level)) {
+      preds[i] = list->head;
+      succs[i] = NULL;
+      continue;
+    }
+
+    SkipListNode curr = get_node(atomic_load(&pred->next[i]));
+    cmp = 1;
+    while (curr != NULL) {
+      uintptr_t succ = atomic_load(&curr->next[i]);
+      while (is_marked(succ)) {
+        uintptr_t expected = (uintptr_t)curr;
+        if (!atomic_compare_exchange_strong(&pred->next[i], &expected, succ & ~MARK)) goto retry;
+        curr = get_node(succ);
+        if (curr == NULL) break;
+        succ = atomic_load(&curr->next[i]);
+      }
+      if (curr == NULL) break;
+
+      cmp = list->compare(node_data(curr), data);
+      if (cmp >= 0) break;
+      pred = curr;
+      curr = get_node(succ);
+    }
+    preds[i] = pred;
+    succs[i] = curr;
+  }
+  return succs[0] != NULL && cmp == 0;
+}
+
+bool skiplist_find_data(SkipList list, const void* data, void* out) {
+  EpochRecord record = epoch_enter(list);
+
+  // wait-free traversal, marked nodes are skipped instead of unlinked
+  SkipListNode pred = list->head;
+  SkipListNode curr = NULL;
+  int cmp = 1;
+  for (int i = atomic_load(&list->level) - 1; i >= 0; i--) {
+    curr = get_node(atomic_load(&pred->next[i]));
+    while (curr != NULL) {
+      uintptr_t succ = atomic_load(&curr->next[i]);
+      while (curr != NULL && is_marked(succ)) {
+        curr = get_node(succ);
+        if (curr != NULL) succ = atomic_load(&curr->next[i]);
+      }
+      if (curr == NULL) break;
+
+      cmp = list->compare(node_data(curr), data);
+      if (cmp >= 0) break;
+      pred = curr;
+      curr = get_node(succ);
+    }
+  }
+
+  bool found = curr != NULL && cmp == 0;
+  if (found && out != NULL) memcpy(out, node_data(curr), list->data_size);
+
+  epoch_exit(record);
+  return found;
+}
+
+// --- Insertion ---
+
+bool skiplist_add(SkipList list, const void* data) {
+  SkipListNode preds[SKIPLIST_MAX_LEVEL];
+  SkipListNode succs[SKIPLIST_MAX_LEVEL];
+  int level = random_level();
+  SkipListNode node = NULL;
+
+  EpochRecord record = epoch_enter(list);
+
+  int list_level = atomic_load(&list->level);
+  while (list_level < level && !atomic_compare_exchange_weak(&list->level, &list_level, level));
+
+  for (;;) {
+    if (skiplist_find(list, data, preds, succs)) {
+      epoch_exit(record);
+      free(node);
+      return false;
+    }
+
+    if (node == NULL) node = skiplist_node_new(data, list->data_size, level);
+    for (int i = 0; i < level; i++) {
+      atomic_store(&node->next[i], (uintptr_t)succs[i]);
+    }
+
+    uintptr_t expected = (uintptr_t)succs[0];
+    if (atomic_compare_exchange_strong(&preds[0]->next[0], &expected, (uintptr_t)node)) break;
+  }
+  atomic_fetch_add(&list->size, 1);
+
+  // the node is in the set from now on, the upper levels are only shortcuts
+  for (int i = 1; i < level; i++) {
+    for (;;) {
+      uintptr_t next = atomic_load(&node->next[i]);
+      if (is_marked(next)) goto linked;
+      if (get_node(next) != succs[i] &&
+          !atomic_compare_exchange_strong(&node->next[i], &next, (uintptr_t)succs[i])) {
+        goto linked;  // only a concurrent remove can change it
+      }
+
+      uintptr_t expected = (uintptr_t)succs[i];
+      if (atomic_compare_exchange_strong(&preds[i]->next[i], &expected, (uintptr_t)node)) break;
+
+      skiplist_find(list, data, preds, succs);
+      if (succs[0] != node) goto linked;  // removed concurrently
+    }
+  }
+
+linked:
+  // a concurrent remove may have missed the levels linked after its own cleanup
+  if (is_marked(atomic_load(&node->next[0]))) skiplist_find(list, data, preds, succs);
+  if (atomic_fetch_or(&node->state, NODE_INSERTED) & NODE_REMOVED) epoch_retire(list, record, node);
+
+  epoch_exit(record);
+  return true;
+}
+
+// --- Deletion ---
+
+bool skiplist_remove(SkipList list, const void* data) {
+  SkipListNode preds[SKIPLIST_MAX_LEVEL];
+  SkipListNode succs[SKIPLIST_MAX_LEVEL];
+
+  EpochRecord record = epoch_enter(list);
+
+  if (!skiplist_find(list, data, preds, succs)) {
+    epoch_exit(record);
+    return false;
+  }
+  SkipListNode node = succs[0];
+
+  for (int i = node->level - 1; i > 0; i--) {
+    uintptr_t next = atomic_load(&node->next[i]);
+    while (!is_marked(next) && !atomic_compare_exchange_weak(&node->next[i], &next, next | MARK));
+  }
+
+  // marking the bottom level is the linearization point, only one remover can win it
+  uintptr_t next = atomic_load(&node->next[0]);
+  for (;;) {
+    if (is_marked(next)) {
+      epoch_exit(record);
+      return false;
+    }
+    if (atomic_compare_exchange_weak(&node->next[0], &next, next | MARK)) break;
+  }
+  atomic_fetch_sub(&list->size, 1);
+
+  skiplist_find(list, data, preds, succs);  // physically unlink at every level
+  if (atomic_fetch_or(&node->state, NODE_REMOVED) & NODE_INSERTED) epoch_retire(list, record, node);
+
+  epoch_exit(record);
+  return true;
+}
+
+// --- Iteration ---
+
+void skiplist_foreach(SkipList list, void (*func)(const void* data, void* arg), void* arg) {
+  EpochRecord record = epoch_enter(list);
+
+  for (SkipListNode node = get_node(atomic_load(&list->head->next[0])); node != NULL;) {
+    uintptr_t next = atomic_load(&node->next[0]);
+    if (!is_marked(next)) func(node_data(node), arg);
+    node = get_node(next);
+  }
+
+  epoch_exit(record);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file skip-list.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief Lock-free skip list type.
+ *
+ * All operations except skiplist_delete and skiplist_is_valid may be called concurrently from any number of threads.
+ * Removed elements are reclaimed with epoch-based reclamation, so the deletion function of an element may run some
+ * time after its removal, on whichever thread reclaims it.
+ */
+typedef struct _SkipList* SkipList;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new skip list.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param cmp Comparison function for the data.
+ * @param del Deletion function for the data.
+ * @return The newly created skip list.
+ */
+extern SkipList skiplist_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*));
+
+/**
+ * @brief Delete a skip list, freeing all associated memory.
+ * Must not run concurrently with any other operation on the list.
+ *
+ * @param list The skip list to be deleted.
+ */
+extern void skiplist_delete(SkipList list);
+
+// --- Getters ---
+
+/**
+ * @brief Get the number of elements in the skip list.
+ *
+ * @param list The skip list.
+ * @return The number of elements, exact only when no operation is in progress.
+ */
+extern int skiplist_get_size(SkipList list);
+
+/**
+ * @brief Check if the skip list is valid (every level sorted and a sublist of the level below).
+ * Must not run concurrently with any other operation on the list.
+ *
+ * @param list The skip list to be checked.
+ * @return true if the list is valid, false otherwise.
+ */
+extern bool skiplist_is_valid(SkipList list);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the skip list.
+ *
+ * @param list The skip list where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ * @return true if the data was inserted, false if it was already present.
+ */
+extern bool skiplist_add(SkipList list, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove data from the skip list.
+ *
+ * @param list The skip list from which data will be removed.
+ * @param data Pointer to the data to be removed.
+ * @return true if this call removed the data, false if it was not present.
+ */
+extern bool skiplist_remove(SkipList list, const void* data);
+
+// --- Search ---
+
+/**
+ * @brief Find data in the skip list.
+ * Nodes may be reclaimed as soon as the call returns, so the found data is copied out instead of returned.
+ *
+ * @param list The skip list to search.
+ * @param data Pointer to the data to search for.
+ * @param out Buffer of the list's data size receiving a copy of the found data, may be NULL.
+ * @return true if the data was found, false otherwise.
+ */
+extern bool skiplist_find_data(SkipList list, const void* data, void* out);
+
+// --- Iteration ---
+
+/**
+ * @brief Call a function on every element of the skip list, in ascending order.
+ * Safe to use concurrently with updates, elements added or removed during the traversal may or may not be visited.
+ *
+ * @param list The skip list to traverse.
+ * @param func Function called with each element and the user argument.
+ * @param arg User argument passed to func.
+ */
+extern void skiplist_foreach(SkipList list, void (*func)(const void* data, void* arg), void* arg);
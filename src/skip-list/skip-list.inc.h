@@ -0,0 +1,50 @@
+/**
+ * @file skip-list.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SKIPLIST_MAX_LEVEL 32
+
+typedef struct _SkipListNode* SkipListNode;
+typedef struct _EpochRecord* EpochRecord;
+
+// Links are tagged pointers, the lowest bit marks the owning node as logically deleted at that level.
+struct _SkipListNode {
+  SkipListNode retire_next;
+  uint64_t retire_epoch;
+  atomic_int state;  // insert/remove handshake, the second of the two to finish retires the node
+  int level;
+  _Atomic(uintptr_t) next[];  // followed by the data, right after next[level - 1]
+};
+
+// Per-thread epoch-based reclamation state, registered once per thread and list, recycled after the thread exits.
+struct _EpochRecord {
+  EpochRecord next;
+  atomic_bool owned;
+  atomic_bool active;
+  _Atomic uint64_t epoch;
+  SkipListNode limbo_head;
+  SkipListNode limbo_tail;
+  size_t limbo_count;
+};
+
+struct _SkipList {
+  SkipListNode head;
+  size_t data_size;
+  int (*compare)(const void* a, const void* b);
+  void (*delete_data)(void* data);
+  atomic_int level;
+  atomic_int size;
+  _Atomic uint64_t epoch;
+  _Atomic(EpochRecord) records;
+  pthread_key_t record_key;
+};
@@ -0,0 +1,430 @@
+/**
+ * @file splay-tree.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "splay-tree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../min-max.h"
+#include "splay-tree.inc.h"
+
+// Splay trees can degenerate into long paths (sequential inserts build one), so nothing here recurses over the tree
+// Sleator & Tarjan, "Self-Adjusting Binary Search Trees" (1985)
+// see: https://www.cs.cmu.edu/~sleator/papers/self-adjusting.pdf
+
+// --- Constructor and Destructor ---
+
+static SplayNode splay_node_new(const void* data, size_t size) {
+  SplayNode node = malloc(offsetof(struct _TreeNode, data) + size);
+  if (!node) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+  node->left = NULL;
+  node->right = NULL;
+  memcpy(node->data, data, size);
+  return node;
+}
+
+SplayTree splay_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  SplayTree tree = malloc(sizeof(struct _SplayTree));
+  if (!tree) {
+    perror("Out of memory");
+    exit(EXIT_FAILURE);
+  }
+
+  tree->root = NULL;
+  tree->min = NULL;
+  tree->max = NULL;
+  tree->data_size = size;
+  tree->semi_splay = false;
+  tree->compare = cmp;
+  tree->delete_data = del;
+
+  return tree;
+}
+
+static void delete_node(SplayNode node, void del(void*), bool del_data) {
+  if (!node) {
+    return;
+  }
+
+  if (del && del_data) {
+    del(node->data);
+  }
+  free(node);
+}
+
+// rotates left children away until the node has none, then frees it and continues with its right child
+static void delete_all_nodes(SplayNode node, void del(void*)) {
+  while (node != NULL) {
+    if (node->left != NULL) {
+      SplayNode l_node = node->left;
+      node->left = l_node->right;
+      l_node->right = node;
+      node = l_node;
+    } else {
+      SplayNode r_node = node->right;
+      delete_node(node, del, true);
+      node = r_node;
+    }
+  }
+}
+
+void splay_delete(SplayTree tree) {
+  if (!tree) {
+    return;
+  }
+
+  delete_all_nodes(tree->root, tree->delete_data);
+  free(tree);
+}
+
+// --- Traversal ---
+
+struct node_stack {
+  SplayNode* nodes;
+  int* depths;
+  int size;
+  int capacity;
+};
+
+static void stack_push(struct node_stack* stack, SplayNode node, int depth) {
+  if (stack->size == stack->capacity) {
+    stack->capacity = stack->capacity ? 2 * stack->capacity : 64;
+    SplayNode* nodes = realloc(stack->nodes, stack->capacity * sizeof(SplayNode));
+    int* depths = realloc(stack->depths, stack->capacity * sizeof(int));
+    if (!nodes || !depths) {
+      perror("Out of memory");
+      exit(EXIT_FAILURE);
+    }
+    stack->nodes = nodes;
+    stack->depths = depths;
+  }
+  stack->nodes[stack->size] = node;
+  stack->depths[stack->size++] = depth;
+}
+
+static void stack_free(struct node_stack* stack) {
+  free(stack->nodes);
+  free(stack->depths);
+}
+
+// --- Getters ---
+
+SplayNode splay_get_root(SplayTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  return tree->root;
+}
+
+int splay_get_height(SplayTree tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+  return splay_node_get_height(tree->root);
+}
+
+int splay_node_get_height(SplayNode node) {
+  if (node == NULL) {
+    return 0;
+  }
+
+  struct node_stack stack = {0};
+  int height = 0;
+  stack_push(&stack, node, 1);
+  while (stack.size > 0) {
+    stack.size--;
+    SplayNode current = stack.nodes[stack.size];
+    int depth = stack.depths[stack.size];
+    height = MAX(height, depth);
+    if (current->left) stack_push(&stack, current->left, depth + 1);
+    if (current->right) stack_push(&stack, current->right, depth + 1);
+  }
+  stack_free(&stack);
+  return height;
+}
+
+int splay_get_size(SplayTree tree) {
+  if (tree->root == NULL) {
+    return 0;
+  }
+
+  struct node_stack stack = {0};
+  int size = 0;
+  stack_push(&stack, tree->root, 0);
+  while (stack.size > 0) {
+    SplayNode current = stack.nodes[--stack.size];
+    size++;
+    if (current->left) stack_push(&stack, current->left, 0);
+    if (current->right) stack_push(&stack, current->right, 0);
+  }
+  stack_free(&stack);
+  return size;
+}
+
+SplayNode splay_node_get_left(SplayNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->left;
+}
+
+SplayNode splay_node_get_right(SplayNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->right;
+}
+
+SplayNode splay_first(SplayTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  return tree->min;
+}
+
+SplayNode splay_last(SplayTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  return tree->max;
+}
+
+void* splay_node_get_data(SplayNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->data;
+}
+
+void splay_set_semi_splay(SplayTree tree, bool enabled) { tree->semi_splay = enabled; }
+
+bool splay_is_valid(SplayTree tree) {
+  struct node_stack stack = {0};
+  SplayNode current = tree->root;
+  SplayNode previous = NULL;
+  bool valid = true;
+
+  // in-order walk, every node must be strictly greater than the one before it
+  while (valid && (current != NULL || stack.size > 0)) {
+    while (current != NULL) {
+      stack_push(&stack, current, 0);
+      current = current->left;
+    }
+    current = stack.nodes[--stack.size];
+    if (previous == NULL) {
+      valid = current == tree->min;
+    } else if (tree->compare(previous->data, current->data) >= 0) {
+      valid = false;
+    }
+    previous = current;
+    current = current->right;
+  }
+  stack_free(&stack);
+
+  return valid && previous == tree->max;
+}
+
+// --- Splaying ---
+
+static SplayNode tree_get_min_node(SplayNode node) {
+  while (node->left != NULL) node = node->left;
+  return node;
+}
+
+static SplayNode tree_get_max_node(SplayNode node) {
+  while (node->right != NULL) node = node->right;
+  return node;
+}
+
+// Top-down splay: brings the node holding data, or the last node on its search path, to the root of the subtree.
+// With data NULL, bias < 0 splays the minimum and bias > 0 the maximum without calling the comparison function.
+// last_cmp receives the comparison of data with the returned root.
+static SplayNode splay(SplayTree tree, SplayNode node, const void* data, int bias, int* last_cmp) {
+  struct _TreeNode header;
+  header.left = NULL;
+  header.right = NULL;
+  SplayNode left_max = &header;   // largest node of the tree of nodes known to be smaller than data
+  SplayNode right_min = &header;  // smallest node of the tree of nodes known to be greater than data
+
+  int cmp = data ? tree->compare(data, node->data) : bias;
+  for (;;) {
+    if (cmp < 0) {
+      if (node->left == NULL) break;
+      int child_cmp = data ? tree->compare(data, node->left->data) : bias;
+      if (child_cmp < 0) {
+        SplayNode l_node = node->left;  // rotate right
+        node->left = l_node->right;
+        l_node->right = node;
+        node = l_node;
+        if (node->left == NULL) break;
+        child_cmp = data ? tree->compare(data, node->left->data) : bias;
+      }
+      right_min->left = node;  // link right
+      right_min = node;
+      node = node->left;
+      cmp = child_cmp;
+    } else if (cmp > 0) {
+      if (node->right == NULL) break;
+      int child_cmp = data ? tree->compare(data, node->right->data) : bias;
+      if (child_cmp > 0) {
+        SplayNode r_node = node->right;  // rotate left
+        node->right = r_node->left;
+        r_node->left = node;
+        node = r_node;
+        if (node->right == NULL) break;
+        child_cmp = data ? tree->compare(data, node->right->data) : bias;
+      }
+      left_max->right = node;  // link left
+      left_max = node;
+      node = node->right;
+      cmp = child_cmp;
+    } else {
+      break;
+    }
+  }
+
+  left_max->right = node->left;  // assemble
+  right_min->left = node->right;
+  node->left = header.right;
+  node->right = header.left;
+
+  if (last_cmp) *last_cmp = cmp;
+  return node;
+}
+
+// Only the zig-zig steps of the search path are rotated, which halves the depth of the nodes on that path without
+// bringing the found node all the way up. Zig-zag steps are walked through unchanged.
+static SplayNode semi_splay_find(SplayTree tree, const void* data) {
+  SplayNode* link = &tree->root;
+
+  while (*link != NULL) {
+    SplayNode node = *link;
+    int cmp = tree->compare(data, node->data);
+    if (cmp == 0) return node;
+
+    SplayNode child = cmp < 0 ? node->left : node->right;
+    if (child == NULL) return NULL;
+    int child_cmp = tree->compare(data, child->data);
+    if (child_cmp == 0) return child;
+
+    if ((cmp < 0) == (child_cmp < 0)) {
+      if (cmp < 0) {  // rotate right
+        node->left = child->right;
+        child->right = node;
+      } else {  // rotate left
+        node->right = child->left;
+        child->left = node;
+      }
+      *link = child;
+      link = cmp < 0 ? &child->left : &child->right;
+    } else {
+      link = child_cmp < 0 ? &child->left : &child->right;
+    }
+  }
+
+  return NULL;
+}
+
+// --- Insertion ---
+
+void splay_add(SplayTree tree, const void* data) {
+  if (tree->root == NULL) {
+    SplayNode new_node = splay_node_new(data, tree->data_size);
+    tree->root = new_node;
+    tree->min = new_node;
+    tree->max = new_node;
+    return;
+  }
+
+  int cmp;
+  SplayNode root = splay(tree, tree->root, data, 0, &cmp);
+  if (cmp == 0) {
+    tree->root = root;
+    return;  // data already in tree
+  }
+
+  SplayNode new_node = splay_node_new(data, tree->data_size);
+  if (cmp < 0) {
+    new_node->left = root->left;
+    new_node->right = root;
+    root->left = NULL;
+    if (new_node->left == NULL) tree->min = new_node;
+  } else {
+    new_node->right = root->right;
+    new_node->left = root;
+    root->right = NULL;
+    if (new_node->right == NULL) tree->max = new_node;
+  }
+  tree->root = new_node;
+}
+
+// --- Search ---
+
+SplayNode splay_find_node(SplayTree tree, const void* data) {
+  if (tree->root == NULL) return NULL;
+  if (tree->semi_splay) return semi_splay_find(tree, data);
+
+  int cmp;
+  tree->root = splay(tree, tree->root, data, 0, &cmp);
+  return cmp == 0 ? tree->root : NULL;
+}
+
+void* splay_find_data(SplayTree tree, const void* data) {
+  SplayNode node = splay_find_node(tree, data);
+  return node ? node->data : NULL;
+}
+
+// --- Deletion ---
+
+// Removes the root, joining its subtrees by splaying the maximum of the left one
+static void splay_remove_root(SplayTree tree, bool del_data) {
+  SplayNode old_root = tree->root;
+
+  if (old_root->left == NULL) {
+    tree->root = old_root->right;
+  } else {
+    tree->root = splay(tree, old_root->left, NULL, 1, NULL);
+    tree->root->right = old_root->right;
+  }
+
+  if (old_root == tree->min) tree->min = tree->root ? tree_get_min_node(tree->root) : NULL;
+  if (old_root == tree->max) tree->max = tree->root ? tree_get_max_node(tree->root) : NULL;
+  delete_node(old_root, tree->delete_data, del_data);
+}
+
+void splay_remove(SplayTree tree, const void* data) {
+  if (tree->root == NULL) return;
+
+  int cmp;
+  tree->root = splay(tree, tree->root, data, 0, &cmp);
+  if (cmp != 0) return;
+
+  splay_remove_root(tree, true);
+}
+
+bool splay_pop_min(SplayTree tree, void* out) {
+  if (tree->root == NULL) return false;
+
+  tree->root = splay(tree, tree->root, NULL, -1, NULL);
+  if (out != NULL) memcpy(out, tree->root->data, tree->data_size);
+  splay_remove_root(tree, out == NULL);
+  return true;
+}
+
+bool splay_pop_max(SplayTree tree, void* out) {
+  if (tree->root == NULL) return false;
+
+  tree->root = splay(tree, tree->root, NULL, 1, NULL);
+  if (out != NULL) memcpy(out, tree->root->data, tree->data_size);
+  splay_remove_root(tree, out == NULL);
+  return true;
+}
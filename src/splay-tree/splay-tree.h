@@ -0,0 +1,199 @@
+/**
+ * @file splay-tree.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief Splay tree type.
+ *
+ * Every access moves the accessed node to the root, so frequently used data stays near the top of the tree.
+ */
+typedef struct _SplayTree* SplayTree;
+
+/**
+ * @brief Splay tree node type.
+ */
+typedef struct _TreeNode* SplayNode;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new splay tree.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param cmp Comparison function for the data.
+ * @param del Deletion function for the data.
+ * @return The newly created splay tree.
+ */
+extern SplayTree splay_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*));
+
+/**
+ * @brief Delete a splay tree, freeing all associated memory.
+ *
+ * @param tree The splay tree to be deleted.
+ */
+extern void splay_delete(SplayTree tree);
+
+// --- Getters ---
+
+/**
+ * @brief Get the root node of the splay tree.
+ *
+ * @param tree The splay tree.
+ * @return The root node of the splay tree.
+ */
+extern SplayNode splay_get_root(SplayTree tree);
+
+/**
+ * @brief Get the height of the splay tree.
+ *
+ * @param tree The splay tree.
+ * @return The height of the tree.
+ */
+extern int splay_get_height(SplayTree tree);
+
+/**
+ * @brief Get the height of a given splay tree node, computed by walking its subtree.
+ *
+ * @param node The splay tree node.
+ * @return The height of the node.
+ */
+extern int splay_node_get_height(SplayNode node);
+
+/**
+ * @brief Get the size (number of nodes) of the splay tree.
+ *
+ * @param tree The splay tree.
+ * @return The size of the tree.
+ */
+extern int splay_get_size(SplayTree tree);
+
+/**
+ * @brief Get the left child of a given splay tree node.
+ *
+ * @param node The splay tree node.
+ * @return The left child of the node.
+ */
+extern SplayNode splay_node_get_left(SplayNode node);
+
+/**
+ * @brief Get the right child of a given splay tree node.
+ *
+ * @param node The splay tree node.
+ * @return The right child of the node.
+ */
+extern SplayNode splay_node_get_right(SplayNode node);
+
+/**
+ * @brief Get the node holding the smallest data of the splay tree, in constant time.
+ *
+ * @param tree The splay tree.
+ * @return The first node in order, or NULL if the tree is empty.
+ */
+extern SplayNode splay_first(SplayTree tree);
+
+/**
+ * @brief Get the node holding the largest data of the splay tree, in constant time.
+ *
+ * @param tree The splay tree.
+ * @return The last node in order, or NULL if the tree is empty.
+ */
+extern SplayNode splay_last(SplayTree tree);
+
+/**
+ * @brief Get the data stored in a given splay tree node.
+ *
+ * @param node The splay tree node.
+ * @return Pointer to the data stored in the node.
+ */
+extern void* splay_node_get_data(SplayNode node);
+
+/**
+ * @brief Enable or disable semi-splaying on reads.
+ * When enabled, splay_find_node and splay_find_data only apply the zig-zig rotations met on the search path instead
+ * of moving the found node to the root. Hot nodes still climb towards the root, with about half as many link writes
+ * per lookup. Insertions and removals always splay fully.
+ *
+ * @param tree The splay tree.
+ * @param enabled true to semi-splay on reads, false to fully splay (the default).
+ */
+extern void splay_set_semi_splay(SplayTree tree, bool enabled);
+
+/**
+ * @brief Check if the splay tree is valid (data in strictly ascending order).
+ *
+ * @param tree The splay tree to be checked.
+ * @return true if the tree is valid, false otherwise.
+ */
+extern bool splay_is_valid(SplayTree tree);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the splay tree.
+ *
+ * @param tree The splay tree where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ * @return true if insertion was successful, false otherwise.
+ */
+extern void splay_add(SplayTree tree, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove data from the splay tree.
+ *
+ * @param tree The splay tree from which data will be removed.
+ * @param data Pointer to the data to be removed.
+ * @return true if removal was successful, false otherwise.
+ */
+extern void splay_remove(SplayTree tree, const void* data);
+
+/**
+ * @brief Remove the smallest data from the splay tree without calling the comparison function.
+ *
+ * @param tree The splay tree from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller. If NULL, the deletion function is
+ * called on the data instead.
+ * @return true if data was removed, false if the tree was empty.
+ */
+extern bool splay_pop_min(SplayTree tree, void* out);
+
+/**
+ * @brief Remove the largest data from the splay tree without calling the comparison function.
+ *
+ * @param tree The splay tree from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller. If NULL, the deletion function is
+ * called on the data instead.
+ * @return true if data was removed, false if the tree was empty.
+ */
+extern bool splay_pop_max(SplayTree tree, void* out);
+
+// --- Search ---
+
+/**
+ * @brief Find a node in the splay tree containing the specified data.
+ *
+ * @param tree The splay tree to search.
+ * @param data Pointer to the data to search for.
+ * @return The node containing the data, or NULL if not found.
+ */
+extern SplayNode splay_find_node(SplayTree tree, const void* data);
+
+/**
+ * @brief Find data in the splay tree.
+ *
+ * @param tree The splay tree to search.
+ * @param data Pointer to the data to search for.
+ * @return Pointer to the found data, or NULL if not found.
+ */
+extern void* splay_find_data(SplayTree tree, const void* data);
@@ -0,0 +1,29 @@
+/**
+ * @file splay-tree.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct _TreeNode* SplayNode;
+
+struct _TreeNode {
+  SplayNode left;
+  SplayNode right;
+  char data[1];
+};
+
+struct _SplayTree {
+  SplayNode root;
+  SplayNode min;
+  SplayNode max;
+  size_t data_size;
+  bool semi_splay;
+  int (*compare)(const void* a, const void* b);
+  void (*delete_data)(void* data);
+};
@@ -0,0 +1,36 @@
+/**
+ * @file trace.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+// Static user-space tracing probes (USDT), compiled in when <sys/sdt.h> is available (systemtap-sdt-dev) and to
+// nothing otherwise. Every probe has a semaphore, set by the tracer while it is attached, so arguments that cost
+// something to compute can be skipped when nobody listens.
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define TRACE_PROBES 1
+#endif
+#endif
+
+#ifdef TRACE_PROBES
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define TRACE_SEMAPHORE(provider, name) \
+  unsigned short provider##_##name##_semaphore __attribute__((unused)) __attribute__((section(".probes")))
+#define TRACE_ACTIVE(provider, name) __builtin_expect(provider##_##name##_semaphore != 0, 0)
+#define TRACE2(provider, name, a, b) DTRACE_PROBE2(provider, name, a, b)
+#define TRACE3(provider, name, a, b, c) DTRACE_PROBE3(provider, name, a, b, c)
+#define TRACE4(provider, name, a, b, c, d) DTRACE_PROBE4(provider, name, a, b, c, d)
+#else
+#define TRACE_SEMAPHORE(provider, name) extern int provider##_##name##_unused_semaphore
+#define TRACE_ACTIVE(provider, name) 0
+#define TRACE2(provider, name, a, b) ((void)(a), (void)(b))
+#define TRACE3(provider, name, a, b, c) ((void)(a), (void)(b), (void)(c))
+#define TRACE4(provider, name, a, b, c, d) ((void)(a), (void)(b), (void)(c), (void)(d))
+#endif
@@ -0,0 +1,440 @@
+/**
+ * @file wavl-tree.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "wavl-tree.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../min-max.h"
+#include "wavl-tree.inc.h"
+
+// Every node has a rank, a missing child having rank -1. The rank difference between a node and each of its children
+// is 1 or 2 and leaves have rank 0. Without removals ranks are AVL heights minus one, removals only demote nodes and
+// stop after at most two rotations, which keeps the amortized rebalancing work per update constant.
+// see: Haeupler, Sen & Tarjan, "Rank-Balanced Trees" (2015), https://sidsen.azurewebsites.net/papers/rb-trees-talg.pdf
+//
+// Updates are iterative: the descent records the address of every link it follows, so rebalancing walks back up the
+// path without parent pointers and a rotation rewrites its parent link in place.
+
+// --- Constructor and Destructor ---
+
+static WAVLNode wavl_node_new(WAVLTree tree, const void* data) {
+  WAVLNode node = malloc(offsetof(struct _TreeNode, data) + tree->data_size);
+  if (!node) {
+    return NULL;
+  }
+  node->left = NULL;
+  node->right = NULL;
+  node->rank = 0;
+  memcpy(node->data, data, tree->data_size);
+  return node;
+}
+
+WAVLTree wavl_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*)) {
+  WAVLTree tree = malloc(sizeof(struct _WAVLTree));
+  if (!tree) {
+    return NULL;
+  }
+
+  tree->root = NULL;
+  tree->min = NULL;
+  tree->max = NULL;
+  tree->data_size = size;
+  tree->rotations = 0;
+  tree->compare = cmp;
+  tree->delete_data = del;
+
+  return tree;
+}
+
+static void delete_node(WAVLTree tree, WAVLNode node, bool del_data) {
+  if (!node) {
+    return;
+  }
+
+  if (tree->delete_data && del_data) {
+    tree->delete_data(node->data);
+  }
+  free(node);
+}
+
+// Ranks bound the height to 2 * log2(n), recursing over the tree is safe
+static void delete_all_nodes(WAVLTree tree, WAVLNode node) {
+  if (node == NULL) {
+    return;
+  }
+
+  delete_all_nodes(tree, node->left);
+  delete_all_nodes(tree, node->right);
+  delete_node(tree, node, true);
+}
+
+void wavl_delete(WAVLTree tree) {
+  if (!tree) {
+    return;
+  }
+
+  delete_all_nodes(tree, tree->root);
+  free(tree);
+}
+
+// --- Getters ---
+
+WAVLNode wavl_get_root(WAVLTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  return tree->root;
+}
+
+static int wavl_node_get_height(WAVLNode node) {
+  if (node == NULL) {
+    return 0;
+  }
+  return 1 + MAX(wavl_node_get_height(node->left), wavl_node_get_height(node->right));
+}
+
+int wavl_get_height(WAVLTree tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+  return wavl_node_get_height(tree->root);
+}
+
+int wavl_node_get_rank(WAVLNode node) {
+  if (node == NULL) {
+    return -1;
+  }
+  return node->rank;
+}
+
+static int wavl_node_get_size(WAVLNode node) {
+  if (node == NULL) {
+    return 0;
+  }
+  return 1 + wavl_node_get_size(node->left) + wavl_node_get_size(node->right);
+}
+
+int wavl_get_size(WAVLTree tree) { return wavl_node_get_size(tree->root); }
+
+WAVLNode wavl_node_get_left(WAVLNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->left;
+}
+
+WAVLNode wavl_node_get_right(WAVLNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->right;
+}
+
+WAVLNode wavl_first(WAVLTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  return tree->min;
+}
+
+WAVLNode wavl_last(WAVLTree tree) {
+  if (tree == NULL) {
+    return NULL;
+  }
+  return tree->max;
+}
+
+void* wavl_node_get_data(WAVLNode node) {
+  if (node == NULL) {
+    return NULL;
+  }
+  return node->data;
+}
+
+size_t wavl_get_rotations(WAVLTree tree) {
+  if (tree == NULL) {
+    return 0;
+  }
+  return tree->rotations;
+}
+
+// In-order walk, prev is the last node visited so the order check is a single comparison per node
+static bool wavl_subtree_is_valid(WAVLTree tree, WAVLNode node, WAVLNode* prev) {
+  if (node == NULL) return true;
+
+  int left_diff = node->rank - wavl_node_get_rank(node->left);
+  int right_diff = node->rank - wavl_node_get_rank(node->right);
+  if (left_diff < 1 || left_diff > 2 || right_diff < 1 || right_diff > 2) return false;
+  if (node->left == NULL && node->right == NULL && node->rank != 0) return false;
+
+  if (!wavl_subtree_is_valid(tree, node->left, prev)) return false;
+  if (*prev != NULL && tree->compare((*prev)->data, node->data) >= 0) return false;
+  *prev = node;
+  return wavl_subtree_is_valid(tree, node->right, prev);
+}
+
+bool wavl_is_valid(WAVLTree tree) {
+  WAVLNode prev = NULL;
+  if (!wavl_subtree_is_valid(tree, tree->root, &prev)) return false;
+  return tree->max == prev;
+}
+
+// --- Rotations ---
+
+static WAVLNode rotate_left(WAVLTree tree, WAVLNode node) {
+  WAVLNode r_node = node->right;
+  node->right = r_node->left;
+  r_node->left = node;
+  tree->rotations++;
+  return r_node;
+}
+
+static WAVLNode rotate_right(WAVLTree tree, WAVLNode node) {
+  WAVLNode l_node = node->left;
+  node->left = l_node->right;
+  l_node->right = node;
+  tree->rotations++;
+  return l_node;
+}
+
+// --- Insertion ---
+
+// links[depth] holds the new leaf, whose parent may now have a child of the same rank (a 0-child). Promotions move the
+// violation up while the parent's other child is a 1-child, otherwise one single or double rotation ends it.
+static void wavl_insert_rebalance(WAVLTree tree, WAVLNode** links, int depth) {
+  for (int i = depth; i > 0; i--) {
+    WAVLNode parent = *links[i - 1];
+    WAVLNode node = *links[i];
+    if (parent->rank != node->rank) return;
+
+    bool is_left = node == parent->left;
+    WAVLNode sibling = is_left ? parent->right : parent->left;
+    if (parent->rank - wavl_node_get_rank(sibling) == 1) {
+      parent->rank++;
+      continue;
+    }
+
+    // the sibling is a 2-child, node was promoted so its children are a 1-child and a 2-child
+    WAVLNode inner = is_left ? node->right : node->left;
+    if (node->rank - wavl_node_get_rank(inner) == 2) {
+      *links[i - 1] = is_left ? rotate_right(tree, parent) : rotate_left(tree, parent);
+      parent->rank--;
+    } else {
+      if (is_left) {
+        parent->left = rotate_left(tree, node);
+        *links[i - 1] = rotate_right(tree, parent);
+      } else {
+        parent->right = rotate_right(tree, node);
+        *links[i - 1] = rotate_left(tree, parent);
+      }
+      inner->rank++;
+      node->rank--;
+      parent->rank--;
+    }
+    return;
+  }
+}
+
+int wavl_add(WAVLTree tree, const void* data) {
+  WAVLNode* links[WAVL_MAX_HEIGHT + 1];
+  int depth = 0;
+  bool leftmost = true;
+  bool rightmost = true;
+
+  links[0] = &tree->root;
+  while (*links[depth] != NULL) {
+    int cmp = tree->compare(data, (*links[depth])->data);
+    if (cmp == 0) return 0;  // data already in tree
+    if (cmp < 0) {
+      links[depth + 1] = &(*links[depth])->left;
+      rightmost = false;
+    } else {
+      links[depth + 1] = &(*links[depth])->right;
+      leftmost = false;
+    }
+    depth++;
+  }
+
+  WAVLNode new_node = wavl_node_new(tree, data);
+  if (new_node == NULL) return ENOMEM;
+  *links[depth] = new_node;
+  if (leftmost) tree->min = new_node;
+  if (rightmost) tree->max = new_node;
+
+  wavl_insert_rebalance(tree, links, depth);
+  return 0;
+}
+
+// --- Deletion ---
+
+static WAVLNode tree_get_min_node(WAVLNode node) {
+  while (node->left != NULL) node = node->left;
+  return node;
+}
+
+static WAVLNode tree_get_max_node(WAVLNode node) {
+  while (node->right != NULL) node = node->right;
+  return node;
+}
+
+// links[depth] lost a node, the subtree it now holds may be a 3-child of its parent, or its parent may be a leaf of
+// rank 1. Demotions move the violation up, a rotation ends it.
+static void wavl_remove_rebalance(WAVLTree tree, WAVLNode** links, int depth) {
+  for (int i = depth; i > 0; i--) {
+    WAVLNode parent = *links[i - 1];
+    WAVLNode node = *links[i];
+
+    if (parent->left == NULL && parent->right == NULL) {
+      if (parent->rank == 0) return;
+      parent->rank = 0;  // a leaf of rank 1, its own parent may now see a 3-child
+      continue;
+    }
+    if (parent->rank - wavl_node_get_rank(node) <= 2) return;
+
+    bool is_left = links[i] == &parent->left;
+    WAVLNode sibling = is_left ? parent->right : parent->left;
+    if (parent->rank - sibling->rank == 2) {
+      parent->rank--;
+      continue;
+    }
+
+    WAVLNode inner = is_left ? sibling->left : sibling->right;
+    WAVLNode outer = is_left ? sibling->right : sibling->left;
+    if (sibling->rank - wavl_node_get_rank(inner) == 2 && sibling->rank - wavl_node_get_rank(outer) == 2) {
+      parent->rank--;
+      sibling->rank--;
+      continue;
+    }
+
+    if (sibling->rank - wavl_node_get_rank(outer) == 1) {
+      *links[i - 1] = is_left ? rotate_left(tree, parent) : rotate_right(tree, parent);
+      sibling->rank++;
+      parent->rank--;
+      if (parent->left == NULL && parent->right == NULL) parent->rank--;  // a leaf must have rank 0
+    } else {
+      if (is_left) {
+        parent->right = rotate_right(tree, sibling);
+        *links[i - 1] = rotate_left(tree, parent);
+      } else {
+        parent->left = rotate_left(tree, sibling);
+        *links[i - 1] = rotate_right(tree, parent);
+      }
+      inner->rank += 2;
+      sibling->rank--;
+      parent->rank -= 2;
+    }
+    return;
+  }
+}
+
+// Unlinks the node held by links[depth] and frees it, or hands its data over to out. A node with two children is
+// replaced by its successor node, whose own link is where rebalancing starts.
+static void wavl_remove_at(WAVLTree tree, WAVLNode** links, int depth, void* out) {
+  WAVLNode node = *links[depth];
+  int hole = depth;
+
+  if (node->left == NULL || node->right == NULL) {
+    *links[depth] = node->left ? node->left : node->right;
+  } else {
+    links[depth + 1] = &node->right;
+    hole = depth + 1;
+    while ((*links[hole])->left != NULL) {
+      links[hole + 1] = &(*links[hole])->left;
+      hole++;
+    }
+
+    WAVLNode successor = *links[hole];
+    *links[hole] = successor->right;
+    successor->left = node->left;
+    successor->right = node->right;
+    successor->rank = node->rank;
+    *links[depth] = successor;
+    links[depth + 1] = &successor->right;
+  }
+
+  if (node == tree->min) tree->min = NULL;
+  if (node == tree->max) tree->max = NULL;
+  if (out != NULL) memcpy(out, node->data, tree->data_size);
+  delete_node(tree, node, out == NULL);
+
+  wavl_remove_rebalance(tree, links, hole);
+
+  if (tree->root == NULL) return;
+  if (tree->min == NULL) tree->min = tree_get_min_node(tree->root);
+  if (tree->max == NULL) tree->max = tree_get_max_node(tree->root);
+}
+
+void wavl_remove(WAVLTree tree, const void* data) {
+  WAVLNode* links[WAVL_MAX_HEIGHT + 1];
+  int depth = 0;
+
+  links[0] = &tree->root;
+  while (*links[depth] != NULL) {
+    int cmp = tree->compare(data, (*links[depth])->data);
+    if (cmp == 0) {
+      wavl_remove_at(tree, links, depth, NULL);
+      return;
+    }
+    links[depth + 1] = cmp < 0 ? &(*links[depth])->left : &(*links[depth])->right;
+    depth++;
+  }
+}
+
+bool wavl_pop_min(WAVLTree tree, void* out) {
+  if (tree->root == NULL) return false;
+
+  WAVLNode* links[WAVL_MAX_HEIGHT + 1];
+  int depth = 0;
+  links[0] = &tree->root;
+  while ((*links[depth])->left != NULL) {
+    links[depth + 1] = &(*links[depth])->left;
+    depth++;
+  }
+  wavl_remove_at(tree, links, depth, out);
+  return true;
+}
+
+bool wavl_pop_max(WAVLTree tree, void* out) {
+  if (tree->root == NULL) return false;
+
+  WAVLNode* links[WAVL_MAX_HEIGHT + 1];
+  int depth = 0;
+  links[0] = &tree->root;
+  while ((*links[depth])->right != NULL) {
+    links[depth + 1] = &(*links[depth])->right;
+    depth++;
+  }
+  wavl_remove_at(tree, links, depth, out);
+  return true;
+}
+
+// --- Search ---
+
+WAVLNode wavl_find_node(WAVLTree tree, const void* data) {
+  WAVLNode current = tree->root;
+
+  while (current != NULL) {
+    int cmp = tree->compare(data, current->data);
+    if (cmp == 0) {
+      return current;
+    } else if (cmp < 0) {
+      current = current->left;
+    } else {
+      current = current->right;
+    }
+  }
+
+  return NULL;
+}
+
+void* wavl_find_data(WAVLTree tree, const void* data) {
+  WAVLNode node = wavl_find_node(tree, data);
+  return node ? node->data : NULL;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file wavl-tree.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Type Definitions ---
+
+/**
+ * @brief WAVL (weak AVL) tree type.
+ *
+ * A rank-balanced tree shaped exactly like an AVL tree as long as only insertions are made. Removals only relax the
+ * balance, so they need O(1) amortized rotations (at most two per removal) instead of up to one per level.
+ */
+typedef struct _WAVLTree* WAVLTree;
+
+/**
+ * @brief WAVL tree node type.
+ */
+typedef struct _TreeNode* WAVLNode;
+
+// --- Constructors and Destructors ---
+
+/**
+ * @brief Create a new WAVL tree.
+ *
+ * @param size Size of the stored data in bytes.
+ * @param cmp Comparison function for the data.
+ * @param del Deletion function for the data.
+ * @return The newly created WAVL tree, or NULL if it could not be allocated.
+ */
+extern WAVLTree wavl_new(size_t size, int (*cmp)(const void*, const void*), void (*del)(void*));
+
+/**
+ * @brief Delete a WAVL tree, freeing all associated memory.
+ *
+ * @param tree The WAVL tree to be deleted.
+ */
+extern void wavl_delete(WAVLTree tree);
+
+// --- Getters ---
+
+/**
+ * @brief Get the root node of the WAVL tree.
+ *
+ * @param tree The WAVL tree.
+ * @return The root node of the WAVL tree.
+ */
+extern WAVLNode wavl_get_root(WAVLTree tree);
+
+/**
+ * @brief Get the height of the WAVL tree, computed by walking it.
+ *
+ * @param tree The WAVL tree.
+ * @return The height of the tree.
+ */
+extern int wavl_get_height(WAVLTree tree);
+
+/**
+ * @brief Get the rank of a given WAVL tree node, equal to its height minus one when no removal was made.
+ *
+ * @param node The WAVL tree node.
+ * @return The rank of the node, -1 for NULL.
+ */
+extern int wavl_node_get_rank(WAVLNode node);
+
+/**
+ * @brief Get the size (number of nodes) of the WAVL tree.
+ *
+ * @param tree The WAVL tree.
+ * @return The size of the tree.
+ */
+extern int wavl_get_size(WAVLTree tree);
+
+/**
+ * @brief Get the left child of a given WAVL tree node.
+ *
+ * @param node The WAVL tree node.
+ * @return The left child of the node.
+ */
+extern WAVLNode wavl_node_get_left(WAVLNode node);
+
+/**
+ * @brief Get the right child of a given WAVL tree node.
+ *
+ * @param node The WAVL tree node.
+ * @return The right child of the node.
+ */
+extern WAVLNode wavl_node_get_right(WAVLNode node);
+
+/**
+ * @brief Get the node holding the smallest data of the WAVL tree, in constant time.
+ *
+ * @param tree The WAVL tree.
+ * @return The first node in order, or NULL if the tree is empty.
+ */
+extern WAVLNode wavl_first(WAVLTree tree);
+
+/**
+ * @brief Get the node holding the largest data of the WAVL tree, in constant time.
+ *
+ * @param tree The WAVL tree.
+ * @return The last node in order, or NULL if the tree is empty.
+ */
+extern WAVLNode wavl_last(WAVLTree tree);
+
+/**
+ * @brief Get the data stored in a given WAVL tree node.
+ *
+ * @param node The WAVL tree node.
+ * @return Pointer to the data stored in the node.
+ */
+extern void* wavl_node_get_data(WAVLNode node);
+
+/**
+ * @brief Get the number of rotations done by the WAVL tree since its creation, a double rotation counting as two.
+ *
+ * @param tree The WAVL tree.
+ * @return The number of rotations.
+ */
+extern size_t wavl_get_rotations(WAVLTree tree);
+
+/**
+ * @brief Check if the WAVL tree is valid (data in strictly ascending order, rank differences of 1 or 2, leaves of
+ * rank 0).
+ *
+ * @param tree The WAVL tree to be checked.
+ * @return true if the tree is valid, false otherwise.
+ */
+extern bool wavl_is_valid(WAVLTree tree);
+
+// --- Insertion ---
+
+/**
+ * @brief Add data to the WAVL tree, nothing is done if it is already present.
+ *
+ * @param tree The WAVL tree where data will be inserted.
+ * @param data Pointer to the data to be inserted.
+ * @return 0 on success, ENOMEM if no node could be allocated, in which case the tree is left unchanged.
+ */
+extern int wavl_add(WAVLTree tree, const void* data);
+
+// --- Deletion ---
+
+/**
+ * @brief Remove data from the WAVL tree, with at most two rotations.
+ *
+ * @param tree The WAVL tree from which data will be removed.
+ * @param data Pointer to the data to be removed.
+ */
+extern void wavl_remove(WAVLTree tree, const void* data);
+
+/**
+ * @brief Remove the smallest data from the WAVL tree without calling the comparison function.
+ *
+ * @param tree The WAVL tree from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller. If NULL, the deletion function is
+ * called on the data instead.
+ * @return true if data was removed, false if the tree was empty.
+ */
+extern bool wavl_pop_min(WAVLTree tree, void* out);
+
+/**
+ * @brief Remove the largest data from the WAVL tree without calling the comparison function.
+ *
+ * @param tree The WAVL tree from which data will be removed.
+ * @param out Buffer receiving the removed data, which then belongs to the caller. If NULL, the deletion function is
+ * called on the data instead.
+ * @return true if data was removed, false if the tree was empty.
+ */
+extern bool wavl_pop_max(WAVLTree tree, void* out);
+
+// --- Search ---
+
+/**
+ * @brief Find a node in the WAVL tree containing the specified data.
+ *
+ * @param tree The WAVL tree to search.
+ * @param data Pointer to the data to search for.
+ * @return The node containing the data, or NULL if not found.
+ */
+extern WAVLNode wavl_find_node(WAVLTree tree, const void* data);
+
+/**
+ * @brief Find data in the WAVL tree.
+ *
+ * @param tree The WAVL tree to search.
+ * @param data Pointer to the data to search for.
+ * @return Pointer to the found data, or NULL if not found.
+ */
+extern void* wavl_find_data(WAVLTree tree, const void* data);
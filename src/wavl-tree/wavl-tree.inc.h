@@ -0,0 +1,31 @@
+/**
+ * @file wavl-tree.inc.h
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "wavl-tree.h"
+
+#define WAVL_MAX_HEIGHT 128  // 2 * log2(n) stays below it for any size_t node count
+
+struct _TreeNode {
+  WAVLNode left;
+  WAVLNode right;
+  int rank;
+  char data[1];
+};
+
+struct _WAVLTree {
+  WAVLNode root;
+  WAVLNode min;
+  WAVLNode max;
+  size_t data_size;
+  size_t rotations;  // single rotations done since the tree was created, a double rotation counts twice
+  int (*compare)(const void* a, const void* b);
+  void (*delete_data)(void* data);
+};
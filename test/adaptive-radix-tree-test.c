@@ -0,0 +1,99 @@
+/**
+ * @file adaptive-radix-tree-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "adaptive-radix-tree.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void printEntry(const void* key, size_t key_len, void* data, void* arg) {
+  printf("%s:%d\n", (const char*)key, *(uint16_t*)data);
+}
+
+void checkAscending(const void* key, size_t key_len, void* data, void* arg) {
+  int64_t* last = arg;
+  unsigned char bytes[8];
+  memcpy(bytes, key, 8);
+  int64_t value = 0;
+  for (int i = 0; i < 8; i++) value = (value << 8) | bytes[i];
+  assert(value > *last);
+  *last = value;
+}
+
+void freeShortPtr(void* data) { free(*(uint16_t**)data); }
+
+// shared prefixes longer than the stored prefix, and enough children under one byte to grow every node type
+const char* words[12] = {"romane",      "romanus",        "romulus",   "rubens",    "ruber",     "rubicon",
+                         "rubicundus", "antidisestablishment", "antidisestablishmentarian", "antidote", "a", "z"};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+
+  // Emulating a situation that would need a cleanup function, like freeShortPtr here.
+  uint16_t* shortPtrs[12];
+  for (int i = 0; i < 12; i++) {
+    shortPtrs[i] = malloc(sizeof(uint16_t));
+    *shortPtrs[i] = i;
+  }
+
+  ARTree tree = art_new(sizeof(uint16_t*), freeShortPtr);
+  assert(tree != NULL);
+  assert(art_get_size(tree) == 0);
+
+  for (int i = 0; i < 12; i++) {
+    ok = art_add(tree, words[i], strlen(words[i]) + 1, &shortPtrs[i]);  // NUL included, keeps keys prefix-free
+    assert(ok);
+    assert(art_is_valid(tree));
+  }
+  ok = art_add(tree, words[0], strlen(words[0]) + 1, &shortPtrs[0]);  // adding duplicate should do nothing
+  assert(!ok);
+  ok = art_add(tree, "rom", 3, &shortPtrs[0]);  // prefix of other keys is refused
+  assert(!ok);
+  assert(art_get_size(tree) == 12);
+
+  assert(**(uint16_t**)art_find_data(tree, "rubicon", 8) == 5);
+  assert(**(uint16_t**)art_find_data(tree, "antidisestablishmentarian", 26) == 8);
+  assert(art_find_data(tree, "rubico", 7) == NULL);
+  assert(art_find_data(tree, "antidisestablishmentarianism", 29) == NULL);
+
+  for (int i = 0; i < 12; i++) {
+    art_remove(tree, words[i], strlen(words[i]) + 1);
+    assert(art_find_data(tree, words[i], strlen(words[i]) + 1) == NULL);
+    assert(art_is_valid(tree));
+  }
+  assert(art_get_size(tree) == 0);
+  art_delete(tree);
+
+  // Integer keys, dense enough to grow nodes up to Node256 and sparse enough to keep Node4/16/48
+  ARTree tree2 = art_new(sizeof(uint64_t), NULL);
+  unsigned char key[8];
+  for (uint64_t i = 0; i < 5000; i++) {
+    uint64_t value = (i * 2654435761u) % 100000;
+    art_key_from_u64(value, key);
+    art_add(tree2, key, 8, &value);
+  }
+  assert(art_is_valid(tree2));
+  int64_t last = -1;
+  art_foreach(tree2, checkAscending, &last);
+
+  for (uint64_t i = 0; i < 5000; i += 2) {
+    uint64_t value = (i * 2654435761u) % 100000;
+    art_key_from_u64(value, key);
+    assert(*(uint64_t*)art_find_data(tree2, key, 8) == value);
+    art_remove(tree2, key, 8);
+  }
+  assert(art_is_valid(tree2));
+  assert(art_get_size(tree2) == 2500);
+  art_delete(tree2);
+
+  return EXIT_SUCCESS;
+}
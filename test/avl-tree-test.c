@@ -8,10 +8,15 @@
 #include "avl-tree.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void printShort(AVLNode node) { printf("%d:%d\n", **(uint16_t**)(avl_node_get_data(node)), avl_node_get_height(node)); }
 
@@ -58,9 +63,118 @@ int cmpShort(const void* a, const void* b) {
 
 void freeShortPtr(void* data) { free(*(uint16_t**)data); }
 
+int string_comparisons = 0;
+
+int cmpString(const void* a, const void* b) {
+  string_comparisons++;
+  return strcmp(a, b);
+}
+
+size_t stringSize(const void* data) { return strlen(data) + 1; }
+
+size_t hashShort(const void* data) { return *(uint16_t*)data; }
+
+int short_comparisons = 0;
+
+int cmpShortCounted(const void* a, const void* b) {
+  short_comparisons++;
+  return cmpShort(a, b);
+}
+
+// Map records made of a short key and a 64-bit value, hashed whole so changed values are diffed
+size_t hashRecord(const void* data) {
+  uint16_t key;
+  uint64_t value;
+  memcpy(&key, data, sizeof(key));
+  memcpy(&value, (const char*)data + sizeof(key), sizeof(value));
+  return key * 1000003u + value;
+}
+
+// Differences reported by avl_diff, with the trees holding each key (1 for a only, 2 for b only, 3 for both)
+struct diffs {
+  int count;
+  uint16_t keys[8];
+  int sides[8];
+};
+
+void collectDiff(const void* a_data, const void* b_data, void* arg) {
+  struct diffs* diffs = arg;
+  assert(diffs->count < 8);
+  memcpy(&diffs->keys[diffs->count], a_data ? a_data : b_data, sizeof(uint16_t));
+  diffs->sides[diffs->count++] = (a_data ? 1 : 0) | (b_data ? 2 : 0);
+}
+
+atomic_int deleted = 0;
+
+void countDelete(void* data) { atomic_fetch_add(&deleted, 1); }
+
+// Sum augmentation, every node keeps the total of its subtree
+void sumShort(void* out, const void* data, const void* left, const void* right) {
+  *(uint64_t*)out = *(const uint64_t*)left + *(const uint16_t*)data + *(const uint64_t*)right;
+}
+
+uint64_t sumPresent(const bool* present, int lo, int hi) {
+  uint64_t sum = 0;
+  for (int i = lo; i <= hi; i++) {
+    if (present[i]) sum += i;
+  }
+  return sum;
+}
+
+// Allocator failing once its budget is spent, live counts the allocations not freed yet
+struct budget {
+  int remaining;
+  int live;
+};
+
+void* budgetAlloc(void* ctx, size_t size) {
+  struct budget* budget = ctx;
+  if (budget->remaining == 0) return NULL;
+  budget->remaining--;
+  budget->live++;
+  return malloc(size);
+}
+
+void budgetFree(void* ctx, void* ptr) {
+  struct budget* budget = ctx;
+  budget->live--;
+  free(ptr);
+}
+
+// Allocator raising done once the tree itself, the last block a deletion frees, is gone
+struct teardown {
+  void* tree;
+  atomic_bool done;
+};
+
+void* teardownAlloc(void* ctx, size_t size) { return malloc(size); }
+
+void teardownFree(void* ctx, void* ptr) {
+  struct teardown* teardown = ctx;
+  bool last = ptr == teardown->tree;
+  free(ptr);
+  if (last) atomic_store(&teardown->done, true);
+}
+
+void checkRanges(AVLTree tree, const bool* present) {
+  for (int lo = 0; lo < 300; lo += 13) {
+    for (int hi = lo - 20; hi < 300; hi += 17) {
+      uint16_t l = lo, h = hi < 0 ? 0 : hi;
+      uint64_t sum;
+      assert(avl_range_aggregate(tree, &l, &h, &sum) == 0);
+      assert(sum == (hi < lo ? 0 : sumPresent(present, l, h)));
+    }
+  }
+}
+
 uint16_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
 
 int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+  int error;
+  size_t removed;
+
   // Emulating a situation that would need a cleanup function, like freeShortPtr here.
   uint16_t* shortPtrs[18];
   for (int i = 0; i < 18; i++) {
@@ -99,10 +213,539 @@ int main(void) {
   avl_add(tree2, &testVals[0]);
   avl_add(tree2, &testVals[1]);
   avl_add(tree2, &testVals[2]);
+  assert(avl_get_rotations(tree2) == 2);  // 10, 85, 15 needs a double rotation
   avl_remove(tree2, &testVals[3]);
   assert(avl_is_valid(tree2));
 
   avl_delete(tree2);
 
-  return EXIT_SUCCESS;
+  // Queue-like use, min/max are cached and popped without comparisons
+  AVLTree queue = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(avl_first(queue) == NULL && avl_last(queue) == NULL);
+  for (int i = 0; i < 18; i++) {
+    avl_add(queue, &testVals[i]);
+  }
+  assert(*(uint16_t*)avl_node_get_data(avl_first(queue)) == 4);
+  assert(*(uint16_t*)avl_node_get_data(avl_last(queue)) == 93);
+
+  uint16_t popped, previous = 0;
+  while (avl_pop_min(queue, &popped)) {
+    assert(popped > previous);
+    previous = popped;
+    assert(avl_is_valid(queue));
+    if (avl_get_size(queue) == 9) break;
+  }
+  ok = avl_pop_max(queue, &popped);
+  assert(ok && popped == 93);
+  assert(*(uint16_t*)avl_node_get_data(avl_last(queue)) == 92);
+  while (avl_pop_max(queue, NULL)) {
+    assert(avl_is_valid(queue));
+  }
+  assert(avl_first(queue) == NULL && avl_last(queue) == NULL);
+  avl_delete(queue);
+
+  // Range sums kept up to date through rotations, successor copies and pops
+  uint64_t zero = 0;
+  AVLAugment sum_augment = {sizeof(uint64_t), &zero, sumShort};
+  AVLTree summed = avl_new_augmented(sizeof(uint16_t), cmpShort, NULL, &sum_augment);
+  bool present[300] = {false};
+  uint64_t total;
+  queue = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(avl_range_aggregate(queue, &testVals[0], &testVals[1], &total) == EINVAL);  // not augmented
+  avl_delete(queue);
+
+  for (uint16_t i = 0; i < 300; i++) {
+    uint16_t val = (i * 151) % 300;
+    avl_add(summed, &val);
+    present[val] = true;
+  }
+  assert(avl_is_valid(summed));
+  checkRanges(summed, present);
+
+  for (uint16_t i = 0; i < 300; i += 3) {
+    avl_remove(summed, &i);
+    present[i] = false;
+  }
+  uint16_t popped_min, popped_max;
+  ok = avl_pop_min(summed, &popped_min);
+  assert(ok);
+  ok = avl_pop_max(summed, &popped_max);
+  assert(ok);
+  present[popped_min] = present[popped_max] = false;
+  assert(avl_is_valid(summed));
+  checkRanges(summed, present);
+
+  // Range removal joins what is left around the removed range
+  uint16_t lo = 100, hi = 180;
+  size_t in_range = 0;
+  for (int i = lo; i <= hi; i++) {
+    if (present[i]) in_range++;
+    present[i] = false;
+  }
+  removed = avl_remove_range(summed, &lo, &hi);
+  assert(removed == in_range);
+  removed = avl_remove_range(summed, &hi, &lo);
+  assert(removed == 0);
+  assert(avl_is_valid(summed));
+  checkRanges(summed, present);
+
+  lo = 0;
+  hi = 299;
+  assert(avl_range_aggregate(summed, &lo, &hi, &total) == 0 && total == sumPresent(present, 0, 299));
+  avl_delete(summed);
+
+  // Removed ranges go through the deletion function
+  AVLTree owned = avl_new(sizeof(uint16_t*), cmpShortPtr, freeShortPtr);
+  for (int i = 0; i < 18; i++) {
+    uint16_t* owned_val = malloc(sizeof(uint16_t));
+    *owned_val = testVals[i];
+    avl_add(owned, &owned_val);
+  }
+  uint16_t low = 10, high = 70;
+  uint16_t *low_ptr = &low, *high_ptr = &high;
+  removed = avl_remove_range(owned, &low_ptr, &high_ptr);
+  assert(removed == 8);
+  assert(avl_get_size(owned) == 10 && avl_is_valid(owned));
+  assert(**(uint16_t**)avl_node_get_data(avl_first(owned)) == 4);
+  assert(**(uint16_t**)avl_node_get_data(avl_last(owned)) == 93);
+  avl_delete(owned);
+
+  // Batched lookups give the same answers as one by one lookups, misses included
+  AVLTree batched = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  uint16_t wanted[100];
+  void* results[100];
+  for (uint16_t i = 0; i < 100; i++) {
+    wanted[i] = (i * 37) % 150;
+    if (i % 2) avl_add(batched, &i);
+  }
+  assert(avl_find_batch(batched, wanted, 0, results) == 0);
+  size_t found = avl_find_batch(batched, wanted, 100, results);
+  size_t expected = 0;
+  for (int i = 0; i < 100; i++) {
+    assert(results[i] == avl_find_data(batched, &wanted[i]));
+    if (results[i]) expected++;
+  }
+  assert(found == expected && found > 0);
+  avl_delete(batched);
+
+  // Insertion from either edge, with keys arriving slightly out of order
+  AVLTree edged = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  for (uint16_t i = 0; i < 200; i++) {
+    uint16_t val = 1000 + (i ^ 1);
+    error = avl_add_edge(edged, false, &val);
+    assert(error == 0);
+    val = 999 - (i ^ 1);
+    error = avl_add_edge(edged, true, &val);
+    assert(error == 0);
+    assert(avl_is_valid(edged));
+  }
+  uint16_t middle = 1000;
+  error = avl_add_edge(edged, false, &middle);  // duplicate
+  assert(error == 0);
+  assert(avl_get_size(edged) == 400);
+  assert(*(uint16_t*)avl_node_get_data(avl_first(edged)) == 800);
+  assert(*(uint16_t*)avl_node_get_data(avl_last(edged)) == 1199);
+  for (uint16_t i = 800; i < 1200; i++) {
+    assert(avl_find_data(edged, &i) != NULL);
+  }
+  avl_delete(edged);
+
+  // Compaction moves every node into one region, the tree stays usable and can be compacted in steps
+  AVLTree compacted = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  void* spacers[200];
+  for (uint16_t i = 0; i < 200; i++) {
+    uint16_t val = (i * 71) % 200;
+    avl_add(compacted, &val);
+    spacers[i] = malloc(64);  // scatters the nodes across the heap
+  }
+  AVLFootprint before, after;
+  error = avl_compact(compacted, &before, &after);
+  assert(error == 0);
+  assert(before.nodes == 200 && before.allocations == 200);
+  assert(after.nodes == 200 && after.allocations == 1 && after.span < before.span);
+  assert(avl_is_valid(compacted));
+
+  for (uint16_t i = 0; i < 200; i += 2) {
+    avl_remove(compacted, &i);
+  }
+  error = avl_compact_begin(compacted);
+  assert(error == 0);
+  bool done = false;
+  uint16_t next = 200;
+  while (!done) {
+    error = avl_compact_step(compacted, 16, &done);
+    assert(error == 0);
+    error = avl_add(compacted, &next);  // the tree can change between steps
+    assert(error == 0);
+    next++;
+    assert(avl_is_valid(compacted));
+  }
+  avl_get_footprint(compacted, &after);
+  assert(after.nodes == (size_t)avl_get_size(compacted) && after.nodes == 100u + (next - 200u));
+  for (uint16_t i = 1; i < 200; i += 2) {
+    assert(avl_find_data(compacted, &i) != NULL);
+  }
+  for (uint16_t i = 200; i < next; i++) {
+    assert(avl_find_data(compacted, &i) != NULL);
+  }
+  for (int i = 0; i < 200; i++) {
+    free(spacers[i]);
+  }
+  avl_delete(compacted);
+
+  // Allocation failures are reported instead of exiting, and leave the tree untouched
+  struct budget budget = {0, 0};
+  AVLAllocator failing = {budgetAlloc, budgetFree, &budget};
+  assert(avl_new_with_allocator(sizeof(uint16_t), cmpShort, NULL, NULL, &failing) == NULL);
+
+  budget.remaining = 1;
+  AVLTree bounded = avl_new_with_allocator(sizeof(uint16_t), cmpShort, NULL, NULL, &failing);
+  assert(bounded != NULL);
+  error = avl_add(bounded, &testVals[0]);
+  assert(error == ENOMEM);
+  assert(avl_get_size(bounded) == 0 && avl_first(bounded) == NULL);
+
+  budget.remaining = 9;
+  for (int i = 0; i < 9; i++) {
+    error = avl_add(bounded, &testVals[i]);
+    assert(error == 0);
+  }
+  error = avl_add(bounded, &testVals[0]);  // duplicates need no node
+  assert(error == 0);
+  error = avl_add(bounded, &testVals[9]);
+  assert(error == ENOMEM);
+  assert(avl_get_size(bounded) == 9 && avl_is_valid(bounded) && avl_find_data(bounded, &testVals[9]) == NULL);
+
+  avl_remove(bounded, &testVals[0]);
+  budget.remaining = 1;
+  error = avl_add(bounded, &testVals[9]);
+  assert(error == 0);
+  assert(avl_get_size(bounded) == 9 && avl_is_valid(bounded));
+  avl_delete(bounded);
+  assert(budget.live == 0);
+
+  // Maps compare keys only, values are overwritten in place and records are the key followed by the value
+  AVLTree map = avl_new_map(sizeof(uint16_t), sizeof(uint64_t), cmpShort, NULL);
+  assert(map != NULL);
+  for (uint16_t i = 0; i < 100; i++) {
+    uint64_t value = i * 1000;
+    error = avl_map_put(map, &i, &value);
+    assert(error == 0);
+  }
+  for (uint16_t i = 0; i < 100; i += 2) {
+    uint64_t value = i + 1;
+    error = avl_map_put(map, &i, &value);
+    assert(error == 0);
+  }
+  assert(avl_get_size(map) == 100 && avl_is_valid(map));
+  for (uint16_t i = 0; i < 100; i++) {
+    uint64_t value;
+    memcpy(&value, avl_map_get(map, &i), sizeof(value));
+    assert(value == (i % 2 ? i * 1000u : i + 1u));
+  }
+  uint16_t absent = 100;
+  assert(avl_map_get(map, &absent) == NULL);
+  assert(avl_node_get_value(map, avl_first(map)) == (char*)avl_node_get_data(avl_first(map)) + sizeof(uint16_t));
+  for (uint16_t i = 0; i < 100; i += 3) {
+    avl_remove(map, &i);
+  }
+  absent = 30;
+  assert(avl_get_size(map) == 66 && avl_is_valid(map) && avl_map_get(map, &absent) == NULL);
+  unsigned char record[sizeof(uint16_t) + sizeof(uint64_t)];
+  uint16_t key;
+  uint64_t value;
+  ok = avl_pop_max(map, record);
+  assert(ok);
+  memcpy(&key, record, sizeof(key));
+  memcpy(&value, record + sizeof(key), sizeof(value));
+  assert(key == 98 && value == 99);
+  avl_delete(map);
+
+  // Maps can take their memory from any allocator, counting it like other trees
+  budget.remaining = 1000;
+  AVLTree counted_map = avl_new_map_with_allocator(sizeof(uint16_t), sizeof(uint64_t), cmpShort, NULL, &failing);
+  assert(counted_map != NULL);
+  for (uint16_t i = 0; i < 10; i++) {
+    uint64_t value = i * 7;
+    error = avl_map_put(counted_map, &i, &value);
+    assert(error == 0);
+  }
+  assert(budget.live == 11 && avl_is_valid(counted_map));
+  uint16_t counted_key = 3;
+  uint64_t counted_value;
+  memcpy(&counted_value, avl_map_get(counted_map, &counted_key), sizeof(counted_value));
+  assert(counted_value == 21);
+  avl_delete(counted_map);
+  assert(budget.live == 0);
+
+  // Strings stored inline in nodes of their exact size, the stored prefixes settle comparisons of differing strings
+  const char* words[8] = {"pear", "apple", "fig", "banana", "cherry", "a", "apricot-jam", "applesauce"};
+  assert(avl_new_variable(17, stringSize, cmpString, NULL) == NULL);
+  AVLTree strings = avl_new_variable(8, stringSize, cmpString, NULL);
+  for (int i = 0; i < 8; i++) {
+    error = avl_add(strings, words[i]);
+    assert(error == 0);
+  }
+  error = avl_add(strings, "fig");  // duplicate
+  assert(error == 0);
+  assert(avl_get_size(strings) == 8 && avl_is_valid(strings));
+  assert(strcmp(avl_node_get_data(avl_first(strings)), "a") == 0);
+  assert(avl_node_get_data_size(strings, avl_last(strings)) == sizeof("pear"));
+
+  string_comparisons = 0;
+  assert(strcmp(avl_find_data(strings, "fig"), "fig") == 0);
+  assert(avl_find_data(strings, "figs") == NULL);
+  assert(string_comparisons == 1);  // only the node holding fig shares a prefix with the searched strings
+
+  const void* batch_words[3] = {"banana", "kiwi", "a"};
+  void* batch_results[3];
+  assert(avl_find_batch(strings, batch_words, 3, batch_results) == 2 && batch_results[1] == NULL);
+
+  for (int i = 0; i < 8; i += 2) {
+    avl_remove(strings, words[i]);
+    assert(avl_is_valid(strings) && avl_find_data(strings, words[i]) == NULL);
+  }
+  assert(strcmp(avl_find_data(strings, "apple"), "apple") == 0);
+  char popped_word[16];
+  ok = avl_pop_max(strings, popped_word);
+  assert(ok && strcmp(popped_word, "banana") == 0);
+  avl_delete(strings);
+
+  // Bloom filter in front of lookups, misses are mostly answered without a descent
+  AVLTree filtered = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  AVLFilterStats stats;
+  avl_get_filter_stats(filtered, &stats);
+  assert(stats.bytes == 0);
+  error = avl_set_filter(filtered, hashShort, 0);
+  assert(error == EINVAL);
+  error = avl_set_filter(filtered, hashShort, 10);
+  assert(error == 0);
+  for (uint16_t i = 0; i < 2000; i += 2) {
+    error = avl_add(filtered, &i);
+    assert(error == 0);
+  }
+  for (uint16_t i = 0; i < 4000; i++) {
+    assert((avl_find_data(filtered, &i) != NULL) == (i < 2000 && i % 2 == 0));
+  }
+  avl_get_filter_stats(filtered, &stats);
+  assert(stats.rebuilds > 0);  // grown along with the tree
+  assert(stats.elements == 1000 && stats.lookups == 4000);
+  assert(stats.rejected + stats.false_positives == 3000);
+  assert(stats.measured_fpr < 0.05 && stats.expected_fpr < 0.05);
+
+  uint16_t filtered_lo = 0, filtered_hi = 1499;
+  removed = avl_remove_range(filtered, &filtered_lo, &filtered_hi);
+  assert(removed == 750);
+  avl_get_filter_stats(filtered, &stats);
+  assert(stats.elements == 250);  // rebuilt once removed elements outnumbered the remaining ones
+  uint16_t filtered_keys[4] = {1500, 1501, 10, 1998};
+  void* filtered_results[4];
+  assert(avl_find_batch(filtered, filtered_keys, 4, filtered_results) == 2);
+  assert(filtered_results[0] != NULL && filtered_results[1] == NULL && filtered_results[2] == NULL);
+  error = avl_set_filter(filtered, NULL, 0);
+  assert(error == 0);
+  avl_get_filter_stats(filtered, &stats);
+  assert(stats.bytes == 0 && avl_find_data(filtered, &filtered_keys[3]) != NULL);
+  avl_delete(filtered);
+
+  // Lookup cache, hot keys are found without a descent and removed nodes are dropped from it
+  AVLTree cached = avl_new(sizeof(uint16_t), cmpShort, NULL);
+  AVLCacheStats cache_stats;
+  error = avl_set_cache(cached, hashShort, 0);
+  assert(error == EINVAL);
+  error = avl_set_cache(cached, hashShort, 6);
+  assert(error == 0);
+  avl_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.entries == 8);
+  for (uint16_t i = 0; i < 100; i++) {
+    error = avl_add(cached, &i);
+    assert(error == 0);
+  }
+  for (int round = 0; round < 10; round++) {  // keys 1 to 4 land in distinct entries
+    for (uint16_t i = 1; i <= 4; i++) {
+      assert(*(uint16_t*)avl_find_data(cached, &i) == i);
+    }
+  }
+  avl_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.lookups == 40 && cache_stats.hits == 36 && cache_stats.hit_rate == 0.9);
+
+  uint16_t hot = 2, inner = 50;
+  assert(avl_find_data(cached, &inner) != NULL);  // cached, then removed with a successor taking its place
+  avl_remove(cached, &hot);
+  avl_remove(cached, &inner);
+  avl_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.invalidations == 2);
+  assert(avl_find_data(cached, &hot) == NULL && avl_find_data(cached, &inner) == NULL);
+  uint16_t successor = 51;
+  assert(*(uint16_t*)avl_find_data(cached, &successor) == 51);
+
+  error = avl_compact(cached, NULL, NULL);  // cached nodes follow their data
+  assert(error == 0);
+  hot = 1;
+  assert(*(uint16_t*)avl_find_data(cached, &hot) == 1);
+  avl_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.hits == 37);
+  avl_delete(cached);
+
+  // Replicas built in different orders hash the same, diffs only visit the subtrees that differ
+  AVLTree replica_a = avl_new(sizeof(uint16_t), cmpShortCounted, NULL);
+  AVLTree replica_b = avl_new(sizeof(uint16_t), cmpShortCounted, NULL);
+  assert(avl_diff(replica_a, replica_b, collectDiff, NULL) == EINVAL);
+  error = avl_set_merkle(replica_a, hashShort);
+  assert(error == 0);
+  error = avl_set_merkle(replica_b, hashShort);
+  assert(error == 0);
+  for (uint16_t i = 0; i < 32768; i++) {
+    uint16_t val = (i * 7919) % 32768;
+    error = avl_add(replica_a, &val);
+    assert(error == 0);
+    error = avl_add(replica_b, &i);
+    assert(error == 0);
+  }
+  error = avl_set_merkle(replica_a, NULL);
+  assert(error == EINVAL);
+  assert(avl_get_merkle_hash(replica_a) == avl_get_merkle_hash(replica_b) && avl_get_merkle_hash(replica_a) != 0);
+  struct diffs diffs = {0};
+  assert(avl_diff(replica_a, replica_b, collectDiff, &diffs) == 0 && diffs.count == 0);
+
+  uint16_t changes[4] = {777, 1234, 40000, 50000};
+  avl_remove(replica_b, &changes[0]);
+  avl_remove(replica_a, &changes[1]);
+  error = avl_add(replica_a, &changes[2]);
+  assert(error == 0);
+  error = avl_add(replica_b, &changes[3]);
+  assert(error == 0);
+  assert(avl_get_merkle_hash(replica_a) != avl_get_merkle_hash(replica_b));
+  short_comparisons = 0;
+  assert(avl_diff(replica_a, replica_b, collectDiff, &diffs) == 0);
+  assert(short_comparisons < 4000);  // against 32768 for a full walk
+  assert(diffs.count == 4);
+  int sides[4] = {1, 2, 1, 2};
+  for (int i = 0; i < 4; i++) {
+    assert(diffs.keys[i] == changes[i] && diffs.sides[i] == sides[i]);
+  }
+  avl_remove(replica_a, &changes[0]);
+  error = avl_add(replica_a, &changes[1]);
+  assert(error == 0);
+  avl_remove(replica_a, &changes[2]);
+  error = avl_add(replica_a, &changes[3]);
+  assert(error == 0);
+  assert(avl_get_merkle_hash(replica_a) == avl_get_merkle_hash(replica_b) && avl_is_valid(replica_a));
+  avl_delete(replica_a);
+  avl_delete(replica_b);
+
+  // Hashes of maps cover the values, changed values are diffed with both records
+  AVLTree map_a = avl_new_map(sizeof(uint16_t), sizeof(uint64_t), cmpShort, NULL);
+  AVLTree map_b = avl_new_map(sizeof(uint16_t), sizeof(uint64_t), cmpShort, NULL);
+  error = avl_set_merkle(map_a, hashRecord);
+  assert(error == 0);
+  error = avl_set_merkle(map_b, hashRecord);
+  assert(error == 0);
+  for (uint16_t i = 0; i < 100; i++) {
+    uint64_t val = i;
+    error = avl_map_put(map_a, &i, &val);
+    assert(error == 0);
+    error = avl_map_put(map_b, &i, &val);
+    assert(error == 0);
+  }
+  uint16_t changed = 42;
+  uint64_t changed_value = 4242;
+  error = avl_map_put(map_b, &changed, &changed_value);
+  assert(error == 0);
+  diffs.count = 0;
+  assert(avl_diff(map_a, map_b, collectDiff, &diffs) == 0);
+  assert(diffs.count == 1 && diffs.keys[0] == 42 && diffs.sides[0] == 3);
+  avl_delete(map_a);
+  avl_delete(map_b);
+
+  // Adaptive trees keep small sets in a sorted array, switch to nodes past the threshold and back below half of it
+  struct budget small_budget = {.remaining = 1000};
+  AVLAllocator small_allocator = {budgetAlloc, budgetFree, &small_budget};
+  AVLTree adaptive = avl_new_with_allocator(sizeof(uint16_t), cmpShort, NULL, NULL, &small_allocator);
+  error = avl_set_adaptive(adaptive, 32);
+  assert(error == 0);
+  int array_live = small_budget.live;  // the tree and its array, records are added without any node allocation
+  for (uint16_t i = 0; i < 32; i++) {
+    uint16_t val = (i * 7) % 32;
+    error = avl_add(adaptive, &val);
+    assert(error == 0);
+  }
+  assert(small_budget.live == array_live && avl_get_size(adaptive) == 32 && avl_is_valid(adaptive));
+  error = avl_set_filter(adaptive, hashShort, 10);
+  assert(error == EINVAL);
+  error = avl_set_cache(adaptive, hashShort, 8);
+  assert(error == EINVAL);
+  uint16_t probe = 17;
+  assert(*(uint16_t*)avl_find_data(adaptive, &probe) == 17 && avl_get_height(adaptive) == 6);
+
+  // promotion failing for lack of memory leaves the records in the array
+  uint16_t extra = 32;
+  small_budget.remaining = 5;
+  error = avl_add(adaptive, &extra);
+  assert(error == ENOMEM);
+  assert(small_budget.live == array_live && avl_get_size(adaptive) == 32 && avl_is_valid(adaptive));
+  small_budget.remaining = 1000;
+  error = avl_add(adaptive, &extra);
+  assert(error == 0);
+  assert(small_budget.live == array_live + 33 && avl_is_valid(adaptive));
+
+  for (uint16_t i = 0; i < 17; i++) {
+    avl_remove(adaptive, &i);
+  }
+  assert(small_budget.live == array_live && avl_get_size(adaptive) == 16 && avl_is_valid(adaptive));
+  uint16_t small_popped;
+  ok = avl_pop_min(adaptive, &small_popped);
+  assert(ok && small_popped == 17);
+  ok = avl_pop_max(adaptive, &small_popped);
+  assert(ok && small_popped == 32);
+  uint16_t small_lo = 20, small_hi = 22;
+  removed = avl_remove_range(adaptive, &small_lo, &small_hi);
+  assert(removed == 3 && avl_get_size(adaptive) == 11);
+
+  // handing out a node pins the tree to nodes, that node then survives removals as in a regular tree
+  small_budget.remaining = 3;
+  errno = 0;
+  assert(avl_first(adaptive) == NULL && errno == ENOMEM);
+  assert(small_budget.live == array_live && avl_get_size(adaptive) == 11 && avl_is_valid(adaptive));
+  small_budget.remaining = 1000;
+  AVLNode pinned = avl_first(adaptive);
+  assert(*(uint16_t*)avl_node_get_data(pinned) == 18);
+  assert(small_budget.live == array_live - 1 + 11 && avl_is_valid(adaptive));  // the array is freed
+  for (uint16_t i = 23; i < 28; i++) {
+    avl_remove(adaptive, &i);
+  }
+  assert(avl_first(adaptive) == pinned && *(uint16_t*)avl_node_get_data(pinned) == 18);
+  assert(small_budget.live == array_live - 1 + 6 && avl_is_valid(adaptive));
+  avl_delete(adaptive);
+  assert(small_budget.live == 0);
+
+  // Incremental deletion frees a bounded number of nodes per call, background deletion returns right away
+  AVLTree stepped = avl_new(sizeof(uint16_t), cmpShort, countDelete);
+  for (uint16_t i = 0; i < 1000; i++) {
+    uint16_t val = (i * 151) % 1000;
+    error = avl_add(stepped, &val);
+    assert(error == 0);
+  }
+  int steps = 0;
+  while (!avl_delete_step(stepped, 100)) {
+    assert(deleted <= (steps + 1) * 100);
+    steps++;
+  }
+  assert(deleted == 1000 && steps >= 10 && steps < 20);  // each node is rotated at most once before it is freed
+
+  deleted = 0;
+  struct teardown teardown = {NULL, false};
+  AVLAllocator teardown_allocator = {teardownAlloc, teardownFree, &teardown};
+  AVLTree background = avl_new_with_allocator(sizeof(uint16_t), cmpShort, countDelete, NULL, &teardown_allocator);
+  teardown.tree = background;
+  for (uint16_t i = 0; i < 1000; i++) {
+    error = avl_add(background, &i);
+    assert(error == 0);
+  }
+  error = avl_delete_async(background);
+  assert(error == 0);
+  while (!atomic_load(&teardown.done)) sched_yield();
+  assert(deleted == 1000);
+
+  pthread_exit(NULL);  // the process ends once every thread has, deletion threads included
 }
@@ -0,0 +1,79 @@
+/**
+ * @file dary-heap-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "dary-heap.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int cmpShortPtr(const void* a, const void* b) {
+  uint16_t int_a = **(uint16_t**)a;
+  uint16_t int_b = **(uint16_t**)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+void freeShortPtr(void* data) { free(*(uint16_t**)data); }
+
+uint16_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+
+  // Emulating a situation that would need a cleanup function, like freeShortPtr here.
+  uint16_t* shortPtrs[18];
+  for (int i = 0; i < 18; i++) {
+    shortPtrs[i] = malloc(sizeof(uint16_t));
+    *shortPtrs[i] = testVals[i];
+  }
+
+  for (int arity = 2; arity <= 8; arity *= 2) {
+    DAryHeap heap = dheap_new(sizeof(uint16_t*), arity, cmpShortPtr, freeShortPtr);
+    assert(heap != NULL);
+    assert(dheap_peek(heap) == NULL);
+    ok = dheap_pop(heap, NULL);
+    assert(!ok);
+
+    for (int i = 0; i < 18; i++) {
+      dheap_push(heap, &shortPtrs[i]);
+      assert(dheap_is_valid(heap));
+    }
+    assert(dheap_get_size(heap) == 18);
+    assert(**(uint16_t**)dheap_peek(heap) == 4);
+
+    uint16_t previous = 0;
+    for (int i = 0; i < 18; i++) {
+      uint16_t* popped;
+      ok = dheap_pop(heap, &popped);
+      assert(ok);
+      printf("%d ", *popped);
+      assert(*popped >= previous);
+      previous = *popped;
+      assert(dheap_is_valid(heap));
+    }
+    printf("\n------------------\n");
+    assert(dheap_get_size(heap) == 0);
+    dheap_delete(heap);
+  }
+
+  // the last heap frees what it still holds
+  DAryHeap heap = dheap_new(sizeof(uint16_t*), 4, cmpShortPtr, freeShortPtr);
+  for (int i = 0; i < 18; i++) {
+    dheap_push(heap, &shortPtrs[i]);
+  }
+  ok = dheap_pop(heap, NULL);  // frees the 4
+  assert(ok);
+  assert(**(uint16_t**)dheap_peek(heap) == 7);
+  dheap_delete(heap);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file mapped-tree-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "mapped-tree.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_FILE "mapped-tree-test.tree"
+
+int cmpInt(const void* a, const void* b) {
+  uint32_t int_a = *(uint32_t*)a;
+  uint32_t int_b = *(uint32_t*)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+void printInt(const void* data, void* arg) { printf("%u ", *(uint32_t*)data); }
+
+void checkAscending(const void* data, void* arg) {
+  uint32_t* last = arg;
+  assert(*(uint32_t*)data > *last || *last == UINT32_MAX);
+  *last = *(uint32_t*)data;
+}
+
+uint32_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  int error;
+  bool ok;
+
+  unlink(TEST_FILE);
+
+  MappedTree tree = mapped_open(TEST_FILE, sizeof(uint32_t), cmpInt);
+  assert(tree != NULL);
+  assert(mapped_get_size(tree) == 0 && mapped_is_valid(tree));
+
+  for (int i = 0; i < 18; i++) {
+    error = mapped_add(tree, &testVals[i]);
+    assert(error == 0);
+    assert(mapped_is_valid(tree));
+  }
+  error = mapped_add(tree, &testVals[0]);  // adding duplicate should do nothing
+  assert(error == 0);
+  assert(mapped_get_size(tree) == 18);
+  mapped_range(tree, NULL, NULL, printInt, NULL);
+  printf("\n------------------\n");
+
+  assert(*(uint32_t*)mapped_find_data(tree, &testVals[5]) == 60);
+  uint32_t lo = 11, hi = 85, last = UINT32_MAX;
+  assert(mapped_range(tree, &lo, &hi, checkAscending, &last) == 9);
+  assert(last == 85);
+
+  for (int i = 0; i < 18; i += 2) {
+    ok = mapped_remove(tree, &testVals[i]);
+    assert(ok);
+    ok = mapped_remove(tree, &testVals[i]);
+    assert(!ok);
+    assert(mapped_is_valid(tree));
+  }
+  assert(mapped_get_size(tree) == 9);
+
+  // Freed nodes are reused before the file grows, then it doubles as needed, moving the mapping
+  size_t file_size = mapped_get_file_size(tree);
+  for (int i = 0; i < 18; i += 2) {
+    error = mapped_add(tree, &testVals[i]);
+    assert(error == 0);
+  }
+  assert(mapped_get_file_size(tree) == file_size);
+  for (uint32_t i = 100; i < 20000; i++) {
+    error = mapped_add(tree, &i);
+    assert(error == 0);
+  }
+  assert(mapped_get_file_size(tree) > file_size);
+  assert(mapped_is_valid(tree) && mapped_get_size(tree) == 18 + 19900);
+  for (uint32_t i = 100; i < 20000; i += 2) {
+    ok = mapped_remove(tree, &i);
+    assert(ok);
+  }
+  error = mapped_sync(tree);
+  assert(error == 0);
+  mapped_close(tree);
+
+  // Reopened as it was, without loading anything
+  tree = mapped_open(TEST_FILE, sizeof(uint32_t), cmpInt);
+  assert(tree != NULL);
+  assert(mapped_is_valid(tree) && mapped_get_size(tree) == 18 + 9950);
+  for (uint32_t i = 100; i < 20000; i++) {
+    assert((mapped_find_data(tree, &i) != NULL) == (i % 2 == 1));
+  }
+  for (int i = 0; i < 18; i++) {
+    assert(mapped_find_data(tree, &testVals[i]) != NULL);
+  }
+  last = UINT32_MAX;
+  assert(mapped_range(tree, NULL, NULL, checkAscending, &last) == 18 + 9950);
+  assert(last == 19999);
+  mapped_close(tree);
+
+  // Files of other data sizes, or not holding a tree, are refused
+  errno = 0;
+  assert(mapped_open(TEST_FILE, sizeof(uint64_t), cmpInt) == NULL && errno == EINVAL);
+  FILE* other = fopen(TEST_FILE, "w");
+  fputs("not a tree", other);
+  fclose(other);
+  assert(mapped_open(TEST_FILE, sizeof(uint32_t), cmpInt) == NULL && errno == EINVAL);
+  assert(mapped_open("missing-directory/mapped-tree-test.tree", sizeof(uint32_t), cmpInt) == NULL);
+
+  // Records larger than the initial file still fit, the file grows past doubling when needed
+  unlink(TEST_FILE);
+  tree = mapped_open(TEST_FILE, 9000, cmpInt);
+  assert(tree != NULL);
+  char big[9000] = {0};
+  for (uint32_t i = 0; i < 4; i++) {
+    memcpy(big, &i, sizeof(i));
+    error = mapped_add(tree, big);
+    assert(error == 0);
+  }
+  assert(mapped_is_valid(tree) && mapped_get_size(tree) == 4);
+  assert(mapped_get_file_size(tree) > 4 * 9000);
+  memcpy(big, &(uint32_t){2}, sizeof(uint32_t));
+  assert(mapped_find_data(tree, big) != NULL);
+  mapped_close(tree);
+
+  unlink(TEST_FILE);
+  return EXIT_SUCCESS;
+}
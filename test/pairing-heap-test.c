@@ -0,0 +1,78 @@
+/**
+ * @file pairing-heap-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "pairing-heap.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int cmpShort(const void* a, const void* b) {
+  uint16_t int_a = *(uint16_t*)a;
+  uint16_t int_b = *(uint16_t*)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+uint16_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+
+  PairingHeap heap = pheap_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(heap != NULL);
+  assert(pheap_peek(heap) == NULL);
+  ok = pheap_pop(heap, NULL);
+  assert(!ok);
+
+  PairingNode handles[18];
+  for (int i = 0; i < 18; i++) {
+    handles[i] = pheap_push(heap, &testVals[i]);
+    assert(pheap_is_valid(heap));
+  }
+  assert(pheap_get_size(heap) == 18);
+  assert(*(uint16_t*)pheap_node_get_data(pheap_peek(heap)) == 4);
+
+  uint16_t popped;
+  ok = pheap_pop(heap, &popped);
+  assert(ok && popped == 4);
+  assert(pheap_is_valid(heap));
+
+  // decrease keys deep in the heap, including to a new minimum
+  uint16_t smaller = 1;
+  pheap_decrease_key(heap, handles[13], &smaller);  // 93 -> 1
+  assert(pheap_is_valid(heap));
+  assert(pheap_peek(heap) == handles[13]);
+  smaller = 62;
+  pheap_decrease_key(heap, handles[1], &smaller);  // 85 -> 62
+  assert(pheap_is_valid(heap));
+  smaller = 0;
+  pheap_decrease_key(heap, handles[13], &smaller);  // root stays root
+  assert(pheap_is_valid(heap));
+
+  uint16_t expected[17] = {0, 7, 8, 9, 10, 15, 20, 30, 50, 60, 62, 65, 70, 80, 90, 91, 92};
+  for (int i = 0; i < 17; i++) {
+    ok = pheap_pop(heap, &popped);
+    assert(ok);
+    printf("%d ", popped);
+    assert(popped == expected[i]);
+    assert(pheap_is_valid(heap));
+  }
+  printf("\n------------------\n");
+  assert(pheap_get_size(heap) == 0);
+
+  for (int i = 0; i < 18; i++) {
+    pheap_push(heap, &testVals[i]);
+  }
+  pheap_delete(heap);
+
+  return EXIT_SUCCESS;
+}
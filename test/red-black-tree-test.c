@@ -8,10 +8,15 @@
 #include "red-black-tree.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void printShort(RBNode node) {
   if (rb_node_is_red(node)) {
@@ -64,9 +69,88 @@ int cmpShort(const void* a, const void* b) {
 
 void freeShortPtr(void* data) { free(*(uint16_t**)data); }
 
+int string_comparisons = 0;
+
+int cmpString(const void* a, const void* b) {
+  string_comparisons++;
+  return strcmp(a, b);
+}
+
+size_t stringSize(const void* data) { return strlen(data) + 1; }
+
+size_t hashShort(const void* data) { return *(uint16_t*)data; }
+
+atomic_int deleted = 0;
+
+void countDelete(void* data) { atomic_fetch_add(&deleted, 1); }
+
+// Sum augmentation, every node keeps the total of its subtree
+void sumShort(void* out, const void* data, const void* left, const void* right) {
+  *(uint64_t*)out = *(const uint64_t*)left + *(const uint16_t*)data + *(const uint64_t*)right;
+}
+
+uint64_t sumPresent(const bool* present, int lo, int hi) {
+  uint64_t sum = 0;
+  for (int i = lo; i <= hi; i++) {
+    if (present[i]) sum += i;
+  }
+  return sum;
+}
+
+// Allocator failing once its budget is spent, live counts the allocations not freed yet
+struct budget {
+  int remaining;
+  int live;
+};
+
+void* budgetAlloc(void* ctx, size_t size) {
+  struct budget* budget = ctx;
+  if (budget->remaining == 0) return NULL;
+  budget->remaining--;
+  budget->live++;
+  return malloc(size);
+}
+
+void budgetFree(void* ctx, void* ptr) {
+  struct budget* budget = ctx;
+  budget->live--;
+  free(ptr);
+}
+
+// Allocator raising done once the tree itself, the last block a deletion frees, is gone
+struct teardown {
+  void* tree;
+  atomic_bool done;
+};
+
+void* teardownAlloc(void* ctx, size_t size) { return malloc(size); }
+
+void teardownFree(void* ctx, void* ptr) {
+  struct teardown* teardown = ctx;
+  bool last = ptr == teardown->tree;
+  free(ptr);
+  if (last) atomic_store(&teardown->done, true);
+}
+
+void checkRanges(RBTree tree, const bool* present) {
+  for (int lo = 0; lo < 300; lo += 13) {
+    for (int hi = lo - 20; hi < 300; hi += 17) {
+      uint16_t l = lo, h = hi < 0 ? 0 : hi;
+      uint64_t sum;
+      assert(rb_range_aggregate(tree, &l, &h, &sum) == 0);
+      assert(sum == (hi < lo ? 0 : sumPresent(present, l, h)));
+    }
+  }
+}
+
 uint16_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
 
 int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+  int error;
+  size_t removed;
+
   // Emulating a situation that would need a cleanup function, like freeShortPtr here.
   uint16_t* shortPtrs[18];
   for (int i = 0; i < 18; i++) {
@@ -105,10 +189,513 @@ int main(void) {
   rb_add(tree2, &testVals[0]);
   rb_add(tree2, &testVals[1]);
   rb_add(tree2, &testVals[2]);
+  assert(rb_get_rotations(tree2) == 3);  // leaning 85 left, then 15, then splitting the red pair
   rb_remove(tree2, &testVals[3]);
   assert(rb_is_valid(tree2));
 
   rb_delete(tree2);
 
-  return EXIT_SUCCESS;
+  // Queue-like use, min/max are cached and popped without comparisons
+  RBTree queue = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(rb_first(queue) == NULL && rb_last(queue) == NULL);
+  for (int i = 0; i < 18; i++) {
+    rb_add(queue, &testVals[i]);
+  }
+  assert(*(uint16_t*)rb_node_get_data(rb_first(queue)) == 4);
+  assert(*(uint16_t*)rb_node_get_data(rb_last(queue)) == 93);
+
+  uint16_t popped, previous = 0;
+  while (rb_pop_min(queue, &popped)) {
+    assert(popped > previous);
+    previous = popped;
+    assert(rb_is_valid(queue));
+    if (rb_get_size(queue) == 9) break;
+  }
+  ok = rb_pop_max(queue, &popped);
+  assert(ok && popped == 93);
+  assert(*(uint16_t*)rb_node_get_data(rb_last(queue)) == 92);
+  while (rb_pop_max(queue, NULL)) {
+    assert(rb_is_valid(queue));
+  }
+  assert(rb_first(queue) == NULL && rb_last(queue) == NULL);
+  rb_delete(queue);
+
+  // Range sums kept up to date through rotations, successor copies and pops
+  uint64_t zero = 0;
+  RBAugment sum_augment = {sizeof(uint64_t), &zero, sumShort};
+  RBTree summed = rb_new_augmented(sizeof(uint16_t), cmpShort, NULL, &sum_augment);
+  bool present[300] = {false};
+  uint64_t total;
+  queue = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(rb_range_aggregate(queue, &testVals[0], &testVals[1], &total) == EINVAL);  // not augmented
+  rb_delete(queue);
+
+  for (uint16_t i = 0; i < 300; i++) {
+    uint16_t val = (i * 151) % 300;
+    rb_add(summed, &val);
+    present[val] = true;
+  }
+  assert(rb_is_valid(summed));
+  checkRanges(summed, present);
+
+  for (uint16_t i = 0; i < 300; i += 3) {
+    rb_remove(summed, &i);
+    present[i] = false;
+  }
+  uint16_t popped_min, popped_max;
+  ok = rb_pop_min(summed, &popped_min);
+  assert(ok);
+  ok = rb_pop_max(summed, &popped_max);
+  assert(ok);
+  present[popped_min] = present[popped_max] = false;
+  assert(rb_is_valid(summed));
+  checkRanges(summed, present);
+
+  // Range removal joins what is left around the removed range
+  uint16_t lo = 100, hi = 180;
+  size_t in_range = 0;
+  for (int i = lo; i <= hi; i++) {
+    if (present[i]) in_range++;
+    present[i] = false;
+  }
+  removed = rb_remove_range(summed, &lo, &hi);
+  assert(removed == in_range);
+  removed = rb_remove_range(summed, &hi, &lo);
+  assert(removed == 0);
+  assert(rb_is_valid(summed));
+  checkRanges(summed, present);
+
+  lo = 0;
+  hi = 299;
+  assert(rb_range_aggregate(summed, &lo, &hi, &total) == 0 && total == sumPresent(present, 0, 299));
+  rb_delete(summed);
+
+  // Removed ranges go through the deletion function
+  RBTree owned = rb_new(sizeof(uint16_t*), cmpShortPtr, freeShortPtr);
+  for (int i = 0; i < 18; i++) {
+    uint16_t* owned_val = malloc(sizeof(uint16_t));
+    *owned_val = testVals[i];
+    rb_add(owned, &owned_val);
+  }
+  uint16_t low = 10, high = 70;
+  uint16_t *low_ptr = &low, *high_ptr = &high;
+  removed = rb_remove_range(owned, &low_ptr, &high_ptr);
+  assert(removed == 8);
+  assert(rb_get_size(owned) == 10 && rb_is_valid(owned));
+  assert(**(uint16_t**)rb_node_get_data(rb_first(owned)) == 4);
+  assert(**(uint16_t**)rb_node_get_data(rb_last(owned)) == 93);
+  rb_delete(owned);
+
+  // Batched lookups give the same answers as one by one lookups, misses included
+  RBTree batched = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  uint16_t wanted[100];
+  void* results[100];
+  for (uint16_t i = 0; i < 100; i++) {
+    wanted[i] = (i * 37) % 150;
+    if (i % 2) rb_add(batched, &i);
+  }
+  assert(rb_find_batch(batched, wanted, 0, results) == 0);
+  size_t found = rb_find_batch(batched, wanted, 100, results);
+  size_t expected = 0;
+  for (int i = 0; i < 100; i++) {
+    assert(results[i] == rb_find_data(batched, &wanted[i]));
+    if (results[i]) expected++;
+  }
+  assert(found == expected && found > 0);
+  rb_delete(batched);
+
+  // Insertion from either edge, with keys arriving slightly out of order
+  RBTree edged = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  for (uint16_t i = 0; i < 200; i++) {
+    uint16_t val = 1000 + (i ^ 1);
+    error = rb_add_edge(edged, false, &val);
+    assert(error == 0);
+    val = 999 - (i ^ 1);
+    error = rb_add_edge(edged, true, &val);
+    assert(error == 0);
+    assert(rb_is_valid(edged));
+  }
+  uint16_t middle = 1000;
+  error = rb_add_edge(edged, false, &middle);  // duplicate
+  assert(error == 0);
+  assert(rb_get_size(edged) == 400);
+  assert(*(uint16_t*)rb_node_get_data(rb_first(edged)) == 800);
+  assert(*(uint16_t*)rb_node_get_data(rb_last(edged)) == 1199);
+  for (uint16_t i = 800; i < 1200; i++) {
+    assert(rb_find_data(edged, &i) != NULL);
+  }
+  rb_delete(edged);
+
+  // Compaction moves every node into one region, the tree stays usable and can be compacted in steps
+  RBTree compacted = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  void* spacers[200];
+  for (uint16_t i = 0; i < 200; i++) {
+    uint16_t val = (i * 71) % 200;
+    rb_add(compacted, &val);
+    spacers[i] = malloc(64);  // scatters the nodes across the heap
+  }
+  RBFootprint before, after;
+  error = rb_compact(compacted, &before, &after);
+  assert(error == 0);
+  assert(before.nodes == 200 && before.allocations == 200);
+  assert(after.nodes == 200 && after.allocations == 1 && after.span < before.span);
+  assert(rb_is_valid(compacted));
+
+  for (uint16_t i = 0; i < 200; i += 2) {
+    rb_remove(compacted, &i);
+  }
+  error = rb_compact_begin(compacted);
+  assert(error == 0);
+  bool done = false;
+  uint16_t next = 200;
+  while (!done) {
+    error = rb_compact_step(compacted, 16, &done);
+    assert(error == 0);
+    error = rb_add(compacted, &next);  // the tree can change between steps
+    assert(error == 0);
+    next++;
+    assert(rb_is_valid(compacted));
+  }
+  rb_get_footprint(compacted, &after);
+  assert(after.nodes == (size_t)rb_get_size(compacted) && after.nodes == 100u + (next - 200u));
+  for (uint16_t i = 1; i < 200; i += 2) {
+    assert(rb_find_data(compacted, &i) != NULL);
+  }
+  for (uint16_t i = 200; i < next; i++) {
+    assert(rb_find_data(compacted, &i) != NULL);
+  }
+  for (int i = 0; i < 200; i++) {
+    free(spacers[i]);
+  }
+  rb_delete(compacted);
+
+  // Allocation failures are reported instead of exiting, and leave the tree untouched
+  struct budget budget = {0, 0};
+  RBAllocator failing = {budgetAlloc, budgetFree, &budget};
+  assert(rb_new_with_allocator(sizeof(uint16_t), cmpShort, NULL, NULL, &failing) == NULL);
+
+  budget.remaining = 1;
+  RBTree bounded = rb_new_with_allocator(sizeof(uint16_t), cmpShort, NULL, NULL, &failing);
+  assert(bounded != NULL);
+  error = rb_add(bounded, &testVals[0]);
+  assert(error == ENOMEM);
+  assert(rb_get_size(bounded) == 0 && rb_first(bounded) == NULL);
+
+  budget.remaining = 9;
+  for (int i = 0; i < 9; i++) {
+    error = rb_add(bounded, &testVals[i]);
+    assert(error == 0);
+  }
+  error = rb_add(bounded, &testVals[0]);  // duplicates need no node
+  assert(error == 0);
+  error = rb_add(bounded, &testVals[9]);
+  assert(error == ENOMEM);
+  assert(rb_get_size(bounded) == 9 && rb_is_valid(bounded) && rb_find_data(bounded, &testVals[9]) == NULL);
+
+  rb_remove(bounded, &testVals[0]);
+  budget.remaining = 1;
+  error = rb_add(bounded, &testVals[9]);
+  assert(error == 0);
+  assert(rb_get_size(bounded) == 9 && rb_is_valid(bounded));
+  rb_delete(bounded);
+  assert(budget.live == 0);
+
+  // Maps compare keys only, values are overwritten in place and records are the key followed by the value
+  RBTree map = rb_new_map(sizeof(uint16_t), sizeof(uint64_t), cmpShort, NULL);
+  assert(map != NULL);
+  for (uint16_t i = 0; i < 100; i++) {
+    uint64_t value = i * 1000;
+    error = rb_map_put(map, &i, &value);
+    assert(error == 0);
+  }
+  for (uint16_t i = 0; i < 100; i += 2) {
+    uint64_t value = i + 1;
+    error = rb_map_put(map, &i, &value);
+    assert(error == 0);
+  }
+  assert(rb_get_size(map) == 100 && rb_is_valid(map));
+  for (uint16_t i = 0; i < 100; i++) {
+    uint64_t value;
+    memcpy(&value, rb_map_get(map, &i), sizeof(value));
+    assert(value == (i % 2 ? i * 1000u : i + 1u));
+  }
+  uint16_t absent = 100;
+  assert(rb_map_get(map, &absent) == NULL);
+  assert(rb_node_get_value(map, rb_first(map)) == (char*)rb_node_get_data(rb_first(map)) + sizeof(uint16_t));
+  for (uint16_t i = 0; i < 100; i += 3) {
+    rb_remove(map, &i);
+  }
+  absent = 30;
+  assert(rb_get_size(map) == 66 && rb_is_valid(map) && rb_map_get(map, &absent) == NULL);
+  unsigned char record[sizeof(uint16_t) + sizeof(uint64_t)];
+  uint16_t key;
+  uint64_t value;
+  ok = rb_pop_max(map, record);
+  assert(ok);
+  memcpy(&key, record, sizeof(key));
+  memcpy(&value, record + sizeof(key), sizeof(value));
+  assert(key == 98 && value == 99);
+  rb_delete(map);
+
+  // Maps can take their memory from any allocator, counting it like other trees
+  budget.remaining = 1000;
+  RBTree counted_map = rb_new_map_with_allocator(sizeof(uint16_t), sizeof(uint64_t), cmpShort, NULL, &failing);
+  assert(counted_map != NULL);
+  for (uint16_t i = 0; i < 10; i++) {
+    uint64_t value = i * 7;
+    error = rb_map_put(counted_map, &i, &value);
+    assert(error == 0);
+  }
+  assert(budget.live == 11 && rb_is_valid(counted_map));
+  uint16_t counted_key = 3;
+  uint64_t counted_value;
+  memcpy(&counted_value, rb_map_get(counted_map, &counted_key), sizeof(counted_value));
+  assert(counted_value == 21);
+  rb_delete(counted_map);
+  assert(budget.live == 0);
+
+  // Strings stored inline in nodes of their exact size, the stored prefixes settle comparisons of differing strings
+  const char* words[8] = {"pear", "apple", "fig", "banana", "cherry", "a", "apricot-jam", "applesauce"};
+  assert(rb_new_variable(17, stringSize, cmpString, NULL) == NULL);
+  RBTree strings = rb_new_variable(8, stringSize, cmpString, NULL);
+  for (int i = 0; i < 8; i++) {
+    error = rb_add(strings, words[i]);
+    assert(error == 0);
+  }
+  error = rb_add(strings, "fig");  // duplicate
+  assert(error == 0);
+  assert(rb_get_size(strings) == 8 && rb_is_valid(strings));
+  assert(strcmp(rb_node_get_data(rb_first(strings)), "a") == 0);
+  assert(rb_node_get_data_size(strings, rb_last(strings)) == sizeof("pear"));
+
+  string_comparisons = 0;
+  assert(strcmp(rb_find_data(strings, "fig"), "fig") == 0);
+  assert(rb_find_data(strings, "figs") == NULL);
+  assert(string_comparisons == 1);  // only the node holding fig shares a prefix with the searched strings
+
+  const void* batch_words[3] = {"banana", "kiwi", "a"};
+  void* batch_results[3];
+  assert(rb_find_batch(strings, batch_words, 3, batch_results) == 2 && batch_results[1] == NULL);
+
+  for (int i = 0; i < 8; i += 2) {
+    rb_remove(strings, words[i]);
+    assert(rb_is_valid(strings) && rb_find_data(strings, words[i]) == NULL);
+  }
+  assert(strcmp(rb_find_data(strings, "apple"), "apple") == 0);
+  char popped_word[16];
+  ok = rb_pop_max(strings, popped_word);
+  assert(ok && strcmp(popped_word, "banana") == 0);
+  rb_delete(strings);
+
+  // Classic bottom-up balancing, with red right links and a bounded number of rotations per update
+  RBTree classic = rb_new_augmented(sizeof(uint16_t), cmpShort, NULL, &sum_augment);
+  error = rb_set_classic(classic, true);
+  assert(error == 0);
+  bool in_classic[300] = {false};
+  for (uint16_t i = 0; i < 300; i++) {
+    uint16_t val = (i * 151) % 300;
+    size_t rotations = rb_get_rotations(classic);
+    error = rb_add(classic, &val);
+    assert(error == 0);
+    assert(rb_get_rotations(classic) - rotations <= 2);
+    in_classic[val] = true;
+  }
+  error = rb_set_classic(classic, false);  // not empty
+  assert(error == EINVAL);
+  assert(rb_is_valid(classic) && rb_get_size(classic) == 300);
+  checkRanges(classic, in_classic);
+
+  for (uint16_t i = 0; i < 300; i += 3) {
+    size_t rotations = rb_get_rotations(classic);
+    rb_remove(classic, &i);
+    assert(rb_get_rotations(classic) - rotations <= 3);
+    assert(rb_is_valid(classic));
+    in_classic[i] = false;
+  }
+  ok = rb_pop_min(classic, &popped_min);
+  assert(ok);
+  ok = rb_pop_max(classic, &popped_max);
+  assert(ok);
+  assert(popped_min == 1 && popped_max == 299);
+  in_classic[popped_min] = in_classic[popped_max] = false;
+  for (uint16_t i = 0; i < 300; i += 7) {
+    rb_add_edge(classic, false, &i);
+    in_classic[i] = true;
+  }
+  lo = 100;
+  hi = 180;
+  for (int i = lo; i <= hi; i++) in_classic[i] = false;
+  rb_remove_range(classic, &lo, &hi);
+  assert(rb_is_valid(classic));
+  checkRanges(classic, in_classic);
+  rb_delete(classic);
+
+  // Bloom filter in front of lookups, misses are mostly answered without a descent
+  RBTree filtered = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  RBFilterStats stats;
+  rb_get_filter_stats(filtered, &stats);
+  assert(stats.bytes == 0);
+  error = rb_set_filter(filtered, hashShort, 0);
+  assert(error == EINVAL);
+  error = rb_set_filter(filtered, hashShort, 10);
+  assert(error == 0);
+  for (uint16_t i = 0; i < 2000; i += 2) {
+    error = rb_add(filtered, &i);
+    assert(error == 0);
+  }
+  for (uint16_t i = 0; i < 4000; i++) {
+    assert((rb_find_data(filtered, &i) != NULL) == (i < 2000 && i % 2 == 0));
+  }
+  rb_get_filter_stats(filtered, &stats);
+  assert(stats.rebuilds > 0);  // grown along with the tree
+  assert(stats.elements == 1000 && stats.lookups == 4000);
+  assert(stats.rejected + stats.false_positives == 3000);
+  assert(stats.measured_fpr < 0.05 && stats.expected_fpr < 0.05);
+
+  uint16_t filtered_lo = 0, filtered_hi = 1499;
+  removed = rb_remove_range(filtered, &filtered_lo, &filtered_hi);
+  assert(removed == 750);
+  rb_get_filter_stats(filtered, &stats);
+  assert(stats.elements == 250);  // rebuilt once removed elements outnumbered the remaining ones
+  uint16_t filtered_keys[4] = {1500, 1501, 10, 1998};
+  void* filtered_results[4];
+  assert(rb_find_batch(filtered, filtered_keys, 4, filtered_results) == 2);
+  assert(filtered_results[0] != NULL && filtered_results[1] == NULL && filtered_results[2] == NULL);
+  error = rb_set_filter(filtered, NULL, 0);
+  assert(error == 0);
+  rb_get_filter_stats(filtered, &stats);
+  assert(stats.bytes == 0 && rb_find_data(filtered, &filtered_keys[3]) != NULL);
+  rb_delete(filtered);
+
+  // Lookup cache, hot keys are found without a descent and removed nodes are dropped from it
+  RBTree cached = rb_new(sizeof(uint16_t), cmpShort, NULL);
+  RBCacheStats cache_stats;
+  error = rb_set_cache(cached, hashShort, 0);
+  assert(error == EINVAL);
+  error = rb_set_cache(cached, hashShort, 6);
+  assert(error == 0);
+  rb_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.entries == 8);
+  for (uint16_t i = 0; i < 100; i++) {
+    error = rb_add(cached, &i);
+    assert(error == 0);
+  }
+  for (int round = 0; round < 10; round++) {  // keys 1 to 4 land in distinct entries
+    for (uint16_t i = 1; i <= 4; i++) {
+      assert(*(uint16_t*)rb_find_data(cached, &i) == i);
+    }
+  }
+  rb_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.lookups == 40 && cache_stats.hits == 36 && cache_stats.hit_rate == 0.9);
+
+  uint16_t hot = 2, inner = 50;
+  assert(rb_find_data(cached, &inner) != NULL);  // cached, then removed with a successor taking its place
+  rb_remove(cached, &hot);
+  rb_remove(cached, &inner);
+  rb_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.invalidations == 2);
+  assert(rb_find_data(cached, &hot) == NULL && rb_find_data(cached, &inner) == NULL);
+  uint16_t successor = 51;
+  assert(*(uint16_t*)rb_find_data(cached, &successor) == 51);
+
+  error = rb_compact(cached, NULL, NULL);  // cached nodes follow their data
+  assert(error == 0);
+  hot = 1;
+  assert(*(uint16_t*)rb_find_data(cached, &hot) == 1);
+  rb_get_cache_stats(cached, &cache_stats);
+  assert(cache_stats.hits == 37);
+  rb_delete(cached);
+
+  // Adaptive trees keep small sets in a sorted array, switch to nodes past the threshold and back below half of it
+  struct budget small_budget = {.remaining = 1000};
+  RBAllocator small_allocator = {budgetAlloc, budgetFree, &small_budget};
+  RBTree adaptive = rb_new_with_allocator(sizeof(uint16_t), cmpShort, NULL, NULL, &small_allocator);
+  error = rb_set_adaptive(adaptive, 32);
+  assert(error == 0);
+  int array_live = small_budget.live;  // the tree and its array, records are added without any node allocation
+  for (uint16_t i = 0; i < 32; i++) {
+    uint16_t val = (i * 7) % 32;
+    error = rb_add(adaptive, &val);
+    assert(error == 0);
+  }
+  assert(small_budget.live == array_live && rb_get_size(adaptive) == 32 && rb_is_valid(adaptive));
+  error = rb_set_filter(adaptive, hashShort, 10);
+  assert(error == EINVAL);
+  error = rb_set_cache(adaptive, hashShort, 8);
+  assert(error == EINVAL);
+  error = rb_set_classic(adaptive, true);  // records in the array count, though there is no root
+  assert(error == EINVAL);
+  uint16_t probe = 17;
+  assert(*(uint16_t*)rb_find_data(adaptive, &probe) == 17 && rb_get_height(adaptive) == 6);
+
+  // promotion failing for lack of memory leaves the records in the array
+  uint16_t extra = 32;
+  small_budget.remaining = 5;
+  error = rb_add(adaptive, &extra);
+  assert(error == ENOMEM);
+  assert(small_budget.live == array_live && rb_get_size(adaptive) == 32 && rb_is_valid(adaptive));
+  small_budget.remaining = 1000;
+  error = rb_add(adaptive, &extra);
+  assert(error == 0);
+  assert(small_budget.live == array_live + 33 && rb_is_valid(adaptive));
+
+  for (uint16_t i = 0; i < 17; i++) {
+    rb_remove(adaptive, &i);
+  }
+  assert(small_budget.live == array_live && rb_get_size(adaptive) == 16 && rb_is_valid(adaptive));
+  uint16_t small_popped;
+  ok = rb_pop_min(adaptive, &small_popped);
+  assert(ok && small_popped == 17);
+  ok = rb_pop_max(adaptive, &small_popped);
+  assert(ok && small_popped == 32);
+  uint16_t small_lo = 20, small_hi = 22;
+  removed = rb_remove_range(adaptive, &small_lo, &small_hi);
+  assert(removed == 3 && rb_get_size(adaptive) == 11);
+
+  // handing out a node pins the tree to nodes, that node then survives removals as in a regular tree
+  small_budget.remaining = 3;
+  errno = 0;
+  assert(rb_first(adaptive) == NULL && errno == ENOMEM);
+  assert(small_budget.live == array_live && rb_get_size(adaptive) == 11 && rb_is_valid(adaptive));
+  small_budget.remaining = 1000;
+  RBNode pinned = rb_first(adaptive);
+  assert(*(uint16_t*)rb_node_get_data(pinned) == 18);
+  assert(small_budget.live == array_live - 1 + 11 && rb_is_valid(adaptive));  // the array is freed
+  for (uint16_t i = 23; i < 28; i++) {
+    rb_remove(adaptive, &i);
+  }
+  assert(rb_first(adaptive) == pinned && *(uint16_t*)rb_node_get_data(pinned) == 18);
+  assert(small_budget.live == array_live - 1 + 6 && rb_is_valid(adaptive));
+  rb_delete(adaptive);
+  assert(small_budget.live == 0);
+
+  // Incremental deletion frees a bounded number of nodes per call, background deletion returns right away
+  RBTree stepped = rb_new(sizeof(uint16_t), cmpShort, countDelete);
+  for (uint16_t i = 0; i < 1000; i++) {
+    uint16_t val = (i * 151) % 1000;
+    error = rb_add(stepped, &val);
+    assert(error == 0);
+  }
+  int steps = 0;
+  while (!rb_delete_step(stepped, 100)) {
+    assert(deleted <= (steps + 1) * 100);
+    steps++;
+  }
+  assert(deleted == 1000 && steps >= 10 && steps < 20);  // each node is rotated at most once before it is freed
+
+  deleted = 0;
+  struct teardown teardown = {NULL, false};
+  RBAllocator teardown_allocator = {teardownAlloc, teardownFree, &teardown};
+  RBTree background = rb_new_with_allocator(sizeof(uint16_t), cmpShort, countDelete, NULL, &teardown_allocator);
+  teardown.tree = background;
+  for (uint16_t i = 0; i < 1000; i++) {
+    error = rb_add(background, &i);
+    assert(error == 0);
+  }
+  error = rb_delete_async(background);
+  assert(error == 0);
+  while (!atomic_load(&teardown.done)) sched_yield();
+  assert(deleted == 1000);
+
+  pthread_exit(NULL);  // the process ends once every thread has, deletion threads included
 }
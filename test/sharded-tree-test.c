@@ -0,0 +1,200 @@
+/**
+ * @file sharded-tree-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "sharded-tree.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SHARDS 8
+#define THREADS 8
+#define KEYS_PER_THREAD 20000
+
+int cmpInt(const void* a, const void* b) {
+  uint32_t int_a = *(uint32_t*)a;
+  uint32_t int_b = *(uint32_t*)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+int cmpIntPtr(const void* a, const void* b) { return cmpInt(*(uint32_t**)a, *(uint32_t**)b); }
+
+void freeIntPtr(void* data) { free(*(uint32_t**)data); }
+
+atomic_int deleted = 0;
+
+void countDelete(void* data) { atomic_fetch_add(&deleted, 1); }
+
+void printInt(const void* data, void* arg) { printf("%u ", *(uint32_t*)data); }
+
+void checkAscending(const void* data, void* arg) {
+  uint32_t* last = arg;
+  assert(*(uint32_t*)data > *last || *last == UINT32_MAX);
+  *last = *(uint32_t*)data;
+}
+
+ShardedTree shared;
+
+// Every thread adds its own interleaved keys in ascending order, so the last shard keeps growing and gets rebalanced
+// while the others write, then removes the even ones
+void* stress(void* arg) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  int error;
+  bool ok;
+
+  uint32_t id = (uint32_t)(uintptr_t)arg;
+
+  for (uint32_t i = 0; i < KEYS_PER_THREAD; i++) {
+    uint32_t val = i * THREADS + id;
+    error = sharded_add(shared, &val);
+    assert(error == 0);
+    assert(sharded_find_data(shared, &val, NULL));
+  }
+
+  for (uint32_t i = 0; i < KEYS_PER_THREAD; i += 2) {
+    uint32_t val = i * THREADS + id;
+    ok = sharded_remove(shared, &val);
+    assert(ok);
+    assert(!sharded_find_data(shared, &val, NULL));
+  }
+  return NULL;
+}
+
+uint32_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  int error;
+  bool ok;
+
+  ShardedTree tree = sharded_new(sizeof(uint32_t), 4, cmpInt, countDelete);
+  assert(tree != NULL);
+  assert(sharded_get_size(tree) == 0);
+  assert(sharded_get_shard_count(tree) == 4);
+
+  for (int i = 0; i < 18; i++) {
+    error = sharded_add(tree, &testVals[i]);
+    assert(error == 0);
+    assert(sharded_is_valid(tree));
+  }
+  error = sharded_add(tree, &testVals[0]);  // adding duplicate should do nothing
+  assert(error == 0);
+  assert(sharded_get_size(tree) == 18);
+  assert(sharded_get_shard_size(tree, 0) == 18);  // nothing moves before the first rebalancing
+
+  error = sharded_rebalance(tree);
+  assert(error == 0);
+  assert(sharded_is_valid(tree));
+  for (size_t i = 0; i < 4; i++) {
+    assert(sharded_get_shard_size(tree, i) == 4 || sharded_get_shard_size(tree, i) == 5);
+  }
+  sharded_range(tree, NULL, NULL, printInt, NULL);
+  printf("\n------------------\n");
+
+  uint32_t found = 0;
+  assert(sharded_find_data(tree, &testVals[5], &found));
+  assert(found == 60);
+
+  // in-order iteration and range scans cross the shard boundaries
+  uint32_t last = UINT32_MAX;
+  assert(sharded_range(tree, NULL, NULL, checkAscending, &last) == 18);
+  assert(last == 93);
+  uint32_t lo = 11, hi = 85;
+  last = UINT32_MAX;
+  assert(sharded_range(tree, &lo, &hi, checkAscending, &last) == 9);
+  assert(last == 85);
+
+  uint32_t next = 0, count = 0;
+  bool more = sharded_next(tree, NULL, &next);
+  while (more) {
+    count++;
+    uint32_t current = next;
+    more = sharded_next(tree, &current, &next);
+    assert(!more || next > current);
+  }
+  assert(count == 18 && next == 93);
+
+  for (int i = 0; i < 18; i += 2) {
+    ok = sharded_remove(tree, &testVals[i]);
+    assert(ok);
+    ok = sharded_remove(tree, &testVals[i]);
+    assert(!ok);
+    assert(sharded_is_valid(tree));
+  }
+  sharded_range(tree, NULL, NULL, printInt, NULL);
+  printf("\n------------------\n");
+  assert(sharded_get_size(tree) == 9);
+
+  sharded_delete(tree);
+  assert(deleted == 18);
+
+  // Ascending inserts all land in the last shard, which triggers rebalancing
+  ShardedTree skewed = sharded_new(sizeof(uint32_t), SHARDS, cmpInt, NULL);
+  for (uint32_t i = 0; i < 10000; i++) {
+    error = sharded_add(skewed, &i);
+    assert(error == 0);
+  }
+  assert(sharded_is_valid(skewed));
+  assert(sharded_get_rebalances(skewed) > 0);
+  for (size_t i = 0; i < SHARDS; i++) {
+    assert(sharded_get_shard_size(skewed, i) <= 2 * 10000 / SHARDS + 64);
+  }
+  sharded_delete(skewed);
+
+  // Owned data: removing the smallest element of a shard replaces the bound that was copied from it
+  ShardedTree owned = sharded_new(sizeof(uint32_t*), 4, cmpIntPtr, freeIntPtr);
+  for (uint32_t i = 0; i < 400; i++) {
+    uint32_t* val = malloc(sizeof(uint32_t));
+    *val = i;
+    error = sharded_add(owned, &val);
+    assert(error == 0);
+  }
+  error = sharded_rebalance(owned);
+  assert(error == 0);
+  for (uint32_t i = 0; i < 400; i += 3) {
+    uint32_t* key = &i;
+    ok = sharded_remove(owned, &key);
+    assert(ok);
+    assert(sharded_is_valid(owned));
+  }
+  assert(sharded_get_size(owned) == 400 - 134);
+  sharded_delete(owned);
+
+  // --- Concurrent stress test ---
+
+  deleted = 0;
+  shared = sharded_new(sizeof(uint32_t), SHARDS, cmpInt, countDelete);
+  pthread_t threads[THREADS];
+  for (uintptr_t i = 0; i < THREADS; i++) {
+    error = pthread_create(&threads[i], NULL, stress, (void*)i);
+    assert(error == 0);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  assert(sharded_is_valid(shared));
+  assert(sharded_get_size(shared) == THREADS * KEYS_PER_THREAD / 2);
+  assert(sharded_get_rebalances(shared) > 0);
+
+  last = UINT32_MAX;
+  sharded_range(shared, NULL, NULL, checkAscending, &last);
+  for (uint32_t i = 0; i < THREADS * KEYS_PER_THREAD; i++) {
+    assert(sharded_find_data(shared, &i, NULL) == (i / THREADS) % 2);
+  }
+
+  sharded_delete(shared);
+  assert(deleted == THREADS * KEYS_PER_THREAD);
+
+  return EXIT_SUCCESS;
+}
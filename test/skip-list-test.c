@@ -0,0 +1,147 @@
+/**
+ * @file skip-list-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "skip-list.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THREADS 8
+#define KEYS_PER_THREAD 20000
+
+int cmpInt(const void* a, const void* b) {
+  uint32_t int_a = *(uint32_t*)a;
+  uint32_t int_b = *(uint32_t*)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+atomic_int deleted = 0;
+
+void countDelete(void* data) { atomic_fetch_add(&deleted, 1); }
+
+void printInt(const void* data, void* arg) { printf("%u ", *(uint32_t*)data); }
+
+void checkAscending(const void* data, void* arg) {
+  uint32_t* last = arg;
+  assert(*(uint32_t*)data > *last || *last == UINT32_MAX);
+  *last = *(uint32_t*)data;
+}
+
+SkipList shared;
+
+// Every thread adds its own interleaved keys, then removes the even ones while also fighting over a shared key range
+void* stress(void* arg) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+
+  uint32_t id = (uint32_t)(uintptr_t)arg;
+
+  for (uint32_t i = 0; i < KEYS_PER_THREAD; i++) {
+    uint32_t val = i * THREADS + id;
+    ok = skiplist_add(shared, &val);
+    assert(ok);
+    assert(skiplist_find_data(shared, &val, NULL));
+  }
+
+  for (uint32_t i = 0; i < KEYS_PER_THREAD; i += 2) {
+    uint32_t val = i * THREADS + id;
+    ok = skiplist_remove(shared, &val);
+    assert(ok);
+    assert(!skiplist_find_data(shared, &val, NULL));
+  }
+
+  // contended keys, every thread adds and removes the same ones
+  for (uint32_t round = 0; round < 50; round++) {
+    for (uint32_t i = 0; i < 100; i++) {
+      uint32_t val = THREADS * KEYS_PER_THREAD + i;
+      skiplist_add(shared, &val);
+      skiplist_remove(shared, &val);
+    }
+  }
+  return NULL;
+}
+
+uint32_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+  int error;
+
+  SkipList list = skiplist_new(sizeof(uint32_t), cmpInt, countDelete);
+  assert(list != NULL);
+  assert(skiplist_get_size(list) == 0);
+
+  for (int i = 0; i < 18; i++) {
+    ok = skiplist_add(list, &testVals[i]);
+    assert(ok);
+    assert(skiplist_is_valid(list));
+  }
+  skiplist_foreach(list, printInt, NULL);
+  printf("\n------------------\n");
+
+  ok = skiplist_add(list, &testVals[0]);  // adding duplicate should do nothing
+  assert(!ok);
+  assert(skiplist_get_size(list) == 18);
+
+  uint32_t found = 0;
+  assert(skiplist_find_data(list, &testVals[5], &found));
+  assert(found == 60);
+
+  uint32_t last = UINT32_MAX;
+  skiplist_foreach(list, checkAscending, &last);
+  assert(last == 93);
+
+  for (int i = 0; i < 18; i += 2) {
+    ok = skiplist_remove(list, &testVals[i]);
+    assert(ok);
+    ok = skiplist_remove(list, &testVals[i]);
+    assert(!ok);
+    assert(skiplist_is_valid(list));
+  }
+  skiplist_foreach(list, printInt, NULL);
+  printf("\n------------------\n");
+  assert(skiplist_get_size(list) == 9);
+
+  skiplist_delete(list);
+  assert(deleted == 18);
+
+  // --- Concurrent stress test ---
+
+  deleted = 0;
+  shared = skiplist_new(sizeof(uint32_t), cmpInt, countDelete);
+  pthread_t threads[THREADS];
+  for (uintptr_t i = 0; i < THREADS; i++) {
+    error = pthread_create(&threads[i], NULL, stress, (void*)i);
+    assert(error == 0);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  assert(skiplist_is_valid(shared));
+  assert(skiplist_get_size(shared) == THREADS * KEYS_PER_THREAD / 2);
+
+  last = UINT32_MAX;
+  skiplist_foreach(shared, checkAscending, &last);
+  for (uint32_t i = 0; i < THREADS * KEYS_PER_THREAD; i++) {
+    assert(skiplist_find_data(shared, &i, NULL) == (i / THREADS) % 2);
+  }
+
+  int added = THREADS * KEYS_PER_THREAD + 50 * 100 * THREADS;  // upper bound, contended adds may fail
+  skiplist_delete(shared);
+  assert(deleted >= THREADS * KEYS_PER_THREAD && deleted <= added);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file splay-tree-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "splay-tree.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void printShort(SplayNode node) { printf("%d\n", **(uint16_t**)(splay_node_get_data(node))); }
+
+void printTree(SplayNode node, int current_depth, int LR, void printfunc(SplayNode tree)) {
+  if (current_depth > 20) {
+    printf("Houston, we have a problem");
+    return;
+  }
+  assert(LR == 0 || LR == -1 || LR == 1);
+  if (node) {
+    printTree(splay_node_get_left(node), current_depth + 1, 1, printfunc);
+    for (int i = 0; i < current_depth; i++) {
+      printf("    ");
+    }
+    switch (LR) {
+      case -1:
+        printf("\\");
+        break;
+      case 1:
+        printf("/");
+      default:
+        break;
+    }
+    printfunc(node);
+    printTree(splay_node_get_right(node), current_depth + 1, -1, printfunc);
+  }
+}
+
+int cmpShortPtr(const void* a, const void* b) {
+  uint16_t int_a = **(uint16_t**)a;
+  uint16_t int_b = **(uint16_t**)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+int cmpShort(const void* a, const void* b) {
+  uint16_t int_a = *(uint16_t*)a;
+  uint16_t int_b = *(uint16_t*)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+void freeShortPtr(void* data) { free(*(uint16_t**)data); }
+
+uint16_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+
+  // Emulating a situation that would need a cleanup function, like freeShortPtr here.
+  uint16_t* shortPtrs[18];
+  for (int i = 0; i < 18; i++) {
+    shortPtrs[i] = malloc(sizeof(uint16_t));
+    *shortPtrs[i] = testVals[i];
+  }
+
+  SplayTree tree = splay_new(sizeof(uint16_t*), cmpShortPtr, freeShortPtr);
+  assert(tree != NULL);
+  assert(splay_get_height(tree) == 0);
+
+  for (int i = 0; i < 18; i++) {
+    splay_add(tree, &shortPtrs[i]);
+    printTree(splay_get_root(tree), 0, 0, printShort);
+    assert(splay_is_valid(tree));
+    assert(**(uint16_t**)splay_node_get_data(splay_get_root(tree)) == testVals[i]);  // last inserted is the root
+    printf("\n------------------\n");
+  }
+
+  splay_add(tree, &shortPtrs[0]);  // adding duplicate should do nothing
+
+  assert(splay_get_size(tree) == 18);
+
+  assert(**(uint16_t**)splay_find_data(tree, &shortPtrs[5]) == 60);
+  assert(splay_find_node(tree, &shortPtrs[5]) == splay_get_root(tree));  // full splay brings it to the root
+
+  for (int i = 0; i < 18; i++) {
+    splay_remove(tree, &shortPtrs[i]);
+    printTree(splay_get_root(tree), 0, 0, printShort);
+    assert(splay_is_valid(tree));
+    printf("\n------------------\n");
+  }
+  splay_delete(tree);
+
+  SplayTree tree2 = splay_new(sizeof(uint16_t), cmpShort, NULL);
+  splay_add(tree2, &testVals[0]);
+  splay_add(tree2, &testVals[1]);
+  splay_add(tree2, &testVals[2]);
+  splay_remove(tree2, &testVals[3]);
+  assert(splay_is_valid(tree2));
+
+  splay_delete(tree2);
+
+  // Sequential inserts build a path, semi-splay reads only shorten it
+  SplayTree semi = splay_new(sizeof(uint16_t), cmpShort, NULL);
+  splay_set_semi_splay(semi, true);
+  for (uint16_t i = 0; i < 1000; i++) {
+    splay_add(semi, &i);
+  }
+  assert(splay_get_height(semi) == 1000);
+  uint16_t deepest = 0;
+  assert(*(uint16_t*)splay_find_data(semi, &deepest) == 0);
+  assert(splay_get_height(semi) <= 501);  // a zig-zig read halves the depth of its search path
+  for (uint16_t i = 0; i < 1000; i += 7) {
+    assert(*(uint16_t*)splay_find_data(semi, &i) == i);
+    assert(splay_is_valid(semi));
+  }
+  uint16_t missing = 1000;
+  assert(splay_find_data(semi, &missing) == NULL);
+  assert(splay_get_size(semi) == 1000);
+  assert(splay_is_valid(semi));
+  splay_delete(semi);
+
+  // Queue-like use, min/max are cached and popped without comparisons
+  SplayTree queue = splay_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(splay_first(queue) == NULL && splay_last(queue) == NULL);
+  for (int i = 0; i < 18; i++) {
+    splay_add(queue, &testVals[i]);
+  }
+  assert(*(uint16_t*)splay_node_get_data(splay_first(queue)) == 4);
+  assert(*(uint16_t*)splay_node_get_data(splay_last(queue)) == 93);
+
+  uint16_t popped, previous = 0;
+  while (splay_pop_min(queue, &popped)) {
+    assert(popped > previous);
+    previous = popped;
+    assert(splay_is_valid(queue));
+    if (splay_get_size(queue) == 9) break;
+  }
+  ok = splay_pop_max(queue, &popped);
+  assert(ok && popped == 93);
+  assert(*(uint16_t*)splay_node_get_data(splay_last(queue)) == 92);
+  while (splay_pop_max(queue, NULL)) {
+    assert(splay_is_valid(queue));
+  }
+  assert(splay_first(queue) == NULL && splay_last(queue) == NULL);
+  splay_delete(queue);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file wavl-tree-test.c
+ *
+ * @author agueguen-LR <adrien.gueguen@etudiant.univ-lr.fr>
+ * @date 2025
+ */
+
+#include "wavl-tree.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void printShort(WAVLNode node) { printf("%d\n", **(uint16_t**)(wavl_node_get_data(node))); }
+
+void printTree(WAVLNode node, int current_depth, int LR, void printfunc(WAVLNode tree)) {
+  if (current_depth > 20) {
+    printf("Houston, we have a problem");
+    return;
+  }
+  assert(LR == 0 || LR == -1 || LR == 1);
+  if (node) {
+    printTree(wavl_node_get_left(node), current_depth + 1, 1, printfunc);
+    for (int i = 0; i < current_depth; i++) {
+      printf("    ");
+    }
+    switch (LR) {
+      case -1:
+        printf("\\");
+        break;
+      case 1:
+        printf("/");
+      default:
+        break;
+    }
+    printfunc(node);
+    printTree(wavl_node_get_right(node), current_depth + 1, -1, printfunc);
+  }
+}
+
+int cmpShortPtr(const void* a, const void* b) {
+  uint16_t int_a = **(uint16_t**)a;
+  uint16_t int_b = **(uint16_t**)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+int cmpShort(const void* a, const void* b) {
+  uint16_t int_a = *(uint16_t*)a;
+  uint16_t int_b = *(uint16_t*)b;
+  if (int_a < int_b) return -1;
+  if (int_a > int_b) return 1;
+  return 0;
+}
+
+void freeShortPtr(void* data) { free(*(uint16_t**)data); }
+
+uint16_t testVals[18] = {10, 85, 15, 70, 20, 60, 30, 50, 65, 80, 90, 91, 92, 93, 9, 8, 7, 4};
+
+int main(void) {
+  // Results of the calls under test, kept out of assert so they still run when NDEBUG is defined
+  bool ok;
+
+  // Emulating a situation that would need a cleanup function, like freeShortPtr here.
+  uint16_t* shortPtrs[18];
+  for (int i = 0; i < 18; i++) {
+    shortPtrs[i] = malloc(sizeof(uint16_t));
+    *shortPtrs[i] = testVals[i];
+  }
+
+  WAVLTree tree = wavl_new(sizeof(uint16_t*), cmpShortPtr, freeShortPtr);
+  assert(tree != NULL);
+  assert(wavl_get_height(tree) == 0);
+
+  for (int i = 0; i < 18; i++) {
+    int error = wavl_add(tree, &shortPtrs[i]);
+    assert(error == 0);
+    printTree(wavl_get_root(tree), 0, 0, printShort);
+    assert(wavl_is_valid(tree));
+    // without removals the tree is an AVL tree, ranks are heights minus one
+    assert(wavl_node_get_rank(wavl_get_root(tree)) == wavl_get_height(tree) - 1);
+    printf("\n------------------\n");
+  }
+
+  wavl_add(tree, &shortPtrs[0]);  // adding duplicate should do nothing
+
+  assert(wavl_get_size(tree) == 18);
+  assert(wavl_get_height(tree) == 5);
+
+  assert(**(uint16_t**)wavl_find_data(tree, &shortPtrs[5]) == 60);
+
+  for (int i = 0; i < 18; i++) {
+    size_t rotations = wavl_get_rotations(tree);
+    wavl_remove(tree, &shortPtrs[i]);
+    assert(wavl_get_rotations(tree) - rotations <= 2);  // one single or double rotation at most
+    printTree(wavl_get_root(tree), 0, 0, printShort);
+    assert(wavl_is_valid(tree));
+    uint16_t* removed = &testVals[i];  // shortPtrs[i] was freed along with its node
+    assert(wavl_find_data(tree, &removed) == NULL);
+    printf("\n------------------\n");
+  }
+  assert(wavl_get_root(tree) == NULL);
+  wavl_delete(tree);
+
+  WAVLTree tree2 = wavl_new(sizeof(uint16_t), cmpShort, NULL);
+  wavl_add(tree2, &testVals[0]);
+  wavl_add(tree2, &testVals[1]);
+  wavl_add(tree2, &testVals[2]);
+  wavl_remove(tree2, &testVals[3]);
+  assert(wavl_is_valid(tree2));
+
+  wavl_delete(tree2);
+
+  // Removals only demote, the rotations of a long mixed sequence stay below one per update
+  WAVLTree mixed = wavl_new(sizeof(uint16_t), cmpShort, NULL);
+  int updates = 0;
+  for (uint16_t i = 0; i < 4096; i++) {
+    uint16_t val = (i * 2557) % 4096;
+    wavl_add(mixed, &val);
+    updates++;
+    if (i % 3 == 2) {
+      uint16_t old = ((i - 2) * 2557) % 4096;
+      wavl_remove(mixed, &old);
+      updates++;
+    }
+  }
+  assert(wavl_is_valid(mixed));
+  assert(wavl_get_size(mixed) == 4096 - 4096 / 3);
+  assert(wavl_get_height(mixed) <= 2 * 12);  // ranks bound the height to 2 * log2(n)
+  assert(wavl_get_rotations(mixed) < (size_t)updates);
+  wavl_delete(mixed);
+
+  // Queue-like use, min/max are cached and popped without comparisons
+  WAVLTree queue = wavl_new(sizeof(uint16_t), cmpShort, NULL);
+  assert(wavl_first(queue) == NULL && wavl_last(queue) == NULL);
+  for (int i = 0; i < 18; i++) {
+    wavl_add(queue, &testVals[i]);
+  }
+  assert(*(uint16_t*)wavl_node_get_data(wavl_first(queue)) == 4);
+  assert(*(uint16_t*)wavl_node_get_data(wavl_last(queue)) == 93);
+
+  uint16_t popped, previous = 0;
+  while (wavl_pop_min(queue, &popped)) {
+    assert(popped > previous);
+    previous = popped;
+    assert(wavl_is_valid(queue));
+    if (wavl_get_size(queue) == 9) break;
+  }
+  ok = wavl_pop_max(queue, &popped);
+  assert(ok && popped == 93);
+  assert(*(uint16_t*)wavl_node_get_data(wavl_last(queue)) == 92);
+  while (wavl_pop_max(queue, NULL)) {
+    assert(wavl_is_valid(queue));
+  }
+  assert(wavl_first(queue) == NULL && wavl_last(queue) == NULL);
+  wavl_delete(queue);
+
+  return EXIT_SUCCESS;
+}